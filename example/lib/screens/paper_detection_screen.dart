@@ -38,11 +38,17 @@ class _PaperDetectionScreenState extends State<PaperDetectionScreen> {
   ui.Image? _overlayImage;
 
   // Corner smoothing - должен быть полем, а не геттером, чтобы сохранять состояние!
+  final CornerFilter _cornerFilter = CornerFilter();
+
+  // Запасной вариант, если в нативной библиотеке нет hg_corner_filter_*
   final CornerSmoother _cornerSmoother = CornerSmoother(
     threshold: 10.0, // Игнорировать изменения меньше 10 пикселей
     smoothingFactor: 0.7, // Больше веса старым значениям для плавности
   );
 
+  // Время кадров для фильтра (кадры пропускаются, частота не постоянна)
+  final Stopwatch _frameClock = Stopwatch()..start();
+
   @override
   void initState() {
     super.initState();
@@ -54,6 +60,7 @@ class _PaperDetectionScreenState extends State<PaperDetectionScreen> {
   void dispose() {
     _cameraController?.dispose();
     _overlayImage?.dispose();
+    _cornerFilter.dispose();
     super.dispose();
   }
 
@@ -130,7 +137,9 @@ class _PaperDetectionScreenState extends State<PaperDetectionScreen> {
       final rawResult = CameraUtils.processCameraFrame(image, config: _defaultConfig, adjustConfigForCamera: true);
 
       // Применяем сглаживание координат
-      final smoothedResult = _cornerSmoother.smooth(rawResult);
+      final smoothedResult = _cornerFilter.isAvailable
+          ? _cornerFilter.smooth(rawResult, timestamp: _frameClock.elapsed)
+          : _cornerSmoother.smooth(rawResult);
 
       if (mounted) {
         setState(() {
@@ -141,8 +150,8 @@ class _PaperDetectionScreenState extends State<PaperDetectionScreen> {
           } else {
             final extracted = CameraUtils.extractGrayscaleFromCameraImage(image);
             _statusMessage = 'No paper detected (${extracted.width}x${extracted.height})';
-            // Сбрасываем сглаживание при потере детекции
-            _cornerSmoother.reset();
+            // CornerFilter сам переживает пропуски; CornerSmoother сбрасываем при потере детекции
+            if (!_cornerFilter.isAvailable) _cornerSmoother.reset();
           }
         });
       }
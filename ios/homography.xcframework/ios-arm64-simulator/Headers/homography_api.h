@@ -49,6 +49,64 @@ extern "C"
         int status;
     } HomographyResult;
 
+    /**
+     * Options for decoding encoded (JPEG/PNG) images
+     */
+    typedef struct
+    {
+        // Maximum width/height of the decoded image in pixels (0 = full resolution)
+        // JPEG images are decoded directly at 1/2, 1/4 or 1/8 scale (DCT-domain
+        // downscaling) and then resized to fit; other formats are resized after
+        // decoding. Returned coordinates are always in original image pixels.
+        int max_dimension; // default: 0
+
+        // How EXIF orientation of JPEG images is handled
+        // 0 = the decoder rotates/flips the pixels (results in displayed orientation)
+        // 1 = pixels are decoded as stored, skipping the full-frame rotation; the
+        //     orientation is applied to the returned corners, center, homography
+        //     and pose instead, so results are still in displayed orientation
+        int defer_orientation; // default: 0
+    } HgDecodeOptions;
+
+    /**
+     * Camera intrinsics for pose estimation of a planar anchor
+     */
+    typedef struct
+    {
+        // Focal length in scene pixels (<= 0 disables pose estimation)
+        float focal_length;
+
+        // Principal point in scene pixels (<= 0 = scene image center)
+        float cx;
+        float cy;
+
+        // Physical width of the anchor, in the unit tvec is returned in
+        // (<= 0 = anchor pixels)
+        float anchor_width;
+
+        // Lens distortion (OpenCV radial-tangential model, all 0 = none)
+        // Only the inlier scene keypoints are undistorted, never the image.
+        float dist_k1;
+        float dist_k2;
+        float dist_p1;
+        float dist_p2;
+        float dist_k3;
+    } HgCameraIntrinsics;
+
+    /**
+     * Camera pose of the anchor plane
+     *
+     * The anchor lies on Z = 0 with its top-left corner at the origin, in
+     * the units of HgCameraIntrinsics.anchor_width. Returned through an
+     * out-parameter so HomographyResult keeps its original layout.
+     */
+    typedef struct
+    {
+        int has_pose;   // 1 if rvec/tvec are valid
+        double rvec[3]; // Rotation vector (Rodrigues)
+        double tvec[3]; // Translation vector
+    } HgPose;
+
     /**
      * Find anchor image on scene image and compute homography
      *
@@ -65,6 +123,71 @@ extern "C"
         const uint8_t *anchor_bytes, size_t anchor_size,
         const uint8_t *scene_bytes, size_t scene_size);
 
+    /**
+     * Find anchor image on scene image with decode options
+     *
+     * @param anchor_bytes  Encoded image bytes of anchor (JPEG/PNG)
+     * @param anchor_size   Size of anchor_bytes in bytes
+     * @param scene_bytes   Encoded image bytes of scene (JPEG/PNG)
+     * @param scene_size    Size of scene_bytes in bytes
+     * @param options       Decode options applied to both images (can be NULL for defaults)
+     * @return HomographyResult with detection results
+     *
+     * Note: Corners, center, scale and homography are expressed in original
+     * (full resolution) anchor and scene pixel coordinates.
+     */
+    FFI_PLUGIN_EXPORT HomographyResult hg_find_homography_ex(
+        const uint8_t *anchor_bytes, size_t anchor_size,
+        const uint8_t *scene_bytes, size_t scene_size,
+        const HgDecodeOptions *options);
+
+    /**
+     * Find anchor image on scene image and estimate the camera pose
+     *
+     * @param anchor_bytes  Encoded image bytes of anchor (JPEG/PNG)
+     * @param anchor_size   Size of anchor_bytes in bytes
+     * @param scene_bytes   Encoded image bytes of scene (JPEG/PNG)
+     * @param scene_size    Size of scene_bytes in bytes
+     * @param options       Decode options applied to both images (can be NULL for defaults)
+     * @param intrinsics    Camera intrinsics of the original scene image (can be NULL: no pose)
+     * @param out_pose      Receives the pose (can be NULL: no pose); has_pose is 0 when
+     *                      no pose could be solved
+     * @return HomographyResult with detection results
+     *
+     * Note: The pose is solved with IPPE from the RANSAC inlier matches, not
+     * just the four corners. Intrinsics refer to the original (displayed)
+     * scene image, so decode downscaling and orientation do not affect it.
+     */
+    FFI_PLUGIN_EXPORT HomographyResult hg_find_homography_pose(
+        const uint8_t *anchor_bytes, size_t anchor_size,
+        const uint8_t *scene_bytes, size_t scene_size,
+        const HgDecodeOptions *options,
+        const HgCameraIntrinsics *intrinsics,
+        HgPose *out_pose);
+
+    /**
+     * Find anchor image on scene image, reading both from files
+     *
+     * @param anchor_path  Path of the encoded anchor image (JPEG/PNG)
+     * @param scene_path   Path of the encoded scene image (JPEG/PNG)
+     * @param options      Decode options applied to both images (can be NULL for defaults)
+     * @return HomographyResult with detection results
+     *
+     * Note: Files are memory-mapped read-only and decoded from the mapping,
+     * so the encoded bytes are never copied into the heap. A file that cannot
+     * be opened is reported like a decode failure (-2 anchor, -3 scene).
+     */
+    FFI_PLUGIN_EXPORT HomographyResult hg_find_homography_file(
+        const char *anchor_path, const char *scene_path,
+        const HgDecodeOptions *options);
+
+    /**
+     * Initialize default decode options (full resolution)
+     *
+     * @return Default decode options
+     */
+    FFI_PLUGIN_EXPORT HgDecodeOptions hg_default_decode_options(void);
+
     /**
      * Find anchor image on scene image (raw pixel data version)
      *
@@ -82,6 +205,18 @@ extern "C"
         const uint8_t *anchor_data, int anchor_width, int anchor_height, int anchor_channels,
         const uint8_t *scene_data, int scene_width, int scene_height, int scene_channels);
 
+    /**
+     * Find anchor image on scene image and estimate the camera pose (raw pixel data version)
+     *
+     * As hg_find_homography_raw, plus IPPE pose from the RANSAC inliers when
+     * intrinsics and out_pose are not NULL (see hg_find_homography_pose).
+     */
+    FFI_PLUGIN_EXPORT HomographyResult hg_find_homography_raw_pose(
+        const uint8_t *anchor_data, int anchor_width, int anchor_height, int anchor_channels,
+        const uint8_t *scene_data, int scene_width, int scene_height, int scene_channels,
+        const HgCameraIntrinsics *intrinsics,
+        HgPose *out_pose);
+
     /**
      * Compute homography from matched point pairs (from external matcher like LightGlue)
      *
@@ -102,6 +237,22 @@ extern "C"
         int num_points,
         int anchor_width, int anchor_height);
 
+    /**
+     * Compute homography and camera pose from matched point pairs
+     *
+     * As hg_find_homography_from_points, plus IPPE pose from the RANSAC
+     * inliers when intrinsics and out_pose are not NULL (see hg_find_homography_pose).
+     * The scene size is unknown here, so intrinsics must include cx and cy;
+     * otherwise no pose is returned.
+     */
+    FFI_PLUGIN_EXPORT HomographyResult hg_find_homography_from_points_pose(
+        const float *pts0_x, const float *pts0_y,
+        const float *pts1_x, const float *pts1_y,
+        int num_points,
+        int anchor_width, int anchor_height,
+        const HgCameraIntrinsics *intrinsics,
+        HgPose *out_pose);
+
     /**
      * Get library version string
      * @return Version string (e.g., "1.0.0")
@@ -150,6 +301,21 @@ extern "C"
         int status;
     } PaperDetectionResult;
 
+    // Edge extraction methods (PaperDetectionConfig.edge_method)
+#define HG_EDGE_OPENCV 0   // GaussianBlur, Canny and dilate as separate passes
+#define HG_EDGE_FUSED 1    // Single fused pass (NEON/AVX2), one output image
+#define HG_EDGE_PARALLEL 2 // Fused pass on parallel strips, union-find hysteresis
+
+    // Quad extraction methods (PaperDetectionConfig.quad_method)
+#define HG_QUAD_CONTOURS 0 // External contours approximated to 4-gons
+#define HG_QUAD_SEGMENTS 1 // Hough segments merged into lines, quads from line intersections
+#define HG_QUAD_TRACED 2   // External contours from a built-in tracer that skips small blobs
+
+    // Pose estimation methods (PaperDetectionConfig.pose_method)
+#define HG_POSE_ITERATIVE 0  // solvePnP Levenberg-Marquardt refinement
+#define HG_POSE_IPPE 1       // solvePnP SOLVEPNP_IPPE, closed-form planar pose
+#define HG_POSE_HOMOGRAPHY 2 // Decomposition of the paper homography with the intrinsics
+
     /**
      * Configuration for paper detection
      */
@@ -183,6 +349,59 @@ extern "C"
         float focal_length; // focal length in pixels
         float cx;           // principal point x
         float cy;           // principal point y
+
+        // Streaming mode for very large images (0 = disabled)
+        // Blur, Canny and dilate run on horizontal bands of this many rows (plus
+        // halo rows), contours are extracted from an edge map downscaled by
+        // stream_edge_downscale, and the corners are then snapped to the full
+        // resolution edges. Memory beyond the input frame is proportional to
+        // the band size.
+        int stream_band_rows;      // default: 0 (e.g. 256 for 48 MP scans)
+        int stream_edge_downscale; // default: 2 (1, 2 or 4)
+
+        // Coarse-to-fine detection (0 = disabled)
+        // Contours are searched on a copy downscaled to this many pixels on the
+        // longer side, then the corners are snapped to the edges of the full
+        // resolution image. Ignored in streaming mode.
+        int coarse_max_dimension; // default: 0 (e.g. 480 for 1080p/4K frames)
+
+        // Edge extraction method (HG_EDGE_*)
+        int edge_method; // default: HG_EDGE_OPENCV
+
+        // Quad extraction method (HG_QUAD_*)
+        // HG_QUAD_SEGMENTS skips contour tracing and polygon approximation, and
+        // finds papers whose border is partially occluded or broken by clutter.
+        // HG_QUAD_TRACED finds the same quads as HG_QUAD_CONTOURS but rejects
+        // blobs by bounding box before tracing them (textured backgrounds).
+        int quad_method; // default: HG_QUAD_CONTOURS
+
+        // Canny threshold hypotheses (1 = only canny_threshold1/2)
+        // Pair k uses both thresholds scaled by canny_hypothesis_scale^k, and the
+        // best-scoring quad over all pairs is returned, which finds low-contrast
+        // paper without retrying. Gradients are computed once with the fused
+        // kernels (whatever edge_method); the pairs then run concurrently.
+        // Ignored in streaming mode.
+        int canny_hypotheses;         // default: 1 (e.g. 3, at most 8)
+        float canny_hypothesis_scale; // default: 0.5
+
+        // Pose estimation method (HG_POSE_*), used when focal_length > 0
+        // HG_POSE_IPPE and HG_POSE_HOMOGRAPHY are closed-form and several times
+        // cheaper than the iterative solver; HG_POSE_HOMOGRAPHY reuses the
+        // homography that is computed anyway (recomputed from the undistorted
+        // corners when there is lens distortion).
+        int pose_method; // default: HG_POSE_ITERATIVE
+
+        // Lens distortion (OpenCV radial-tangential model), used when
+        // focal_length > 0
+        // Corners are reported in image pixels; only the four corners are
+        // undistorted for pose estimation, and the snap tracker samples edges
+        // through a coarse distortion map built once per frame size of a
+        // snap-tracking session, so frames are never remapped.
+        float dist_k1; // default: 0
+        float dist_k2; // default: 0
+        float dist_p1; // default: 0
+        float dist_p2; // default: 0
+        float dist_k3; // default: 0
     } PaperDetectionConfig;
 
     /**
@@ -203,6 +422,29 @@ extern "C"
         const uint8_t *image_data, int image_width, int image_height, int image_channels,
         const PaperDetectionConfig *config);
 
+    /**
+     * Detect several papers/documents in one image
+     *
+     * @param image_data      Raw pixel data (grayscale, RGB, or RGBA)
+     * @param image_width     Width of image
+     * @param image_height    Height of image
+     * @param image_channels  Number of channels (1, 3, or 4)
+     * @param config          Detection configuration (can be NULL for defaults)
+     * @param results         Output array of max_results entries
+     * @param max_results     Capacity of results
+     * @return Number of papers written to results (0..max_results), -1 on invalid input
+     *
+     * Note: Edges and contours are extracted once and every quad passing the
+     * paper filters is scored; the best ones are kept in descending score
+     * order, skipping quads that overlap an already kept one. Each result is
+     * filled as by hg_detect_paper (corners, homography, optional pose).
+     * Streaming mode is ignored: the whole frame is searched at once.
+     */
+    FFI_PLUGIN_EXPORT int hg_detect_papers(
+        const uint8_t *image_data, int image_width, int image_height, int image_channels,
+        const PaperDetectionConfig *config,
+        PaperDetectionResult *results, int max_results);
+
     /**
      * Detect paper/document in encoded image (JPEG/PNG)
      *
@@ -215,6 +457,39 @@ extern "C"
         const uint8_t *image_bytes, size_t image_size,
         const PaperDetectionConfig *config);
 
+    /**
+     * Detect paper/document in encoded image (JPEG/PNG) with decode options
+     *
+     * @param image_bytes     Encoded image bytes
+     * @param image_size      Size of image_bytes
+     * @param config          Detection configuration (can be NULL for defaults)
+     * @param options         Decode options (can be NULL for defaults)
+     * @return PaperDetectionResult with detection results
+     *
+     * Note: Corners, center, area, perimeter and homography are expressed in
+     * original image pixels, and camera intrinsics in config refer to the
+     * original image, so the pose is unaffected by decode downscaling.
+     */
+    FFI_PLUGIN_EXPORT PaperDetectionResult hg_detect_paper_encoded_ex(
+        const uint8_t *image_bytes, size_t image_size,
+        const PaperDetectionConfig *config,
+        const HgDecodeOptions *options);
+
+    /**
+     * Detect paper/document in an encoded image file (JPEG/PNG)
+     *
+     * @param image_path      Path of the encoded image
+     * @param config          Detection configuration (can be NULL for defaults)
+     * @param options         Decode options (can be NULL for defaults)
+     * @return PaperDetectionResult with detection results
+     *
+     * Note: The file is memory-mapped read-only and decoded from the mapping.
+     */
+    FFI_PLUGIN_EXPORT PaperDetectionResult hg_detect_paper_file(
+        const char *image_path,
+        const PaperDetectionConfig *config,
+        const HgDecodeOptions *options);
+
     /**
      * Initialize default paper detection configuration
      *
@@ -222,6 +497,616 @@ extern "C"
      */
     FFI_PLUGIN_EXPORT PaperDetectionConfig hg_default_paper_config(void);
 
+    // ============================================================================
+    // Corner Filter API (temporal smoothing of detected corners)
+    // ============================================================================
+
+    /**
+     * Opaque corner filter session
+     *
+     * One-Euro filter over the four corners of a tracked quad (paper or
+     * homography corners). The filtered velocity is kept as well, so the
+     * session can predict where the quad will be in the next frame.
+     * A session must not be used from several threads at once.
+     */
+    typedef struct HgCornerFilter HgCornerFilter;
+
+    /**
+     * Configuration for the corner filter
+     */
+    typedef struct
+    {
+        // Cutoff frequency at rest (Hz); lower = less jitter, more lag
+        float min_cutoff; // default: 1.0
+
+        // Cutoff increase per pixel/second of corner speed; higher = less lag
+        // while moving
+        float beta; // default: 0.01
+
+        // Cutoff frequency of the velocity estimate (Hz)
+        float derivative_cutoff; // default: 1.0
+
+        // Frame rate assumed when updates carry no timestamp
+        float frame_rate; // default: 30
+
+        // Frames without a measurement before the state is dropped
+        int max_missed_frames; // default: 3
+
+        // Margin added on each side of the predicted quad's bounding box, as
+        // a fraction of its larger side
+        float roi_margin; // default: 0.15
+    } HgCornerFilterConfig;
+
+    /**
+     * Initialize default corner filter configuration
+     *
+     * @return Default corner filter configuration
+     */
+    FFI_PLUGIN_EXPORT HgCornerFilterConfig hg_default_corner_filter_config(void);
+
+    /**
+     * Create a corner filter session
+     *
+     * @param config  Filter configuration (can be NULL for defaults), copied
+     * @return New session, or NULL on allocation failure; free with hg_corner_filter_destroy
+     */
+    FFI_PLUGIN_EXPORT HgCornerFilter *hg_corner_filter_create(const HgCornerFilterConfig *config);
+
+    /**
+     * Destroy a corner filter session (NULL is ignored)
+     */
+    FFI_PLUGIN_EXPORT void hg_corner_filter_destroy(HgCornerFilter *filter);
+
+    /**
+     * Drop the filter state; the next measurement is passed through unchanged
+     */
+    FFI_PLUGIN_EXPORT void hg_corner_filter_reset(HgCornerFilter *filter);
+
+    /**
+     * Feed the corners measured in the next frame
+     *
+     * @param filter       Filter session
+     * @param corners      Measured corners [x0,y0, ..., x3,y3], or NULL if the
+     *                     quad was not found in this frame
+     * @param homography   Optional 3x3 row-major homography (in/out, can be NULL)
+     *                     that maps some source points onto the measured corners;
+     *                     it is re-fitted to map them onto the filtered corners
+     * @param timestamp    Frame time in seconds (<= 0 = assume config.frame_rate)
+     * @param out_corners  Filtered corners [x0,y0, ..., x3,y3]
+     * @return 1 if out_corners was written, 0 for a missed frame, -1 on invalid input
+     *
+     * Note: Corners must keep a consistent order between frames (all results
+     * of this library are clockwise from top-left).
+     */
+    FFI_PLUGIN_EXPORT int hg_corner_filter_update(
+        HgCornerFilter *filter,
+        const float *corners,
+        double *homography,
+        double timestamp,
+        float *out_corners);
+
+    /**
+     * Predict the quad at a future frame from the filtered position and velocity
+     *
+     * @param filter       Filter session
+     * @param timestamp    Frame time in seconds (<= 0 = one frame after the last update)
+     * @param out_corners  Predicted corners [x0,y0, ..., x3,y3] (can be NULL)
+     * @param out_roi      Search region [x, y, width, height] around the predicted
+     *                     quad, expanded by config.roi_margin (can be NULL)
+     * @return 1 if a prediction was written, 0 if nothing is being tracked
+     */
+    FFI_PLUGIN_EXPORT int hg_corner_filter_predict(
+        HgCornerFilter *filter,
+        double timestamp,
+        float *out_corners,
+        float *out_roi);
+
+    // ============================================================================
+    // Paper Tracking API (live capture sessions)
+    // ============================================================================
+
+    /**
+     * Opaque paper tracking session
+     *
+     * Holds the quad found in the previous frame so the next frame only needs
+     * to search around it. A session must not be used from several threads
+     * at once.
+     */
+    typedef struct HgPaperTracker HgPaperTracker;
+
+    /**
+     * Configuration for paper tracking
+     */
+    typedef struct
+    {
+        // Margin added on each side of the previous quad's bounding box, as a
+        // fraction of its larger side; only this region is searched between
+        // full scans
+        float roi_margin; // default: 0.15
+
+        // Search the whole frame every N frames to catch re-entry and
+        // documents growing out of the region (1 = always whole frame)
+        int full_scan_interval; // default: 15
+
+        // Edge-snapping tracking (0 = disabled)
+        // Before any edge detection, the previous quad's sides are snapped to
+        // the strongest intensity edges within snap_search_radius pixels and
+        // the corners are re-intersected. The snapped quad is accepted when
+        // every side has enough edge support and a small line-fit residual;
+        // otherwise the frame falls back to region/full detection.
+        int snap_tracking;          // default: 0
+        float snap_search_radius;   // default: 12 (pixels)
+        float snap_min_support;     // default: 0.6 (fraction of profiles with an edge)
+        float snap_max_residual;    // default: 1.5 (pixels, RMS)
+
+        // Temporal corner filtering (0 = disabled)
+        // Returned corners, center, homography and pose come from a One-Euro
+        // filtered quad, and the region searched in the next frame is centred
+        // on the filter's prediction instead of the last position. Frame times
+        // come from hg_paper_tracker_update_at, or filter_frame_rate without
+        // them. Frames without a quad coast on the filter like
+        // hg_corner_filter_update (up to 3); other filter settings are defaults.
+        int filter_corners;      // default: 0
+        float filter_min_cutoff; // default: 1.0 (Hz)
+        float filter_beta;       // default: 0.01
+        float filter_frame_rate; // default: 30 (frames/second without timestamps)
+
+        // Start the pose solver from the previous frame's pose (0 = disabled)
+        // With HG_POSE_ITERATIVE, solvePnP is seeded with the last rvec/tvec
+        // (useExtrinsicGuess) and converges in a few iterations. The pose is
+        // solved once per frame, for the returned (possibly filtered) quad.
+        int seed_pose; // default: 1
+    } HgTrackerConfig;
+
+    /**
+     * Initialize default tracking configuration
+     *
+     * @return Default tracking configuration
+     */
+    FFI_PLUGIN_EXPORT HgTrackerConfig hg_default_tracker_config(void);
+
+    /**
+     * Create a paper tracking session
+     *
+     * @param config          Detection configuration (can be NULL for defaults), copied
+     * @param tracker_config  Tracking configuration (can be NULL for defaults), copied
+     * @return New session, or NULL on allocation failure; free with hg_paper_tracker_destroy
+     */
+    FFI_PLUGIN_EXPORT HgPaperTracker *hg_paper_tracker_create(
+        const PaperDetectionConfig *config,
+        const HgTrackerConfig *tracker_config);
+
+    /**
+     * Destroy a paper tracking session (NULL is ignored)
+     */
+    FFI_PLUGIN_EXPORT void hg_paper_tracker_destroy(HgPaperTracker *tracker);
+
+    /**
+     * Forget the tracked quad; the next update searches the whole frame
+     */
+    FFI_PLUGIN_EXPORT void hg_paper_tracker_reset(HgPaperTracker *tracker);
+
+    /**
+     * Detect paper in the next frame of a live sequence
+     *
+     * @param tracker         Tracking session
+     * @param image_data      Raw pixel data (RGB, RGBA, or grayscale)
+     * @param image_width     Image width
+     * @param image_height    Image height
+     * @param image_channels  Number of channels (1, 3, or 4)
+     * @return PaperDetectionResult in frame coordinates (as hg_detect_paper)
+     *
+     * Note: While a quad is tracked, it is first snapped to the new frame's
+     * edges (if snap_tracking is set), then searched for in the region around
+     * it; if nothing is found there, the whole frame is searched in the same call.
+     * With filter_corners set, the quad's predicted position is used as the
+     * starting point and the filtered quad is returned.
+     * Tracker calls are not recorded by hg_capture_start.
+     */
+    FFI_PLUGIN_EXPORT PaperDetectionResult hg_paper_tracker_update(
+        HgPaperTracker *tracker,
+        const uint8_t *image_data, int image_width, int image_height, int image_channels);
+
+    /**
+     * Detect paper in the next frame of a live sequence, with its capture time
+     *
+     * As hg_paper_tracker_update; timestamp is the frame time in seconds
+     * (<= 0 = assume tracker_config.filter_frame_rate). With filter_corners
+     * set, prediction and smoothing use the real time between frames, so
+     * dropped frames do not read as a sudden jump.
+     */
+    FFI_PLUGIN_EXPORT PaperDetectionResult hg_paper_tracker_update_at(
+        HgPaperTracker *tracker,
+        const uint8_t *image_data, int image_width, int image_height, int image_channels,
+        double timestamp);
+
+    // ============================================================================
+    // Paper Rectification API
+    // ============================================================================
+
+    /**
+     * Warp a detected paper to a flat, fronto-parallel image
+     *
+     * @param image_data      Source frame (RGB, RGBA, or grayscale; any channel order)
+     * @param image_width     Image width (at least 2)
+     * @param image_height    Image height (at least 2)
+     * @param image_channels  Number of channels (1, 3, or 4)
+     * @param corners         Paper corners x0,y0..x3,y3 in frame pixels, clockwise
+     *                        from top-left (PaperDetectionResult.corners)
+     * @param out_width       Output width
+     * @param out_height      Output height
+     * @param out_data        Caller buffer of out_width * out_height * image_channels
+     *                        bytes, receives the rectified page (same channels as the source)
+     * @return 1 on success, -1 on invalid input (including a non-convex corner quad)
+     *
+     * Note: The output rectangle's outer edges map onto the corners. Samples are
+     * bilinear with 7-bit fixed-point weights, computed in parallel over 64x64
+     * output tiles; parts of the quad outside the frame repeat the edge pixels.
+     * Rectification calls are not recorded by hg_capture_start.
+     */
+    FFI_PLUGIN_EXPORT int hg_rectify_paper(
+        const uint8_t *image_data, int image_width, int image_height, int image_channels,
+        const float *corners,
+        int out_width, int out_height,
+        uint8_t *out_data);
+
+    /**
+     * Opaque rectification session for live preview
+     *
+     * Keeps the fixed-point remap tables of the last frames (6 bytes per output
+     * pixel) so that a page that barely moves is re-warped without recomputing
+     * them. A session must not be used from several threads at once.
+     */
+    typedef struct HgRectifier HgRectifier;
+
+    /**
+     * Configuration for a rectification session
+     */
+    typedef struct
+    {
+        // Tables of a 64x64 output tile are reused while the new homography
+        // samples within this many source pixels of the one they were built
+        // with; other tiles are rebuilt (a page moving at one end only
+        // rebuilds the tiles near it). 0 = rebuild unless the corners are
+        // unchanged.
+        float reuse_tolerance; // default: 0.25 (pixels)
+    } HgRectifierConfig;
+
+    /**
+     * Initialize default rectification configuration
+     *
+     * @return Default rectification configuration
+     */
+    FFI_PLUGIN_EXPORT HgRectifierConfig hg_default_rectifier_config(void);
+
+    /**
+     * Create a rectification session
+     *
+     * @param config  Configuration (can be NULL for defaults), copied
+     * @return New session, or NULL on allocation failure; free with hg_rectifier_destroy
+     */
+    FFI_PLUGIN_EXPORT HgRectifier *hg_rectifier_create(const HgRectifierConfig *config);
+
+    /**
+     * Destroy a rectification session (NULL is ignored)
+     */
+    FFI_PLUGIN_EXPORT void hg_rectifier_destroy(HgRectifier *rectifier);
+
+    /**
+     * Drop the cached tables; the next call rebuilds every tile
+     */
+    FFI_PLUGIN_EXPORT void hg_rectifier_reset(HgRectifier *rectifier);
+
+    /**
+     * Warp a paper in the next frame of a live sequence (as hg_rectify_paper)
+     *
+     * @param rectifier  Rectification session
+     * @return 1 on success, -1 on invalid input
+     *
+     * Note: Output matches hg_rectify_paper up to reuse_tolerance. A change of
+     * frame size, row layout, channels or output size rebuilds every tile.
+     */
+    FFI_PLUGIN_EXPORT int hg_rectifier_rectify(
+        HgRectifier *rectifier,
+        const uint8_t *image_data, int image_width, int image_height, int image_channels,
+        const float *corners,
+        int out_width, int out_height,
+        uint8_t *out_data);
+
+    // Output formats (HgEncodeOptions.format)
+#define HG_ENCODE_JPEG 0
+#define HG_ENCODE_PNG 1
+
+    /**
+     * Options for encoding a rectified page
+     */
+    typedef struct
+    {
+        // Output format (HG_ENCODE_*)
+        int format; // default: HG_ENCODE_JPEG
+
+        // JPEG quality 1-100 (ignored for PNG, which is lossless)
+        int quality; // default: 90
+
+        // Downscale (area averaging) so that the longer side is at most this
+        // many pixels (0 = keep out_width x out_height)
+        int max_dimension; // default: 0
+
+        // Encode a single gray channel (0 = keep the source channels)
+        int grayscale; // default: 0
+
+        // Black and white output for text (implies grayscale)
+        // Adaptive mean threshold over a window of 1/40 of the longer side;
+        // PNG output is then written as 1 bit per pixel.
+        int binarize; // default: 0
+    } HgEncodeOptions;
+
+    /**
+     * Growable output buffer for encoded images, owned by the library
+     *
+     * Keeps its capacity and pixel scratch between calls, so repeated exports
+     * of same-sized pages allocate nothing. A buffer must not be used from
+     * several threads at once.
+     */
+    typedef struct HgImageBuffer HgImageBuffer;
+
+    /**
+     * Encoded image stored in an HgImageBuffer
+     */
+    typedef struct
+    {
+        // Encoded bytes, valid until the buffer is used again or destroyed
+        const uint8_t *data;
+        size_t size;
+
+        // Size of the encoded image (after max_dimension)
+        int width;
+        int height;
+
+        // Status:
+        //   1 = success
+        //  -1 = invalid input
+        //  -2 = encoding failed
+        int status;
+    } HgEncodedImage;
+
+    /**
+     * Initialize default encoding options
+     *
+     * @return Default encoding options
+     */
+    FFI_PLUGIN_EXPORT HgEncodeOptions hg_default_encode_options(void);
+
+    /**
+     * Create an empty output buffer
+     *
+     * @return New buffer, or NULL on allocation failure; free with hg_image_buffer_destroy
+     */
+    FFI_PLUGIN_EXPORT HgImageBuffer *hg_image_buffer_create(void);
+
+    /**
+     * Destroy an output buffer (NULL is ignored)
+     */
+    FFI_PLUGIN_EXPORT void hg_image_buffer_destroy(HgImageBuffer *buffer);
+
+    /**
+     * Warp a detected paper to a flat image and encode it as JPEG or PNG
+     *
+     * @param buffer   Output buffer receiving the encoded bytes
+     * @param options  Encoding options (can be NULL for defaults)
+     * Other parameters as in hg_rectify_paper (RGB/RGBA channel order).
+     * @return HgEncodedImage pointing into buffer
+     *
+     * Note: Warping, color conversion, downscaling, binarization and encoding
+     * run in one call, so only the encoded bytes cross the FFI boundary.
+     * Alpha is dropped for JPEG.
+     */
+    FFI_PLUGIN_EXPORT HgEncodedImage hg_rectify_paper_encoded(
+        HgImageBuffer *buffer,
+        const uint8_t *image_data, int image_width, int image_height, int image_channels,
+        const float *corners,
+        int out_width, int out_height,
+        const HgEncodeOptions *options);
+
+    // ============================================================================
+    // Point Transform API (batched homography mapping)
+    // ============================================================================
+
+    // Point array layouts
+#define HG_POINTS_INTERLEAVED 0 // x0,y0,x1,y1,...
+#define HG_POINTS_SOA 1         // x0..xn-1 followed by y0..yn-1
+
+    /**
+     * Map points through a homography
+     *
+     * @param homography  3x3 matrix, row-major (HomographyResult.homography)
+     * @param in_xy       Input points, 2 * n floats in the given layout
+     * @param out_xy      Output points, 2 * n floats in the same layout; may equal in_xy
+     * @param n           Number of points (0 is allowed)
+     * @param layout      HG_POINTS_INTERLEAVED or HG_POINTS_SOA
+     * @return 1 on success, -1 on invalid input
+     *
+     * Note: Vectorized with NEON/AVX2 in single precision. Points mapped to
+     * infinity (w = 0) come out non-finite. Point transforms are not recorded
+     * by hg_capture_start.
+     */
+    FFI_PLUGIN_EXPORT int hg_transform_points(
+        const double *homography,
+        const float *in_xy, float *out_xy,
+        int n, int layout);
+
+    /**
+     * Map points through the inverse of a homography
+     *
+     * Parameters as in hg_transform_points.
+     * @return 1 on success, -1 on invalid input or a singular homography
+     */
+    FFI_PLUGIN_EXPORT int hg_transform_points_inverse(
+        const double *homography,
+        const float *in_xy, float *out_xy,
+        int n, int layout);
+
+    /**
+     * Exact projective 4x4 matrix mapping one quad onto another
+     *
+     * @param src_corners  Source quad x0,y0..x3,y3
+     * @param dst_corners  Destination quad x0,y0..x3,y3 (same corner order)
+     * @param out_matrix4  Receives 16 doubles, column-major (Flutter Matrix4 storage)
+     * @return 1 on success, -1 on invalid input or a degenerate quad
+     *
+     * Note: The 3x3 homography is embedded with z passed through, so a widget
+     * transformed by the matrix lands exactly on the destination quad.
+     */
+    FFI_PLUGIN_EXPORT int hg_perspective_matrix4(
+        const float *src_corners, const float *dst_corners,
+        double *out_matrix4);
+
+    // ============================================================================
+    // Instrumentation API (per-call stage timings and hardware counters)
+    // ============================================================================
+
+    // Maximum number of pipeline stages recorded per call
+#define HG_MAX_STAGES 16
+
+    // Bits of HgCallStats.counters_mask
+#define HG_COUNTER_CYCLES (1 << 0)
+#define HG_COUNTER_INSTRUCTIONS (1 << 1)
+#define HG_COUNTER_L1D_MISSES (1 << 2)
+#define HG_COUNTER_LLC_MISSES (1 << 3)
+#define HG_COUNTER_BRANCH_MISSES (1 << 4)
+#define HG_COUNTER_ALLOCATIONS (1 << 5) // alloc_count/alloc_bytes/peak_bytes are valid
+
+    /**
+     * Timing and hardware counters of a single pipeline stage
+     */
+    typedef struct
+    {
+        // Stage name (e.g. "orb", "match", "ransac", "canny", "contours")
+        char name[16];
+
+        // Wall time in milliseconds
+        double wall_ms;
+
+        // Hardware counters (valid only if the matching bit is set in counters_mask)
+        uint64_t cycles;
+        uint64_t instructions;
+        uint64_t l1d_misses;    // L1 data cache read misses
+        uint64_t llc_misses;    // Last level cache misses
+        uint64_t branch_misses; // Mispredicted branches
+    } HgStageStats;
+
+    /**
+     * Statistics of the last API call made on the calling thread
+     */
+    typedef struct
+    {
+        // Number of valid entries in stages
+        int num_stages;
+
+        // Stages begun after stages was full (timed into the total only)
+        int dropped_stages;
+
+        // HG_COUNTER_* bits of counters that were read (0 if disabled/unavailable)
+        int counters_mask;
+
+        // Wall time of the whole call in milliseconds
+        double total_ms;
+
+        // Heap allocations made during the call (see hg_set_alloc_tracking_enabled)
+        uint64_t alloc_count; // Number of allocations
+        uint64_t alloc_bytes; // Total bytes allocated
+        uint64_t peak_bytes;  // Peak live bytes of the calling thread above the level at call start
+
+        HgStageStats stages[HG_MAX_STAGES];
+    } HgCallStats;
+
+    /**
+     * Enable or disable hardware performance counters (Linux/Android only)
+     *
+     * @param enabled  Non-zero to read perf_event_open counters around each stage
+     * @return 1 if counters are supported on this platform, 0 otherwise
+     *
+     * Note: Counters are disabled by default. Stage wall times are always recorded.
+     * Counters cover the calling thread only; work dispatched to OpenCV's thread
+     * pool is not included (use cv::setNumThreads(0) when profiling).
+     */
+    FFI_PLUGIN_EXPORT int hg_set_perf_counters_enabled(int enabled);
+
+    /**
+     * Get statistics of the last hg_find_homography* / hg_detect_paper* call
+     * made on the calling thread
+     *
+     * @param out_stats  Output statistics
+     * @return 1 on success, 0 if no call was recorded yet, -1 if out_stats is NULL
+     */
+    FFI_PLUGIN_EXPORT int hg_get_last_call_stats(HgCallStats *out_stats);
+
+    /**
+     * Enable or disable per-call allocation tracking
+     *
+     * @param enabled  Non-zero to count allocations into HgCallStats
+     * @return 1 if all library heap allocations are tracked, 0 if only OpenCV
+     *         matrix buffers are (library built without HG_ENABLE_ALLOC_TRACKING)
+     *
+     * Note: OpenCV matrix buffers are counted through a cv::MatAllocator installed
+     * as the default allocator while tracking is enabled. Building with
+     * HG_ENABLE_ALLOC_TRACKING additionally replaces global operator new/delete
+     * to count std::vector and other C++ allocations (instrumentation builds only).
+     * alloc_count/alloc_bytes are process-wide, so concurrent calls are attributed
+     * to each other; peak_bytes follows the calling thread only.
+     */
+    FFI_PLUGIN_EXPORT int hg_set_alloc_tracking_enabled(int enabled);
+
+    // ============================================================================
+    // Capture API (record call inputs for deterministic replay)
+    // ============================================================================
+
+    // Capture log file magic and format version
+#define HG_CAPTURE_MAGIC "HGCAPLOG"
+#define HG_CAPTURE_VERSION 14
+
+    // Size cap used when hg_capture_start is called with max_bytes == 0
+#define HG_CAPTURE_DEFAULT_MAX_BYTES (256u * 1024u * 1024u)
+
+    /**
+     * Call types stored in capture log records
+     */
+    typedef enum
+    {
+        HG_CALL_FIND_HOMOGRAPHY = 1,
+        HG_CALL_FIND_HOMOGRAPHY_RAW = 2,
+        HG_CALL_FIND_HOMOGRAPHY_FROM_POINTS = 3,
+        HG_CALL_DETECT_PAPER = 4,
+        HG_CALL_DETECT_PAPER_ENCODED = 5,
+        HG_CALL_DETECT_PAPERS = 6,
+    } HgCallType;
+
+    /**
+     * Start capturing every API call to a binary log
+     *
+     * @param path       Output file path (truncated if it exists)
+     * @param max_bytes  Size cap of the log; records that would exceed it are dropped
+     *                   (0 = HG_CAPTURE_DEFAULT_MAX_BYTES)
+     * @return 1 on success, -1 if the file cannot be opened
+     *
+     * Log layout (native endianness):
+     *   header: char magic[8], uint32_t version
+     *   record: uint32_t record_size (bytes following this field),
+     *           uint32_t call_type (HgCallType), HgCallStats stats,
+     *           uint32_t fields_size, fields, blobs
+     * Fields hold the scalar arguments (and PaperDetectionConfig/HgDecodeOptions/
+     * HgCameraIntrinsics, each preceded by an int32_t presence flag); blobs hold
+     * pixel buffers, encoded bytes or point arrays in argument order.
+     * No RNG state is stored: the RANSAC of cv::findHomography seeds its own
+     * generator, so a replayed call is already deterministic.
+     */
+    FFI_PLUGIN_EXPORT int hg_capture_start(const char *path, size_t max_bytes);
+
+    /**
+     * Stop capturing and close the log
+     */
+    FFI_PLUGIN_EXPORT void hg_capture_stop(void);
+
 #ifdef __cplusplus
 }
 #endif
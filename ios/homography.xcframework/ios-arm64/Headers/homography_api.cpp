@@ -1,8 +1,40 @@
 #include "homography_api.h"
 #include <vector>
 #include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <new>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <cstdio>
 #include <algorithm>
 
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HG_SIMD_NEON 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define HG_SIMD_AVX2 1
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#define HG_HAVE_PERF_EVENTS 1
+#endif
+
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
@@ -20,810 +52,5575 @@ static const float RATIO_THRESH = 0.75f;
 // RANSAC reprojection threshold
 static const double RANSAC_THRESH = 5.0;
 
-/**
- * Internal function to compute homography from two grayscale images
- */
-static HomographyResult compute_homography_internal(
-    const cv::Mat &anchor_gray,
-    const cv::Mat &scene_gray)
-{
-    HomographyResult result = {};
+// Extra halo rows per band in streaming paper detection (Sobel, NMS, dilate
+// and slack for hysteresis), on top of the blur radius
+static const int STREAM_HALO_ROWS = 16;
 
-    // Create ORB detector (fast, free, works well on mobile)
-    auto detector = cv::ORB::create(
-        1000, // nfeatures - max number of features
-        1.2f, // scaleFactor
-        8,    // nlevels
-        31,   // edgeThreshold
-        0,    // firstLevel
-        2,    // WTA_K
-        cv::ORB::HARRIS_SCORE,
-        31, // patchSize
-        20  // fastThreshold
-    );
+// Minimum intensity step (central difference) accepted as an edge when
+// snapping quad sides to the image
+static const float MIN_EDGE_GRADIENT = 12.0f;
 
-    // Detect keypoints and compute descriptors
-    std::vector<cv::KeyPoint> kp_anchor, kp_scene;
-    cv::Mat desc_anchor, desc_scene;
+// Minimum rows per strip in parallel edge extraction
+static const int MIN_STRIP_ROWS = 32;
 
-    detector->detectAndCompute(anchor_gray, cv::noArray(), kp_anchor, desc_anchor);
-    detector->detectAndCompute(scene_gray, cv::noArray(), kp_scene, desc_scene);
+// Segment quad engine: longest Hough segments kept, lines kept per side
+// orientation, and minimum fraction of every quad side backed by segments
+static const int MAX_QUAD_SEGMENTS = 128;
+static const int MAX_FAMILY_LINES = 8;
+static const float MIN_SIDE_COVERAGE = 0.3f;
 
-    // Check if we have enough keypoints
-    if (kp_anchor.size() < 4 || kp_scene.size() < 4)
+// Contour count from which quad candidates are evaluated on all cores
+static const int MIN_PARALLEL_CONTOURS = 64;
+
+// Largest shared area, as a fraction of the smaller quad, for two papers
+// returned by hg_detect_papers
+static const float MAX_PAPER_OVERLAP = 0.1f;
+
+// Upper bound on PaperDetectionConfig::canny_hypotheses
+static const int MAX_CANNY_HYPOTHESES = 8;
+
+// Grid spacing in pixels of the tracker's lens distortion map
+static const int DISTORTION_MAP_STEP = 8;
+
+// ============================================================================
+// Instrumentation (per-call stage timings and hardware counters)
+// ============================================================================
+
+static const int NUM_PERF_COUNTERS = 5;
+
+static std::atomic<bool> g_perf_counters_enabled(false);
+
+/**
+ * Hardware counters of the calling thread (perf_event_open, user space only)
+ */
+struct PerfCounters
+{
+    int fds[NUM_PERF_COUNTERS];
+    bool opened = false;
+
+    PerfCounters()
     {
-        result.status = 0;
-        return result;
+        for (int &fd : fds)
+            fd = -1;
     }
 
-    if (desc_anchor.empty() || desc_scene.empty())
+    ~PerfCounters()
     {
-        result.status = 0;
-        return result;
+#ifdef HG_HAVE_PERF_EVENTS
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+                close(fd);
+        }
+#endif
     }
 
-    // Match descriptors using BFMatcher with Hamming distance (for ORB)
-    cv::BFMatcher matcher(cv::NORM_HAMMING);
-    std::vector<std::vector<cv::DMatch>> knn_matches;
-    matcher.knnMatch(desc_anchor, desc_scene, knn_matches, 2);
-
-    // Apply Lowe's ratio test
-    std::vector<cv::DMatch> good_matches;
-    for (const auto &m : knn_matches)
+    void open_all()
     {
-        if (m.size() == 2 && m[0].distance < RATIO_THRESH * m[1].distance)
+        opened = true;
+#ifdef HG_HAVE_PERF_EVENTS
+        const uint32_t types[NUM_PERF_COUNTERS] = {
+            PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+            PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE};
+        const uint64_t configs[NUM_PERF_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES};
+
+        // Counters are opened individually so that one unsupported event
+        // (e.g. L1D misses on some ARM cores) does not disable the others
+        for (int i = 0; i < NUM_PERF_COUNTERS; i++)
         {
-            good_matches.push_back(m[0]);
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = types[i];
+            attr.config = configs[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
         }
+#endif
     }
 
-    result.num_matches = static_cast<int>(good_matches.size());
-
-    // Check if we have enough good matches
-    if (good_matches.size() < MIN_MATCHES)
+    int mask() const
     {
-        result.status = 0;
-        return result;
+        int m = 0;
+        for (int i = 0; i < NUM_PERF_COUNTERS; i++)
+        {
+            if (fds[i] >= 0)
+                m |= 1 << i;
+        }
+        return m;
     }
 
-    // Extract matched points
-    std::vector<cv::Point2f> pts_anchor, pts_scene;
-    for (const auto &m : good_matches)
+    void read_all(uint64_t values[NUM_PERF_COUNTERS]) const
     {
-        pts_anchor.push_back(kp_anchor[m.queryIdx].pt);
-        pts_scene.push_back(kp_scene[m.trainIdx].pt);
+        for (int i = 0; i < NUM_PERF_COUNTERS; i++)
+        {
+            values[i] = 0;
+#ifdef HG_HAVE_PERF_EVENTS
+            if (fds[i] >= 0 && read(fds[i], &values[i], sizeof(uint64_t)) != sizeof(uint64_t))
+                values[i] = 0;
+#endif
+        }
     }
+};
 
-    // Compute homography using RANSAC
-    std::vector<char> inliers_mask;
-    cv::Mat H = cv::findHomography(pts_anchor, pts_scene, cv::RANSAC, RANSAC_THRESH, inliers_mask);
+/**
+ * Process-wide allocation counters. Live and peak bytes are per thread so that
+ * each call measures its own high-water mark.
+ */
+static std::atomic<bool> g_alloc_tracking(false);
+static std::atomic<uint64_t> g_alloc_count(0);
+static std::atomic<uint64_t> g_alloc_bytes(0);
+static thread_local int64_t t_alloc_live = 0;
+static thread_local int64_t t_alloc_peak = 0;
 
-    // Check if homography was found
-    if (H.empty() || H.rows != 3 || H.cols != 3)
-    {
-        result.status = 0;
-        return result;
-    }
+/**
+ * Count an allocation if tracking is on
+ *
+ * @return true if the block was counted; only counted blocks go to record_free
+ */
+static bool record_alloc(size_t size)
+{
+    if (!g_alloc_tracking.load(std::memory_order_relaxed))
+        return false;
+
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    t_alloc_live += static_cast<int64_t>(size);
+    t_alloc_peak = std::max(t_alloc_peak, t_alloc_live);
+    return true;
+}
 
-    // Count inliers
-    int num_inliers = 0;
-    for (char inlier : inliers_mask)
-    {
-        if (inlier)
-            num_inliers++;
-    }
+static void record_free(size_t size)
+{
+    // Not gated on g_alloc_tracking: a counted block is uncounted even after
+    // tracking is switched off. A block freed on another thread lowers that
+    // thread's level instead, which can only under-report a peak.
+    t_alloc_live -= static_cast<int64_t>(size);
+}
 
-    // Verify homography quality (at least 50% inliers)
-    if (num_inliers < MIN_MATCHES || num_inliers < good_matches.size() * 0.3)
-    {
-        result.status = 0;
-        return result;
-    }
+/**
+ * cv::MatAllocator that counts buffers allocated by the wrapped allocator
+ */
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+    cv::MatAllocator *base = nullptr;
 
-    // Copy homography matrix to result
-    for (int i = 0; i < 3; i++)
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usage) const override
     {
-        for (int j = 0; j < 3; j++)
+        cv::UMatData *u = base->allocate(dims, sizes, type, data, step, flags, usage);
+        if (u != nullptr && data == nullptr && record_alloc(u->size))
         {
-            result.homography[i * 3 + j] = H.at<double>(i, j);
+            // Route deallocation of counted buffers back through this allocator
+            u->currAllocator = this;
         }
+        return u;
     }
 
-    // Transform anchor corners to scene coordinates
-    std::vector<cv::Point2f> anchor_corners = {
-        {0, 0},
-        {static_cast<float>(anchor_gray.cols), 0},
-        {static_cast<float>(anchor_gray.cols), static_cast<float>(anchor_gray.rows)},
-        {0, static_cast<float>(anchor_gray.rows)}};
-
-    std::vector<cv::Point2f> scene_corners;
-    cv::perspectiveTransform(anchor_corners, scene_corners, H);
-
-    // Store corners in result
-    for (int i = 0; i < 4; i++)
+    bool allocate(cv::UMatData *u, cv::AccessFlag flags, cv::UMatUsageFlags usage) const override
     {
-        result.corners[i * 2] = scene_corners[i].x;
-        result.corners[i * 2 + 1] = scene_corners[i].y;
+        return base->allocate(u, flags, usage);
     }
 
-    // Compute center (average of corners)
-    result.center_x = 0;
-    result.center_y = 0;
-    for (const auto &corner : scene_corners)
+    void deallocate(cv::UMatData *u) const override
     {
-        result.center_x += corner.x;
-        result.center_y += corner.y;
+        if (u == nullptr)
+            return;
+
+        record_free(u->size);
+        u->currAllocator = base;
+        base->deallocate(u);
     }
-    result.center_x /= 4.0f;
-    result.center_y /= 4.0f;
+};
 
-    // Compute rotation angle from top edge
-    float dx = scene_corners[1].x - scene_corners[0].x;
-    float dy = scene_corners[1].y - scene_corners[0].y;
-    result.rotation = std::atan2(dy, dx);
+static CountingMatAllocator g_counting_allocator;
 
-    // Compute scale (average of top and left edge ratios)
-    float top_edge = std::sqrt(dx * dx + dy * dy);
-    float left_dx = scene_corners[3].x - scene_corners[0].x;
-    float left_dy = scene_corners[3].y - scene_corners[0].y;
-    float left_edge = std::sqrt(left_dx * left_dx + left_dy * left_dy);
+#ifdef HG_ENABLE_ALLOC_TRACKING
+// Global allocation hook (instrumentation builds only). Each block carries a
+// header with its size and whether it was counted, so that unsized operator
+// delete can account for it.
+struct AllocHeader
+{
+    size_t size;
+    bool counted;
+};
 
-    float original_width = static_cast<float>(anchor_gray.cols);
-    float original_height = static_cast<float>(anchor_gray.rows);
+static const size_t ALLOC_HEADER = alignof(std::max_align_t);
+static_assert(sizeof(AllocHeader) <= ALLOC_HEADER, "allocation header does not fit");
 
-    result.scale = (top_edge / original_width + left_edge / original_height) / 2.0f;
+static void *tracked_malloc(size_t size)
+{
+    void *block = std::malloc(size + ALLOC_HEADER);
+    if (block == nullptr)
+        return nullptr;
+
+    AllocHeader *header = static_cast<AllocHeader *>(block);
+    header->size = size;
+    header->counted = record_alloc(size);
+    return static_cast<uint8_t *>(block) + ALLOC_HEADER;
+}
 
-    // Validate the detected quadrilateral (should be convex and not too distorted)
-    // Check if corners form a valid quadrilateral
-    auto cross_product = [](const cv::Point2f &o, const cv::Point2f &a, const cv::Point2f &b)
-    {
-        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
-    };
+static void tracked_free(void *ptr)
+{
+    if (ptr == nullptr)
+        return;
+
+    void *block = static_cast<uint8_t *>(ptr) - ALLOC_HEADER;
+    const AllocHeader *header = static_cast<const AllocHeader *>(block);
+    if (header->counted)
+        record_free(header->size);
+    std::free(block);
+}
 
-    // All cross products should have the same sign for a convex polygon
-    float cp1 = cross_product(scene_corners[0], scene_corners[1], scene_corners[2]);
-    float cp2 = cross_product(scene_corners[1], scene_corners[2], scene_corners[3]);
-    float cp3 = cross_product(scene_corners[2], scene_corners[3], scene_corners[0]);
-    float cp4 = cross_product(scene_corners[3], scene_corners[0], scene_corners[1]);
+void *operator new(size_t size)
+{
+    void *ptr = tracked_malloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
 
-    bool is_convex = (cp1 > 0 && cp2 > 0 && cp3 > 0 && cp4 > 0) ||
-                     (cp1 < 0 && cp2 < 0 && cp3 < 0 && cp4 < 0);
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
 
-    if (!is_convex)
-    {
-        result.status = 0;
-        return result;
-    }
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return tracked_malloc(size);
+}
 
-    // Check aspect ratio distortion (should not be too extreme)
-    float aspect_ratio = top_edge / left_edge;
-    float original_aspect = original_width / original_height;
-    float aspect_distortion = aspect_ratio / original_aspect;
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return tracked_malloc(size);
+}
 
-    if (aspect_distortion < 0.3f || aspect_distortion > 3.0f)
-    {
-        result.status = 0;
-        return result;
-    }
+void operator delete(void *ptr) noexcept { tracked_free(ptr); }
+void operator delete[](void *ptr) noexcept { tracked_free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { tracked_free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { tracked_free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { tracked_free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { tracked_free(ptr); }
+#endif
 
-    result.num_matches = num_inliers;
-    result.status = 1;
-    return result;
+static thread_local PerfCounters t_perf_counters;
+static thread_local HgCallStats t_last_stats;
+static thread_local bool t_has_last_stats = false;
+static thread_local HgCallStats *t_active_stats = nullptr;
+
+/**
+ * Counters to read for the current call, or nullptr if disabled/unavailable
+ */
+static const PerfCounters *active_perf_counters()
+{
+    if (!g_perf_counters_enabled.load(std::memory_order_relaxed))
+        return nullptr;
+
+    if (!t_perf_counters.opened)
+        t_perf_counters.open_all();
+
+    return t_perf_counters.mask() != 0 ? &t_perf_counters : nullptr;
 }
 
-extern "C"
+static double elapsed_ms(std::chrono::steady_clock::time_point since)
 {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
 
-    HomographyResult hg_find_homography(
-        const uint8_t *anchor_bytes, size_t anchor_size,
-        const uint8_t *scene_bytes, size_t scene_size)
+/**
+ * Collects statistics of one public API call on the calling thread.
+ * Published to hg_get_last_call_stats when the outermost scope ends.
+ */
+struct CallStatsScope
+{
+    HgCallStats stats = {};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool owner = (t_active_stats == nullptr);
+    bool track_allocs = false;
+    uint64_t start_alloc_count = 0;
+    uint64_t start_alloc_bytes = 0;
+    int64_t start_alloc_live = 0;
+
+    CallStatsScope()
     {
-        HomographyResult result = {};
+        if (!owner)
+            return;
 
-        // Validate input
-        if (anchor_bytes == nullptr || scene_bytes == nullptr)
-        {
-            result.status = -1;
-            return result;
-        }
+        const PerfCounters *counters = active_perf_counters();
+        stats.counters_mask = counters ? counters->mask() : 0;
+        t_active_stats = &stats;
 
-        if (anchor_size == 0 || scene_size == 0)
+        track_allocs = g_alloc_tracking.load(std::memory_order_relaxed);
+        if (track_allocs)
         {
-            result.status = -1;
-            return result;
+            start_alloc_count = g_alloc_count.load(std::memory_order_relaxed);
+            start_alloc_bytes = g_alloc_bytes.load(std::memory_order_relaxed);
+            start_alloc_live = t_alloc_live;
+            t_alloc_peak = t_alloc_live;
         }
+    }
 
-        // Decode anchor image
-        std::vector<uint8_t> anchor_vec(anchor_bytes, anchor_bytes + anchor_size);
-        cv::Mat anchor = cv::imdecode(anchor_vec, cv::IMREAD_GRAYSCALE);
+    ~CallStatsScope()
+    {
+        if (!owner)
+            return;
 
-        if (anchor.empty())
+        if (track_allocs)
         {
-            result.status = -2;
-            return result;
+            stats.counters_mask |= HG_COUNTER_ALLOCATIONS;
+            stats.alloc_count = g_alloc_count.load(std::memory_order_relaxed) - start_alloc_count;
+            stats.alloc_bytes = g_alloc_bytes.load(std::memory_order_relaxed) - start_alloc_bytes;
+            int64_t peak = t_alloc_peak - start_alloc_live;
+            stats.peak_bytes = peak > 0 ? static_cast<uint64_t>(peak) : 0;
         }
 
-        // Decode scene image
-        std::vector<uint8_t> scene_vec(scene_bytes, scene_bytes + scene_size);
-        cv::Mat scene = cv::imdecode(scene_vec, cv::IMREAD_GRAYSCALE);
+        stats.total_ms = elapsed_ms(start);
+        t_last_stats = stats;
+        t_has_last_stats = true;
+        t_active_stats = nullptr;
+    }
+};
 
-        if (scene.empty())
-        {
-            result.status = -3;
-            return result;
-        }
+/**
+ * Records consecutive pipeline stages into the active call statistics.
+ * begin() closes the previous stage; the destructor closes the last one.
+ * A muted timer records nothing (sub-tasks timed as one stage by the caller).
+ */
+struct StageTimer
+{
+    HgStageStats *stage = nullptr;
+    const PerfCounters *counters = nullptr;
+    std::chrono::steady_clock::time_point start;
+    uint64_t begin_values[NUM_PERF_COUNTERS] = {};
+    bool muted = false;
 
-        return compute_homography_internal(anchor, scene);
+    ~StageTimer()
+    {
+        end();
     }
 
-    HomographyResult hg_find_homography_raw(
-        const uint8_t *anchor_data, int anchor_width, int anchor_height, int anchor_channels,
-        const uint8_t *scene_data, int scene_width, int scene_height, int scene_channels)
+    void begin(const char *name)
     {
-        HomographyResult result = {};
+        end();
 
-        // Validate input
-        if (anchor_data == nullptr || scene_data == nullptr)
+        HgCallStats *stats = t_active_stats;
+        if (muted || stats == nullptr)
+            return;
+        if (stats->num_stages >= HG_MAX_STAGES)
         {
-            result.status = -1;
-            return result;
+            stats->dropped_stages++;
+            return;
         }
 
-        if (anchor_width <= 0 || anchor_height <= 0 ||
-            scene_width <= 0 || scene_height <= 0)
-        {
-            result.status = -1;
-            return result;
-        }
+        stage = &stats->stages[stats->num_stages++];
+        std::strncpy(stage->name, name, sizeof(stage->name) - 1);
+        counters = stats->counters_mask ? &t_perf_counters : nullptr;
+        if (counters)
+            counters->read_all(begin_values);
+        start = std::chrono::steady_clock::now();
+    }
 
-        if (anchor_channels != 1 && anchor_channels != 3 && anchor_channels != 4)
-        {
-            result.status = -1;
-            return result;
-        }
+    void end()
+    {
+        if (stage == nullptr)
+            return;
 
-        if (scene_channels != 1 && scene_channels != 3 && scene_channels != 4)
+        stage->wall_ms = elapsed_ms(start);
+        if (counters)
         {
-            result.status = -1;
-            return result;
+            uint64_t end_values[NUM_PERF_COUNTERS];
+            counters->read_all(end_values);
+            stage->cycles = end_values[0] - begin_values[0];
+            stage->instructions = end_values[1] - begin_values[1];
+            stage->l1d_misses = end_values[2] - begin_values[2];
+            stage->llc_misses = end_values[3] - begin_values[3];
+            stage->branch_misses = end_values[4] - begin_values[4];
         }
+        stage = nullptr;
+    }
+};
 
-        // Create cv::Mat from raw data
-        int anchor_type = anchor_channels == 1 ? CV_8UC1 : anchor_channels == 3 ? CV_8UC3
-                                                                                : CV_8UC4;
-        int scene_type = scene_channels == 1 ? CV_8UC1 : scene_channels == 3 ? CV_8UC3
-                                                                             : CV_8UC4;
+// ============================================================================
+// Capture (call inputs and timings for deterministic replay)
+// ============================================================================
+
+static std::atomic<bool> g_capture_active(false);
+static std::mutex g_capture_mutex;
+static FILE *g_capture_file = nullptr;
+static size_t g_capture_bytes = 0;
+static size_t g_capture_max_bytes = 0;
+
+/**
+ * Records one API call into the capture log when capture is active.
+ * Inputs are referenced, not copied, and written when the scope ends,
+ * after the enclosing CallStatsScope has published the call statistics.
+ */
+struct CaptureScope
+{
+    bool active = g_capture_active.load(std::memory_order_relaxed);
+    uint32_t call_type = 0;
+    std::vector<uint8_t> fields;
+    std::vector<std::pair<const void *, size_t>> blobs;
+
+    explicit CaptureScope(HgCallType type)
+    {
+        if (!active)
+            return;
+
+        call_type = static_cast<uint32_t>(type);
+    }
+
+    ~CaptureScope()
+    {
+        // Calls rejected before their inputs were described are not recorded
+        if (active && !blobs.empty())
+            write_record();
+    }
+
+    template <typename T>
+    void field(const T &value)
+    {
+        if (!active)
+            return;
+
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+        fields.insert(fields.end(), bytes, bytes + sizeof(T));
+    }
+
+    void config(const PaperDetectionConfig *config)
+    {
+        field<int32_t>(config != nullptr);
+        field(config != nullptr ? *config : PaperDetectionConfig{});
+    }
+
+    void options(const HgDecodeOptions *options)
+    {
+        field<int32_t>(options != nullptr);
+        field(options != nullptr ? *options : HgDecodeOptions{});
+    }
+
+    void intrinsics(const HgCameraIntrinsics *intrinsics)
+    {
+        field<int32_t>(intrinsics != nullptr);
+        field(intrinsics != nullptr ? *intrinsics : HgCameraIntrinsics{});
+    }
+
+    void blob(const void *data, size_t size)
+    {
+        if (!active)
+            return;
+
+        // Invalid inputs are not worth replaying
+        if (data == nullptr)
+        {
+            active = false;
+            return;
+        }
+        blobs.emplace_back(data, size);
+    }
+
+    void write_record()
+    {
+        HgCallStats stats = {};
+        if (t_has_last_stats)
+            stats = t_last_stats;
+
+        uint32_t fields_size = static_cast<uint32_t>(fields.size());
+        size_t record_size = sizeof(call_type) + sizeof(stats) + sizeof(fields_size) + fields.size();
+        for (const auto &b : blobs)
+            record_size += b.second;
+
+        if (record_size > UINT32_MAX)
+            return;
+
+        std::lock_guard<std::mutex> lock(g_capture_mutex);
+        if (g_capture_file == nullptr)
+            return;
+
+        // Drop records that would exceed the size cap
+        size_t total = sizeof(uint32_t) + record_size;
+        if (g_capture_bytes + total > g_capture_max_bytes)
+            return;
+
+        uint32_t size32 = static_cast<uint32_t>(record_size);
+        std::fwrite(&size32, sizeof(size32), 1, g_capture_file);
+        std::fwrite(&call_type, sizeof(call_type), 1, g_capture_file);
+        std::fwrite(&stats, sizeof(stats), 1, g_capture_file);
+        std::fwrite(&fields_size, sizeof(fields_size), 1, g_capture_file);
+        std::fwrite(fields.data(), 1, fields.size(), g_capture_file);
+        for (const auto &b : blobs)
+            std::fwrite(b.first, 1, b.second, g_capture_file);
+        std::fflush(g_capture_file);
+
+        g_capture_bytes += total;
+    }
+};
+
+// ============================================================================
+// Decoding (encoded entry points)
+// ============================================================================
+
+/**
+ * Read image dimensions from a baseline/progressive JPEG SOF marker
+ */
+static bool probe_jpeg_size(const uint8_t *bytes, size_t size, int &width, int &height)
+{
+    if (size < 4 || bytes[0] != 0xFF || bytes[1] != 0xD8)
+        return false;
+
+    size_t pos = 2;
+    while (pos + 4 <= size)
+    {
+        if (bytes[pos] != 0xFF)
+            return false;
+
+        uint8_t marker = bytes[pos + 1];
+        if (marker == 0xFF)
+        {
+            // Fill byte
+            pos++;
+            continue;
+        }
+        pos += 2;
+
+        // Markers without a length field
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+            continue;
+
+        size_t length = (static_cast<size_t>(bytes[pos]) << 8) | bytes[pos + 1];
+        if (length < 2)
+            return false;
+
+        // SOF0..SOF15 except DHT (C4), JPG (C8) and DAC (CC)
+        bool is_sof = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (is_sof)
+        {
+            if (pos + 7 > size)
+                return false;
+            height = (bytes[pos + 3] << 8) | bytes[pos + 4];
+            width = (bytes[pos + 5] << 8) | bytes[pos + 6];
+            return width > 0 && height > 0;
+        }
+        pos += length;
+    }
+    return false;
+}
+
+/**
+ * Read image dimensions from a PNG IHDR chunk
+ */
+static bool probe_png_size(const uint8_t *bytes, size_t size, int &width, int &height)
+{
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    if (size < 24 || std::memcmp(bytes, signature, 8) != 0 || std::memcmp(bytes + 12, "IHDR", 4) != 0)
+        return false;
+
+    auto be32 = [](const uint8_t *p)
+    {
+        return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    };
+    uint32_t w = be32(bytes + 16);
+    uint32_t h = be32(bytes + 20);
+    if (w == 0 || h == 0 || w > INT32_MAX || h > INT32_MAX)
+        return false;
+
+    width = static_cast<int>(w);
+    height = static_cast<int>(h);
+    return true;
+}
+
+/**
+ * Read the EXIF orientation tag (1..8) from a JPEG APP1 segment
+ *
+ * @return Orientation, or 1 (as stored) if the image has no valid tag
+ */
+static int probe_jpeg_orientation(const uint8_t *bytes, size_t size)
+{
+    if (size < 4 || bytes[0] != 0xFF || bytes[1] != 0xD8)
+        return 1;
+
+    size_t pos = 2;
+    while (pos + 4 <= size && bytes[pos] == 0xFF)
+    {
+        uint8_t marker = bytes[pos + 1];
+        size_t length = (static_cast<size_t>(bytes[pos + 2]) << 8) | bytes[pos + 3];
+
+        // EXIF lives in an APPn segment before the first frame header
+        if (marker < 0xE0 || marker > 0xEF || length < 2 || pos + 2 + length > size)
+            return 1;
+
+        const uint8_t *seg = bytes + pos + 4;
+        size_t seg_size = length - 2;
+        if (marker == 0xE1 && seg_size >= 14 && std::memcmp(seg, "Exif\0\0", 6) == 0)
+        {
+            const uint8_t *tiff = seg + 6;
+            size_t tiff_size = seg_size - 6;
+            bool little = tiff[0] == 'I' && tiff[1] == 'I';
+            if (!little && !(tiff[0] == 'M' && tiff[1] == 'M'))
+                return 1;
+
+            auto u16 = [&](size_t off) -> uint32_t
+            {
+                return little ? (tiff[off] | (tiff[off + 1] << 8)) : ((tiff[off] << 8) | tiff[off + 1]);
+            };
+            auto u32 = [&](size_t off) -> uint32_t
+            {
+                return little ? (u16(off) | (u16(off + 2) << 16)) : ((u16(off) << 16) | u16(off + 2));
+            };
+
+            // IFD0 entries are 12 bytes: tag, type, count, value
+            size_t ifd = u32(4);
+            if (ifd + 2 > tiff_size)
+                return 1;
+            uint32_t entries = u16(ifd);
+            for (uint32_t i = 0; i < entries && ifd + 2 + (i + 1) * 12 <= tiff_size; i++)
+            {
+                size_t entry = ifd + 2 + i * 12;
+                if (u16(entry) == 0x0112 && u16(entry + 2) == 3)
+                {
+                    uint32_t orientation = u16(entry + 8);
+                    return (orientation >= 1 && orientation <= 8) ? static_cast<int>(orientation) : 1;
+                }
+            }
+            return 1;
+        }
+        pos += 2 + length;
+    }
+    return 1;
+}
+
+/**
+ * Map from stored to displayed pixel coordinates for an EXIF orientation
+ *
+ * Coordinates are pixel indices, so a flipped axis maps x to w - 1 - x, the
+ * same as the decoder's cv::flip / cv::rotate.
+ *
+ * @param stored     Size of the image as stored
+ * @param displayed  Receives the size of the image as displayed
+ */
+static cv::Matx33d orientation_matrix(int orientation, cv::Size stored, cv::Size &displayed)
+{
+    const double w = stored.width - 1;
+    const double h = stored.height - 1;
+    displayed = orientation >= 5 ? cv::Size(stored.height, stored.width) : stored;
+
+    switch (orientation)
+    {
+    case 2: // Mirror horizontal
+        return cv::Matx33d(-1, 0, w, 0, 1, 0, 0, 0, 1);
+    case 3: // Rotate 180
+        return cv::Matx33d(-1, 0, w, 0, -1, h, 0, 0, 1);
+    case 4: // Mirror vertical
+        return cv::Matx33d(1, 0, 0, 0, -1, h, 0, 0, 1);
+    case 5: // Transpose
+        return cv::Matx33d(0, 1, 0, 1, 0, 0, 0, 0, 1);
+    case 6: // Rotate 90 clockwise
+        return cv::Matx33d(0, -1, h, 1, 0, 0, 0, 0, 1);
+    case 7: // Transverse
+        return cv::Matx33d(0, -1, h, -1, 0, w, 0, 0, 1);
+    case 8: // Rotate 90 counter-clockwise
+        return cv::Matx33d(0, 1, 0, -1, 0, w, 0, 0, 1);
+    default:
+        return cv::Matx33d::eye();
+    }
+}
+
+/**
+ * Decode an encoded image to grayscale, no larger than options->max_dimension
+ *
+ * @param original_size  Receives the full resolution image size, so that results
+ *                       can be mapped back with original_size / decoded size
+ * @param orientation    Receives the EXIF orientation still to be applied to
+ *                       results (1 unless options->defer_orientation is set)
+ */
+static cv::Mat decode_gray(const uint8_t *bytes, size_t size, const HgDecodeOptions *options,
+                           cv::Size &original_size, int &orientation)
+{
+    int max_dimension = options != nullptr ? options->max_dimension : 0;
+    bool defer_orientation = options != nullptr && options->defer_orientation != 0;
+
+    int width = 0, height = 0;
+    bool is_jpeg = probe_jpeg_size(bytes, size, width, height);
+    bool size_known = is_jpeg || probe_png_size(bytes, size, width, height);
+
+    // Decode pixels as stored and leave the orientation to the caller
+    orientation = 1;
+    int flags = cv::IMREAD_GRAYSCALE;
+    if (is_jpeg && defer_orientation)
+    {
+        orientation = probe_jpeg_orientation(bytes, size);
+        flags |= cv::IMREAD_IGNORE_ORIENTATION;
+    }
+
+    // Pick the largest DCT reduction that still yields at least max_dimension
+    if (is_jpeg && max_dimension > 0)
+    {
+        int side = std::max(width, height);
+        if (side >= max_dimension * 8)
+            flags |= cv::IMREAD_REDUCED_GRAYSCALE_8;
+        else if (side >= max_dimension * 4)
+            flags |= cv::IMREAD_REDUCED_GRAYSCALE_4;
+        else if (side >= max_dimension * 2)
+            flags |= cv::IMREAD_REDUCED_GRAYSCALE_2;
+    }
+
+    // Decode straight from the caller's buffer (no copy)
+    if (size > static_cast<size_t>(INT32_MAX))
+        return cv::Mat();
+    cv::Mat buffer(1, static_cast<int>(size), CV_8UC1, const_cast<uint8_t *>(bytes));
+    cv::Mat gray = cv::imdecode(buffer, flags);
+    if (gray.empty())
+        return gray;
+
+    if (!size_known)
+    {
+        width = gray.cols;
+        height = gray.rows;
+    }
+    else if ((gray.cols > gray.rows) != (width > height))
+    {
+        // Decoder applied an EXIF rotation
+        std::swap(width, height);
+    }
+    original_size = cv::Size(width, height);
+
+    int decoded_side = std::max(gray.cols, gray.rows);
+    if (max_dimension > 0 && decoded_side > max_dimension)
+    {
+        double f = static_cast<double>(max_dimension) / decoded_side;
+        cv::Size target(std::max(1, cvRound(gray.cols * f)), std::max(1, cvRound(gray.rows * f)));
+        cv::resize(gray, gray, target, 0, 0, cv::INTER_AREA);
+    }
+    return gray;
+}
+
+/**
+ * Read-only memory mapping of a whole file (plain read on Windows)
+ */
+struct MappedFile
+{
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+#if defined(_WIN32)
+    std::vector<uint8_t> buffer;
+#else
+    void *mapping = nullptr;
+#endif
+
+    explicit MappedFile(const char *path)
+    {
+        if (path == nullptr)
+            return;
+
+#if defined(_WIN32)
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return;
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr != MAP_FAILED)
+            {
+                // Decoders read the stream front to back
+                madvise(ptr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+                mapping = ptr;
+                data = static_cast<const uint8_t *>(ptr);
+                size = static_cast<size_t>(st.st_size);
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#if !defined(_WIN32)
+        if (mapping != nullptr)
+            munmap(mapping, size);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+};
+
+/**
+ * Map from decoded to original pixel coordinates of a resized image
+ *
+ * Pixel centres line up as in cv::resize: x' = (x + 0.5) * sx - 0.5.
+ *
+ * @param sx, sy  Original / decoded size ratios
+ */
+static cv::Matx33d resize_matrix(double sx, double sy)
+{
+    return cv::Matx33d(sx, 0, (sx - 1) / 2,
+                       0, sy, (sy - 1) / 2,
+                       0, 0, 1);
+}
+
+/**
+ * Apply resize_matrix to a point in place
+ */
+static void resize_point(float &x, float &y, double sx, double sy)
+{
+    x = static_cast<float>((x + 0.5) * sx - 0.5);
+    y = static_cast<float>((y + 0.5) * sy - 0.5);
+}
+
+/**
+ * Map a homography result computed on decoded images to original pixel coordinates
+ *
+ * @param anchor_sx, anchor_sy  Original / decoded anchor size ratios
+ * @param scene_sx, scene_sy    Original / decoded scene size ratios
+ */
+static void scale_homography_result(HomographyResult &result,
+                                    double anchor_sx, double anchor_sy,
+                                    double scene_sx, double scene_sy)
+{
+    // H' = T_scene * H * T_anchor^-1
+    cv::Matx33d H(result.homography);
+    H = resize_matrix(scene_sx, scene_sy) * H * resize_matrix(anchor_sx, anchor_sy).inv();
+    for (int i = 0; i < 9; i++)
+    {
+        result.homography[i] = H.val[i];
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        resize_point(result.corners[i * 2], result.corners[i * 2 + 1], scene_sx, scene_sy);
+    }
+    resize_point(result.center_x, result.center_y, scene_sx, scene_sy);
+    result.scale *= static_cast<float>(std::sqrt((scene_sx * scene_sy) / (anchor_sx * anchor_sy)));
+}
+
+/**
+ * Express a homography result computed on stored (unrotated) images in the
+ * displayed orientation of both images
+ *
+ * H' = O_scene * H * O_anchor^-1; corners, center, rotation and scale are
+ * re-derived from H' for the displayed anchor rectangle.
+ */
+static void orient_homography_result(HomographyResult &result,
+                                     int anchor_orientation, cv::Size anchor_size,
+                                     int scene_orientation, cv::Size scene_size)
+{
+    cv::Size anchor_displayed, scene_displayed;
+    cv::Matx33d anchor_o = orientation_matrix(anchor_orientation, anchor_size, anchor_displayed);
+    cv::Matx33d scene_o = orientation_matrix(scene_orientation, scene_size, scene_displayed);
+
+    cv::Matx33d H(result.homography);
+    H = scene_o * H * anchor_o.inv();
+    for (int i = 0; i < 9; i++)
+    {
+        result.homography[i] = H.val[i];
+    }
+
+    std::vector<cv::Point2f> anchor_corners = {
+        {0, 0},
+        {static_cast<float>(anchor_displayed.width), 0},
+        {static_cast<float>(anchor_displayed.width), static_cast<float>(anchor_displayed.height)},
+        {0, static_cast<float>(anchor_displayed.height)}};
+
+    std::vector<cv::Point2f> scene_corners;
+    cv::perspectiveTransform(anchor_corners, scene_corners, H);
+
+    result.center_x = 0;
+    result.center_y = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        result.corners[i * 2] = scene_corners[i].x;
+        result.corners[i * 2 + 1] = scene_corners[i].y;
+        result.center_x += scene_corners[i].x / 4.0f;
+        result.center_y += scene_corners[i].y / 4.0f;
+    }
+
+    cv::Point2f top = scene_corners[1] - scene_corners[0];
+    cv::Point2f left = scene_corners[3] - scene_corners[0];
+    result.rotation = std::atan2(top.y, top.x);
+    result.scale = (std::sqrt(top.dot(top)) / anchor_displayed.width +
+                    std::sqrt(left.dot(left)) / anchor_displayed.height) /
+                   2.0f;
+}
+
+/**
+ * Map a paper detection result computed on a decoded image to original pixel coordinates
+ *
+ * @param sx, sy  Original / decoded image size ratios
+ */
+static void scale_paper_result(PaperDetectionResult &result, double sx, double sy)
+{
+    // H' = T * H
+    cv::Matx33d H(result.homography);
+    H = resize_matrix(sx, sy) * H;
+    for (int i = 0; i < 9; i++)
+    {
+        result.homography[i] = H.val[i];
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        resize_point(result.corners[i * 2], result.corners[i * 2 + 1], sx, sy);
+    }
+    resize_point(result.center_x, result.center_y, sx, sy);
+    result.area *= static_cast<float>(sx * sy);
+    result.perimeter *= static_cast<float>(std::sqrt(sx * sy));
+}
+
+/**
+ * Apply an affine map (last row 0, 0, 1) to points in place
+ */
+static void map_points_affine(std::vector<cv::Point2f> &points, const cv::Matx33d &T)
+{
+    for (cv::Point2f &p : points)
+    {
+        double x = p.x, y = p.y;
+        p = cv::Point2f(static_cast<float>(T(0, 0) * x + T(0, 1) * y + T(0, 2)),
+                        static_cast<float>(T(1, 0) * x + T(1, 1) * y + T(1, 2)));
+    }
+}
+
+/**
+ * OpenCV distortion vector (k1, k2, p1, p2, k3), or an empty Mat for an ideal lens
+ */
+static cv::Mat distortion_coeffs(float k1, float k2, float p1, float p2, float k3)
+{
+    if (k1 == 0 && k2 == 0 && p1 == 0 && p2 == 0 && k3 == 0)
+        return cv::Mat();
+    return (cv::Mat_<double>(5, 1) << k1, k2, p1, p2, k3);
+}
+
+/**
+ * Undistort points in place, keeping them in the pixel coordinates of K
+ *
+ * Only the given points are corrected; wide-angle lenses need more than the
+ * default five fixed-point iterations near the image border.
+ */
+static void undistort_pixels(std::vector<cv::Point2f> &points, const cv::Matx33d &K, const cv::Mat &dist_coeffs)
+{
+    if (dist_coeffs.empty() || points.empty())
+        return;
+
+    std::vector<cv::Point2f> undistorted;
+    cv::undistortPoints(points, undistorted, K, dist_coeffs, cv::noArray(), K,
+                        cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20, 0.01));
+    points.swap(undistorted);
+}
+
+/**
+ * Camera pose of a planar anchor from matched points (IPPE)
+ *
+ * Anchor points are placed on the Z = 0 plane, scaled from anchor pixels to
+ * the units of intrinsics.anchor_width.
+ *
+ * @param anchor_width  Anchor width in the pixels of pts_anchor
+ * @param scene_size    Scene size in the pixels of pts_scene (default principal point)
+ */
+static void solve_anchor_pose(HgPose &pose,
+                              const std::vector<cv::Point2f> &pts_anchor,
+                              const std::vector<cv::Point2f> &pts_scene,
+                              const HgCameraIntrinsics &intrinsics,
+                              int anchor_width, cv::Size scene_size)
+{
+    if (pts_anchor.size() < 4 || pts_anchor.size() != pts_scene.size())
+        return;
+
+    double unit = intrinsics.anchor_width > 0 ? intrinsics.anchor_width / static_cast<double>(anchor_width) : 1.0;
+    std::vector<cv::Point3f> object_points;
+    object_points.reserve(pts_anchor.size());
+    for (const cv::Point2f &p : pts_anchor)
+    {
+        object_points.emplace_back(static_cast<float>(p.x * unit), static_cast<float>(p.y * unit), 0.0f);
+    }
+
+    cv::Matx33d K(intrinsics.focal_length, 0, intrinsics.cx > 0 ? intrinsics.cx : scene_size.width / 2.0,
+                  0, intrinsics.focal_length, intrinsics.cy > 0 ? intrinsics.cy : scene_size.height / 2.0,
+                  0, 0, 1);
+
+    // Undistort the inliers only; the homography itself stays in image pixels
+    std::vector<cv::Point2f> image_points = pts_scene;
+    undistort_pixels(image_points, K, distortion_coeffs(intrinsics.dist_k1, intrinsics.dist_k2, intrinsics.dist_p1,
+                                                        intrinsics.dist_p2, intrinsics.dist_k3));
+
+    cv::Mat rvec, tvec;
+    if (!cv::solvePnP(object_points, image_points, K, cv::Mat(), rvec, tvec, false, cv::SOLVEPNP_IPPE))
+        return;
+
+    for (int i = 0; i < 3; i++)
+    {
+        pose.rvec[i] = rvec.at<double>(i);
+        pose.tvec[i] = tvec.at<double>(i);
+    }
+    pose.has_pose = 1;
+}
+
+/**
+ * Internal function to compute homography from two grayscale images
+ *
+ * @param inlier_anchor, inlier_scene  If not NULL, receive the RANSAC inlier
+ *                                     matches of a successful result
+ */
+static HomographyResult compute_homography_internal(
+    const cv::Mat &anchor_gray,
+    const cv::Mat &scene_gray,
+    std::vector<cv::Point2f> *inlier_anchor = nullptr,
+    std::vector<cv::Point2f> *inlier_scene = nullptr)
+{
+    HomographyResult result = {};
+    StageTimer stages;
+
+    // Create ORB detector (fast, free, works well on mobile)
+    auto detector = cv::ORB::create(
+        1000, // nfeatures - max number of features
+        1.2f, // scaleFactor
+        8,    // nlevels
+        31,   // edgeThreshold
+        0,    // firstLevel
+        2,    // WTA_K
+        cv::ORB::HARRIS_SCORE,
+        31, // patchSize
+        20  // fastThreshold
+    );
+
+    // Detect keypoints and compute descriptors
+    std::vector<cv::KeyPoint> kp_anchor, kp_scene;
+    cv::Mat desc_anchor, desc_scene;
+
+    stages.begin("orb");
+    detector->detectAndCompute(anchor_gray, cv::noArray(), kp_anchor, desc_anchor);
+    detector->detectAndCompute(scene_gray, cv::noArray(), kp_scene, desc_scene);
+
+    // Check if we have enough keypoints
+    if (kp_anchor.size() < 4 || kp_scene.size() < 4)
+    {
+        result.status = 0;
+        return result;
+    }
+
+    if (desc_anchor.empty() || desc_scene.empty())
+    {
+        result.status = 0;
+        return result;
+    }
+
+    // Match descriptors using BFMatcher with Hamming distance (for ORB)
+    stages.begin("match");
+    cv::BFMatcher matcher(cv::NORM_HAMMING);
+    std::vector<std::vector<cv::DMatch>> knn_matches;
+    matcher.knnMatch(desc_anchor, desc_scene, knn_matches, 2);
+
+    // Apply Lowe's ratio test
+    std::vector<cv::DMatch> good_matches;
+    for (const auto &m : knn_matches)
+    {
+        if (m.size() == 2 && m[0].distance < RATIO_THRESH * m[1].distance)
+        {
+            good_matches.push_back(m[0]);
+        }
+    }
+
+    result.num_matches = static_cast<int>(good_matches.size());
+
+    // Check if we have enough good matches
+    if (good_matches.size() < MIN_MATCHES)
+    {
+        result.status = 0;
+        return result;
+    }
+
+    // Extract matched points
+    std::vector<cv::Point2f> pts_anchor, pts_scene;
+    for (const auto &m : good_matches)
+    {
+        pts_anchor.push_back(kp_anchor[m.queryIdx].pt);
+        pts_scene.push_back(kp_scene[m.trainIdx].pt);
+    }
+
+    // Compute homography using RANSAC
+    stages.begin("ransac");
+    std::vector<char> inliers_mask;
+    cv::Mat H = cv::findHomography(pts_anchor, pts_scene, cv::RANSAC, RANSAC_THRESH, inliers_mask);
+
+    // Check if homography was found
+    if (H.empty() || H.rows != 3 || H.cols != 3)
+    {
+        result.status = 0;
+        return result;
+    }
+
+    stages.begin("verify");
+
+    // Count inliers
+    int num_inliers = 0;
+    for (char inlier : inliers_mask)
+    {
+        if (inlier)
+            num_inliers++;
+    }
+
+    // Verify homography quality (at least 50% inliers)
+    if (num_inliers < MIN_MATCHES || num_inliers < good_matches.size() * 0.3)
+    {
+        result.status = 0;
+        return result;
+    }
+
+    // Copy homography matrix to result
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            result.homography[i * 3 + j] = H.at<double>(i, j);
+        }
+    }
+
+    // Transform anchor corners to scene coordinates
+    std::vector<cv::Point2f> anchor_corners = {
+        {0, 0},
+        {static_cast<float>(anchor_gray.cols), 0},
+        {static_cast<float>(anchor_gray.cols), static_cast<float>(anchor_gray.rows)},
+        {0, static_cast<float>(anchor_gray.rows)}};
+
+    std::vector<cv::Point2f> scene_corners;
+    cv::perspectiveTransform(anchor_corners, scene_corners, H);
+
+    // Store corners in result
+    for (int i = 0; i < 4; i++)
+    {
+        result.corners[i * 2] = scene_corners[i].x;
+        result.corners[i * 2 + 1] = scene_corners[i].y;
+    }
+
+    // Compute center (average of corners)
+    result.center_x = 0;
+    result.center_y = 0;
+    for (const auto &corner : scene_corners)
+    {
+        result.center_x += corner.x;
+        result.center_y += corner.y;
+    }
+    result.center_x /= 4.0f;
+    result.center_y /= 4.0f;
+
+    // Compute rotation angle from top edge
+    float dx = scene_corners[1].x - scene_corners[0].x;
+    float dy = scene_corners[1].y - scene_corners[0].y;
+    result.rotation = std::atan2(dy, dx);
+
+    // Compute scale (average of top and left edge ratios)
+    float top_edge = std::sqrt(dx * dx + dy * dy);
+    float left_dx = scene_corners[3].x - scene_corners[0].x;
+    float left_dy = scene_corners[3].y - scene_corners[0].y;
+    float left_edge = std::sqrt(left_dx * left_dx + left_dy * left_dy);
+
+    float original_width = static_cast<float>(anchor_gray.cols);
+    float original_height = static_cast<float>(anchor_gray.rows);
+
+    result.scale = (top_edge / original_width + left_edge / original_height) / 2.0f;
+
+    // Validate the detected quadrilateral (should be convex and not too distorted)
+    // Check if corners form a valid quadrilateral
+    auto cross_product = [](const cv::Point2f &o, const cv::Point2f &a, const cv::Point2f &b)
+    {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    };
+
+    // All cross products should have the same sign for a convex polygon
+    float cp1 = cross_product(scene_corners[0], scene_corners[1], scene_corners[2]);
+    float cp2 = cross_product(scene_corners[1], scene_corners[2], scene_corners[3]);
+    float cp3 = cross_product(scene_corners[2], scene_corners[3], scene_corners[0]);
+    float cp4 = cross_product(scene_corners[3], scene_corners[0], scene_corners[1]);
+
+    bool is_convex = (cp1 > 0 && cp2 > 0 && cp3 > 0 && cp4 > 0) ||
+                     (cp1 < 0 && cp2 < 0 && cp3 < 0 && cp4 < 0);
+
+    if (!is_convex)
+    {
+        result.status = 0;
+        return result;
+    }
+
+    // Check aspect ratio distortion (should not be too extreme)
+    float aspect_ratio = top_edge / left_edge;
+    float original_aspect = original_width / original_height;
+    float aspect_distortion = aspect_ratio / original_aspect;
+
+    if (aspect_distortion < 0.3f || aspect_distortion > 3.0f)
+    {
+        result.status = 0;
+        return result;
+    }
+
+    if (inlier_anchor != nullptr && inlier_scene != nullptr)
+    {
+        for (size_t i = 0; i < inliers_mask.size(); i++)
+        {
+            if (!inliers_mask[i])
+                continue;
+            inlier_anchor->push_back(pts_anchor[i]);
+            inlier_scene->push_back(pts_scene[i]);
+        }
+    }
+
+    result.num_matches = num_inliers;
+    result.status = 1;
+    return result;
+}
+
+// ============================================================================
+// Fused edge kernel (blur + Canny + 3x3 dilate in one pass)
+// ============================================================================
+
+/**
+ * Mirror an out-of-range index back into [0, n) (BORDER_REFLECT_101)
+ */
+static inline int reflect101(int p, int n)
+{
+    if (n == 1)
+        return 0;
+    while (p < 0 || p >= n)
+        p = p < 0 ? -p : 2 * n - 2 - p;
+    return p;
+}
+
+/**
+ * Vertical blur pass: sum[x] = sum_i k[i] * rows[i][x] (Q8 weights, fits 16 bits)
+ */
+static void blur_vertical(const uint8_t *const *rows, const uint8_t *k, int taps, uint16_t *sum, int width)
+{
+    int x = 0;
+#if defined(HG_SIMD_NEON)
+    for (; x <= width - 16; x += 16)
+    {
+        uint8x16_t p = vld1q_u8(rows[0] + x);
+        uint8x8_t w = vdup_n_u8(k[0]);
+        uint16x8_t lo = vmull_u8(vget_low_u8(p), w);
+        uint16x8_t hi = vmull_u8(vget_high_u8(p), w);
+        for (int i = 1; i < taps; i++)
+        {
+            p = vld1q_u8(rows[i] + x);
+            w = vdup_n_u8(k[i]);
+            lo = vmlal_u8(lo, vget_low_u8(p), w);
+            hi = vmlal_u8(hi, vget_high_u8(p), w);
+        }
+        vst1q_u16(sum + x, lo);
+        vst1q_u16(sum + x + 8, hi);
+    }
+#elif defined(HG_SIMD_AVX2)
+    for (; x <= width - 16; x += 16)
+    {
+        __m256i acc = _mm256_setzero_si256();
+        for (int i = 0; i < taps; i++)
+        {
+            __m256i p = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[i] + x)));
+            acc = _mm256_add_epi16(acc, _mm256_mullo_epi16(p, _mm256_set1_epi16(k[i])));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(sum + x), acc);
+    }
+#endif
+    for (; x < width; x++)
+    {
+        unsigned acc = 0;
+        for (int i = 0; i < taps; i++)
+            acc += k[i] * rows[i][x];
+        sum[x] = static_cast<uint16_t>(acc);
+    }
+}
+
+/**
+ * Horizontal blur pass over a row padded by taps / 2 on both sides
+ */
+static void blur_horizontal(const uint16_t *sum, const uint8_t *k, int taps, uint8_t *dst, int width)
+{
+    const uint16_t *src = sum - taps / 2;
+    int x = 0;
+#if defined(HG_SIMD_NEON)
+    for (; x <= width - 8; x += 8)
+    {
+        uint32x4_t lo = vdupq_n_u32(1u << 15);
+        uint32x4_t hi = lo;
+        for (int i = 0; i < taps; i++)
+        {
+            uint16x8_t v = vld1q_u16(src + x + i);
+            lo = vmlal_n_u16(lo, vget_low_u16(v), k[i]);
+            hi = vmlal_n_u16(hi, vget_high_u16(v), k[i]);
+        }
+        uint16x8_t r = vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16));
+        vst1_u8(dst + x, vmovn_u16(r));
+    }
+#elif defined(HG_SIMD_AVX2)
+    for (; x <= width - 8; x += 8)
+    {
+        __m256i acc = _mm256_set1_epi32(1 << 15);
+        for (int i = 0; i < taps; i++)
+        {
+            __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x + i)));
+            acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(v, _mm256_set1_epi32(k[i])));
+        }
+        acc = _mm256_srli_epi32(acc, 16);
+        __m128i r = _mm_packus_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(r, r));
+    }
+#endif
+    for (; x < width; x++)
+    {
+        unsigned acc = 1u << 15;
+        for (int i = 0; i < taps; i++)
+            acc += k[i] * src[x + i];
+        dst[x] = static_cast<uint8_t>(acc >> 16);
+    }
+}
+
+/**
+ * 3x3 Sobel gradients and L1 magnitude of one row (input rows padded by one pixel)
+ */
+static void sobel_row(const uint8_t *b0, const uint8_t *b1, const uint8_t *b2,
+                      int16_t *dx, int16_t *dy, int16_t *mag, int width)
+{
+    int x = 0;
+#if defined(HG_SIMD_NEON)
+    for (; x <= width - 8; x += 8)
+    {
+        int16x8_t l0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b0 + x - 1)));
+        int16x8_t c0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b0 + x)));
+        int16x8_t r0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b0 + x + 1)));
+        int16x8_t l1 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b1 + x - 1)));
+        int16x8_t r1 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b1 + x + 1)));
+        int16x8_t l2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b2 + x - 1)));
+        int16x8_t c2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b2 + x)));
+        int16x8_t r2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b2 + x + 1)));
+
+        int16x8_t gx = vaddq_s16(vsubq_s16(r0, l0), vsubq_s16(r2, l2));
+        gx = vaddq_s16(gx, vshlq_n_s16(vsubq_s16(r1, l1), 1));
+        int16x8_t gy = vsubq_s16(vaddq_s16(vaddq_s16(l2, r2), vshlq_n_s16(c2, 1)),
+                                 vaddq_s16(vaddq_s16(l0, r0), vshlq_n_s16(c0, 1)));
+
+        vst1q_s16(dx + x, gx);
+        vst1q_s16(dy + x, gy);
+        vst1q_s16(mag + x, vaddq_s16(vabsq_s16(gx), vabsq_s16(gy)));
+    }
+#elif defined(HG_SIMD_AVX2)
+    auto load = [](const uint8_t *p)
+    {
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+    };
+    for (; x <= width - 16; x += 16)
+    {
+        __m256i l0 = load(b0 + x - 1), c0 = load(b0 + x), r0 = load(b0 + x + 1);
+        __m256i l1 = load(b1 + x - 1), r1 = load(b1 + x + 1);
+        __m256i l2 = load(b2 + x - 1), c2 = load(b2 + x), r2 = load(b2 + x + 1);
+
+        __m256i gx = _mm256_add_epi16(_mm256_sub_epi16(r0, l0), _mm256_sub_epi16(r2, l2));
+        gx = _mm256_add_epi16(gx, _mm256_slli_epi16(_mm256_sub_epi16(r1, l1), 1));
+        __m256i gy = _mm256_sub_epi16(_mm256_add_epi16(_mm256_add_epi16(l2, r2), _mm256_slli_epi16(c2, 1)),
+                                      _mm256_add_epi16(_mm256_add_epi16(l0, r0), _mm256_slli_epi16(c0, 1)));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dx + x), gx);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dy + x), gy);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(mag + x),
+                            _mm256_add_epi16(_mm256_abs_epi16(gx), _mm256_abs_epi16(gy)));
+    }
+#endif
+    for (; x < width; x++)
+    {
+        int gx = (b0[x + 1] - b0[x - 1]) + 2 * (b1[x + 1] - b1[x - 1]) + (b2[x + 1] - b2[x - 1]);
+        int gy = (b2[x - 1] + 2 * b2[x] + b2[x + 1]) - (b0[x - 1] + 2 * b0[x] + b0[x + 1]);
+        dx[x] = static_cast<int16_t>(gx);
+        dy[x] = static_cast<int16_t>(gy);
+        mag[x] = static_cast<int16_t>(std::abs(gx) + std::abs(gy));
+    }
+}
+
+// Class map values; strong is the largest so a max filter finds it
+static const uint8_t EDGE_NONE = 0;
+static const uint8_t EDGE_WEAK = 1;
+static const uint8_t EDGE_WEAK_SEEN = 2; // Weak pixel already given a component label
+static const uint8_t EDGE_STRONG = 3;
+
+/**
+ * Whether pixel x is a maximum along its gradient direction (same rules as cv::Canny)
+ */
+static inline bool is_edge_peak(int16_t dx, int16_t dy,
+                                const int16_t *mag_prev, const int16_t *mag, const int16_t *mag_next, int x)
+{
+    // tan(22.5 deg) in Q15
+    const int TG22 = 13573;
+
+    int m = mag[x];
+    int xs = std::abs(dx);
+    int ys = std::abs(dy) << 15;
+    int tg22x = xs * TG22;
+
+    if (ys < tg22x)
+        return m > mag[x - 1] && m >= mag[x + 1];
+    if (ys > tg22x + (xs << 16))
+        return m > mag_prev[x] && m >= mag_next[x];
+
+    int s = (dx ^ dy) < 0 ? -1 : 1;
+    return m > mag_prev[x - s] && m > mag_next[x + s];
+}
+
+/**
+ * Non-maximum suppression and double threshold of one row (same rules as cv::Canny)
+ *
+ * Writes EDGE_WEAK or EDGE_STRONG into the class map and queues strong pixels
+ * for hysteresis. Magnitude rows are padded by one zero on both sides.
+ */
+static void nms_row(const int16_t *dx, const int16_t *dy,
+                    const int16_t *mag_prev, const int16_t *mag, const int16_t *mag_next,
+                    int low, int high, int width, uint8_t *map, std::vector<uint8_t *> &strong)
+{
+    for (int x = 0; x < width; x++)
+    {
+        int m = mag[x];
+        if (m <= low || !is_edge_peak(dx[x], dy[x], mag_prev, mag, mag_next, x))
+            continue;
+
+        if (m > high)
+        {
+            map[x] = EDGE_STRONG;
+            strong.push_back(map + x);
+        }
+        else
+        {
+            map[x] = EDGE_WEAK;
+        }
+    }
+}
+
+/**
+ * 3x3 dilation of the strong pixels of three class map rows into 0/255
+ *
+ * Map rows start one pixel left of the image; colmax holds width + 2 bytes.
+ */
+static void dilate_strong_row(const uint8_t *m0, const uint8_t *m1, const uint8_t *m2,
+                              uint8_t *colmax, uint8_t *dst, int width)
+{
+    int x = 0;
+    const int padded = width + 2;
+#if defined(HG_SIMD_NEON)
+    for (; x <= padded - 16; x += 16)
+        vst1q_u8(colmax + x, vmaxq_u8(vmaxq_u8(vld1q_u8(m0 + x), vld1q_u8(m1 + x)), vld1q_u8(m2 + x)));
+#elif defined(HG_SIMD_AVX2)
+    for (; x <= padded - 32; x += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(m0 + x));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(m1 + x));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(m2 + x));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(colmax + x), _mm256_max_epu8(_mm256_max_epu8(a, b), c));
+    }
+#endif
+    for (; x < padded; x++)
+        colmax[x] = std::max(std::max(m0[x], m1[x]), m2[x]);
+
+    // A strong pixel anywhere in the 3x3 window marks the output
+    x = 0;
+#if defined(HG_SIMD_NEON)
+    const uint8x16_t strong16 = vdupq_n_u8(EDGE_STRONG);
+    for (; x <= width - 16; x += 16)
+    {
+        uint8x16_t v = vmaxq_u8(vmaxq_u8(vld1q_u8(colmax + x), vld1q_u8(colmax + x + 1)), vld1q_u8(colmax + x + 2));
+        vst1q_u8(dst + x, vceqq_u8(v, strong16));
+    }
+#elif defined(HG_SIMD_AVX2)
+    const __m256i strong32 = _mm256_set1_epi8(EDGE_STRONG);
+    for (; x <= width - 32; x += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(colmax + x));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(colmax + x + 1));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(colmax + x + 2));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x),
+                            _mm256_cmpeq_epi8(_mm256_max_epu8(_mm256_max_epu8(a, b), c), strong32));
+    }
+#endif
+    for (; x < width; x++)
+        dst[x] = std::max(std::max(colmax[x], colmax[x + 1]), colmax[x + 2]) == EDGE_STRONG ? 255 : 0;
+}
+
+/**
+ * Quantized blur weights and Canny thresholds shared by all rows
+ */
+struct EdgeKernel
+{
+    std::vector<uint8_t> weights; // Q8 Gaussian weights summing to 256
+    int taps = 1;
+    int low = 0;
+    int high = 0;
+
+    EdgeKernel(int blur_kernel_size, int threshold1, int threshold2)
+        : low(std::min(threshold1, threshold2)), high(std::max(threshold1, threshold2))
+    {
+        taps = (blur_kernel_size > 1 && blur_kernel_size % 2 == 1) ? blur_kernel_size : 1;
+        weights.assign(taps, 0);
+        if (taps == 1)
+            return;
+
+        cv::Mat g = cv::getGaussianKernel(taps, 0, CV_64F);
+        int total = 0;
+        for (int i = 0; i < taps; i++)
+        {
+            weights[i] = static_cast<uint8_t>(cvRound(g.at<double>(i) * 256));
+            total += weights[i];
+        }
+        weights[taps / 2] = static_cast<uint8_t>(weights[taps / 2] + 256 - total);
+    }
+};
+
+/**
+ * Blur and gradients for image rows [y0, y1), handed to `emit` row by row
+ *
+ * Rows stream through three-row ring buffers (blurred pixels, gradients,
+ * magnitudes), so the working set stays in cache. Rows just outside the
+ * range are recomputed from the source as halo rather than shared, which
+ * lets disjoint ranges run concurrently. emit(y, dx, dy, mag_prev, mag,
+ * mag_next) receives the gradients of row y and the padded magnitudes of
+ * rows y - 1..y + 1.
+ */
+template <typename RowFn>
+static void gradient_rows(const cv::Mat &gray, const EdgeKernel &kernel, int y0, int y1, RowFn &&emit)
+{
+    const int width = gray.cols;
+    const int height = gray.rows;
+    const int taps = kernel.taps;
+    const int radius = taps / 2;
+    const int padded = width + 2;
+
+    std::vector<uint16_t> sum_row(width + 2 * radius);
+    std::vector<uint8_t> blur_ring(3 * padded);
+    std::vector<int16_t> dx_ring(3 * width), dy_ring(3 * width);
+    std::vector<int16_t> mag_ring(4 * padded, 0); // Slot 3 is the zero row outside the image
+    std::vector<const uint8_t *> taps_rows(taps);
+
+    auto blurred = [&](int r)
+    {
+        return &blur_ring[(r % 3) * padded] + 1;
+    };
+    auto magnitude = [&](int r)
+    {
+        return &mag_ring[((r < 0 || r >= height) ? 3 : r % 3) * padded] + 1;
+    };
+    auto blur_row = [&](int r)
+    {
+        uint8_t *dst = blurred(r);
+        if (taps == 1)
+        {
+            std::memcpy(dst, gray.ptr<uint8_t>(r), width);
+        }
+        else
+        {
+            for (int i = 0; i < taps; i++)
+                taps_rows[i] = gray.ptr<uint8_t>(reflect101(r - radius + i, height));
+
+            uint16_t *sum = sum_row.data() + radius;
+            blur_vertical(taps_rows.data(), kernel.weights.data(), taps, sum, width);
+            for (int j = 1; j <= radius; j++)
+            {
+                sum[-j] = sum[reflect101(-j, width)];
+                sum[width - 1 + j] = sum[reflect101(width - 1 + j, width)];
+            }
+            blur_horizontal(sum, kernel.weights.data(), taps, dst, width);
+        }
+
+        // Sobel reads one replicated pixel on each side
+        dst[-1] = dst[0];
+        dst[width] = dst[width - 1];
+    };
+
+    // Row r produces gradients of row r and classifies row r - 1
+    int next_blur = std::max(y0 - 2, 0);
+    for (int r = y0 - 1; r <= y1; r++)
+    {
+        if (r >= 0 && r < height)
+        {
+            int below = std::min(r + 1, height - 1);
+            while (next_blur <= below)
+                blur_row(next_blur++);
+
+            sobel_row(blurred(std::max(r - 1, 0)), blurred(r), blurred(below),
+                      &dx_ring[(r % 3) * width], &dy_ring[(r % 3) * width], magnitude(r), width);
+        }
+
+        int y = r - 1;
+        if (y >= y0)
+        {
+            emit(y, &dx_ring[(y % 3) * width], &dy_ring[(y % 3) * width],
+                 magnitude(y - 1), magnitude(y), magnitude(y + 1));
+        }
+    }
+}
+
+/**
+ * Blur, gradients, non-maximum suppression and double threshold for image
+ * rows [y0, y1)
+ *
+ * The class map has a one-pixel zero border; strong pixels are appended to
+ * `strong`.
+ */
+static void classify_edge_rows(const cv::Mat &gray, const EdgeKernel &kernel, int y0, int y1,
+                               uint8_t *map, std::vector<uint8_t *> &strong)
+{
+    const int padded = gray.cols + 2;
+    gradient_rows(gray, kernel, y0, y1,
+                  [&](int y, const int16_t *dx, const int16_t *dy,
+                      const int16_t *mag_prev, const int16_t *mag, const int16_t *mag_next)
+                  {
+                      nms_row(dx, dy, mag_prev, mag, mag_next, kernel.low, kernel.high, gray.cols,
+                              map + static_cast<size_t>(y + 1) * padded + 1, strong);
+                  });
+}
+
+/**
+ * Hysteresis: grow strong pixels through 8-connected weak pixels of image rows [y0, y1)
+ */
+static void grow_strong_edges(uint8_t *map, int padded, int y0, int y1, std::vector<uint8_t *> &strong)
+{
+    // Class map rows of the range (one border row above the image)
+    const uint8_t *first = map + static_cast<size_t>(y0 + 1) * padded;
+    const uint8_t *last = map + static_cast<size_t>(y1 + 1) * padded;
+
+    const std::ptrdiff_t neighbours[8] = {-padded - 1, -padded, -padded + 1, -1, 1, padded - 1, padded, padded + 1};
+    while (!strong.empty())
+    {
+        uint8_t *p = strong.back();
+        strong.pop_back();
+        for (std::ptrdiff_t offset : neighbours)
+        {
+            uint8_t *q = p + offset;
+            if (q >= first && q < last && (*q == EDGE_WEAK || *q == EDGE_WEAK_SEEN))
+            {
+                *q = EDGE_STRONG;
+                strong.push_back(q);
+            }
+        }
+    }
+}
+
+/**
+ * Write the 3x3 dilated strong pixels of image rows [y0, y1) as 0/255
+ */
+static void dilate_edge_rows(const uint8_t *map, int padded, int y0, int y1, cv::Mat &edges)
+{
+    std::vector<uint8_t> colmax(padded);
+    for (int y = y0; y < y1; y++)
+    {
+        const uint8_t *row = map + static_cast<size_t>(y) * padded;
+        dilate_strong_row(row, row + padded, row + 2 * padded, colmax.data(), edges.ptr<uint8_t>(y), edges.cols);
+    }
+}
+
+/**
+ * Gaussian blur, Canny and 3x3 dilation fused into one pass
+ *
+ * The only full-size intermediate is a one-byte class map for hysteresis,
+ * which the final dilation reads to write the binary edge map. Smoothing
+ * uses Q8 fixed-point weights; results may differ from the OpenCV pipeline
+ * by rounding.
+ */
+static void fused_edge_map(const cv::Mat &gray, int blur_kernel_size, int low, int high, cv::Mat &edges)
+{
+    edges.create(gray.rows, gray.cols, CV_8UC1);
+    if (gray.cols == 0 || gray.rows == 0)
+        return;
+
+    const EdgeKernel kernel(blur_kernel_size, low, high);
+    const int padded = gray.cols + 2;
+    std::vector<uint8_t> map(static_cast<size_t>(gray.rows + 2) * padded, EDGE_NONE);
+    std::vector<uint8_t *> strong;
+
+    classify_edge_rows(gray, kernel, 0, gray.rows, map.data(), strong);
+    grow_strong_edges(map.data(), padded, 0, gray.rows, strong);
+    dilate_edge_rows(map.data(), padded, 0, gray.rows, edges);
+}
+
+/**
+ * Weak components of one strip that touch its first or last row
+ */
+struct EdgeStrip
+{
+    int y0 = 0;
+    int y1 = 0;
+    std::vector<uint8_t *> strong;
+    std::vector<int> top_label;    // Component of each weak pixel in row y0 (-1 = none)
+    std::vector<int> bottom_label; // Component of each weak pixel in row y1 - 1
+    int num_labels = 0;
+    int first_label = 0; // Offset of this strip's labels in the union-find forest
+};
+
+/**
+ * Label the weak components of a strip that reach its boundary rows
+ *
+ * Runs after local hysteresis, so every remaining weak pixel belongs to a
+ * component without a strong pixel inside the strip.
+ */
+static void label_strip_boundary(uint8_t *map, int padded, int width, EdgeStrip &strip)
+{
+    strip.top_label.assign(width, -1);
+    strip.bottom_label.assign(width, -1);
+
+    uint8_t *first = map + static_cast<size_t>(strip.y0 + 1) * padded;
+    uint8_t *last = map + static_cast<size_t>(strip.y1 + 1) * padded;
+    const std::ptrdiff_t neighbours[8] = {-padded - 1, -padded, -padded + 1, -1, 1, padded - 1, padded, padded + 1};
+
+    std::vector<uint8_t *> stack;
+    auto record = [&](uint8_t *p, int label)
+    {
+        std::ptrdiff_t index = p - map;
+        int y = static_cast<int>(index / padded) - 1;
+        int x = static_cast<int>(index % padded) - 1;
+        if (y == strip.y0)
+            strip.top_label[x] = label;
+        if (y == strip.y1 - 1)
+            strip.bottom_label[x] = label;
+    };
+
+    for (int y : {strip.y0, strip.y1 - 1})
+    {
+        uint8_t *row = map + static_cast<size_t>(y + 1) * padded + 1;
+        for (int x = 0; x < width; x++)
+        {
+            if (row[x] != EDGE_WEAK)
+                continue;
+
+            int label = strip.num_labels++;
+            row[x] = EDGE_WEAK_SEEN;
+            stack.push_back(row + x);
+            while (!stack.empty())
+            {
+                uint8_t *p = stack.back();
+                stack.pop_back();
+                record(p, label);
+                for (std::ptrdiff_t offset : neighbours)
+                {
+                    uint8_t *q = p + offset;
+                    if (q >= first && q < last && *q == EDGE_WEAK)
+                    {
+                        *q = EDGE_WEAK_SEEN;
+                        stack.push_back(q);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static int find_root(std::vector<int> &parent, int i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+static void union_roots(std::vector<int> &parent, int a, int b)
+{
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    if (a != b)
+        parent[std::max(a, b)] = std::min(a, b);
+}
+
+/**
+ * Multi-threaded variant of fused_edge_map
+ *
+ * The image is split into horizontal strips. Each strip runs blur, gradients,
+ * NMS and local hysteresis on its own thread, recomputing its halo rows from
+ * the source. Weak components reaching a strip boundary are then joined
+ * across strips with a union-find forest; components connected to a strong
+ * pixel in any strip are promoted, giving the same edges as global
+ * hysteresis.
+ */
+static void parallel_edge_map(const cv::Mat &gray, int blur_kernel_size, int low, int high, cv::Mat &edges)
+{
+    const int width = gray.cols;
+    const int height = gray.rows;
+    edges.create(height, width, CV_8UC1);
+    if (width == 0 || height == 0)
+        return;
+
+    int num_strips = std::min(std::max(1, cv::getNumThreads()) * 2, height / MIN_STRIP_ROWS);
+    if (num_strips <= 1)
+    {
+        fused_edge_map(gray, blur_kernel_size, low, high, edges);
+        return;
+    }
+
+    const EdgeKernel kernel(blur_kernel_size, low, high);
+    const int padded = width + 2;
+    std::vector<uint8_t> map(static_cast<size_t>(height + 2) * padded, EDGE_NONE);
+    std::vector<EdgeStrip> strips(num_strips);
+    for (int s = 0; s < num_strips; s++)
+    {
+        strips[s].y0 = static_cast<int>(static_cast<int64_t>(height) * s / num_strips);
+        strips[s].y1 = static_cast<int>(static_cast<int64_t>(height) * (s + 1) / num_strips);
+    }
+
+    // Per strip: classify, local hysteresis, label boundary weak components
+    cv::parallel_for_(cv::Range(0, num_strips), [&](const cv::Range &range)
+                      {
+        for (int s = range.start; s < range.end; s++)
+        {
+            EdgeStrip &strip = strips[s];
+            classify_edge_rows(gray, kernel, strip.y0, strip.y1, map.data(), strip.strong);
+            grow_strong_edges(map.data(), padded, strip.y0, strip.y1, strip.strong);
+            label_strip_boundary(map.data(), padded, width, strip);
+        } });
+
+    // Union-find over boundary components; the last node stands for "strong"
+    int total = 0;
+    for (EdgeStrip &strip : strips)
+    {
+        strip.first_label = total;
+        total += strip.num_labels;
+    }
+    const int strong_node = total;
+    std::vector<int> parent(total + 1);
+    for (int i = 0; i <= total; i++)
+        parent[i] = i;
+
+    for (int s = 0; s + 1 < num_strips; s++)
+    {
+        const EdgeStrip &upper = strips[s];
+        const EdgeStrip &lower = strips[s + 1];
+        const uint8_t *a = map.data() + static_cast<size_t>(upper.y1) * padded + 1; // Row upper.y1 - 1
+        const uint8_t *b = a + padded;                                              // Row lower.y0
+
+        for (int x = 0; x < width; x++)
+        {
+            if (a[x] == EDGE_NONE)
+                continue;
+            for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); nx++)
+            {
+                if (b[nx] == EDGE_NONE || (a[x] == EDGE_STRONG && b[nx] == EDGE_STRONG))
+                    continue;
+                int la = a[x] == EDGE_STRONG ? strong_node : upper.first_label + upper.bottom_label[x];
+                int lb = b[nx] == EDGE_STRONG ? strong_node : lower.first_label + lower.top_label[nx];
+                union_roots(parent, la, lb);
+            }
+        }
+    }
+
+    std::vector<uint8_t> promoted(total, 0);
+    const int strong_root = find_root(parent, strong_node);
+    for (int i = 0; i < total; i++)
+        promoted[i] = find_root(parent, i) == strong_root;
+
+    // Per strip: promote connected boundary components, then dilate. Dilation
+    // reads one row of each neighbouring strip, so it waits for all promotions.
+    cv::parallel_for_(cv::Range(0, num_strips), [&](const cv::Range &range)
+                      {
+        for (int s = range.start; s < range.end; s++)
+        {
+            EdgeStrip &strip = strips[s];
+            for (int y : {strip.y0, strip.y1 - 1})
+            {
+                const std::vector<int> &labels = y == strip.y0 ? strip.top_label : strip.bottom_label;
+                uint8_t *row = map.data() + static_cast<size_t>(y + 1) * padded + 1;
+                for (int x = 0; x < width; x++)
+                {
+                    if (labels[x] >= 0 && row[x] == EDGE_WEAK_SEEN && promoted[strip.first_label + labels[x]])
+                    {
+                        row[x] = EDGE_STRONG;
+                        strip.strong.push_back(row + x);
+                    }
+                }
+            }
+            grow_strong_edges(map.data(), padded, strip.y0, strip.y1, strip.strong);
+        } });
+
+    cv::parallel_for_(cv::Range(0, num_strips), [&](const cv::Range &range)
+                      {
+        for (int s = range.start; s < range.end; s++)
+            dilate_edge_rows(map.data(), padded, strips[s].y0, strips[s].y1, edges); });
+}
+
+/**
+ * Threshold-independent half of fused_edge_map: blur, gradients and
+ * non-maximum suppression
+ *
+ * Writes the gradient magnitude of edge maxima above `floor` into a CV_16SC1
+ * map (0 elsewhere), from which threshold_edge_peaks builds edge maps for any
+ * threshold pair with low >= floor. Strips run concurrently.
+ */
+static void edge_peak_map(const cv::Mat &gray, int blur_kernel_size, int floor, cv::Mat &peaks)
+{
+    peaks.create(gray.rows, gray.cols, CV_16SC1);
+    if (gray.cols == 0 || gray.rows == 0)
+        return;
+
+    const EdgeKernel kernel(blur_kernel_size, floor, floor);
+    const int num_strips = std::max(1, std::min(std::max(1, cv::getNumThreads()) * 2, gray.rows / MIN_STRIP_ROWS));
+
+    cv::parallel_for_(cv::Range(0, num_strips), [&](const cv::Range &range)
+                      {
+        for (int s = range.start; s < range.end; s++)
+        {
+            int y0 = static_cast<int>(static_cast<int64_t>(gray.rows) * s / num_strips);
+            int y1 = static_cast<int>(static_cast<int64_t>(gray.rows) * (s + 1) / num_strips);
+            gradient_rows(gray, kernel, y0, y1,
+                          [&](int y, const int16_t *dx, const int16_t *dy,
+                              const int16_t *mag_prev, const int16_t *mag, const int16_t *mag_next)
+                          {
+                              int16_t *dst = peaks.ptr<int16_t>(y);
+                              for (int x = 0; x < gray.cols; x++)
+                              {
+                                  bool peak = mag[x] > kernel.low && is_edge_peak(dx[x], dy[x], mag_prev, mag, mag_next, x);
+                                  dst[x] = peak ? mag[x] : 0;
+                              }
+                          });
+        } });
+}
+
+/**
+ * Double threshold, hysteresis and 3x3 dilation of an edge_peak_map
+ *
+ * Gives the same edges as fused_edge_map with thresholds (low, high).
+ */
+static void threshold_edge_peaks(const cv::Mat &peaks, int low, int high, cv::Mat &edges)
+{
+    edges.create(peaks.rows, peaks.cols, CV_8UC1);
+    if (peaks.cols == 0 || peaks.rows == 0)
+        return;
+
+    const int padded = peaks.cols + 2;
+    std::vector<uint8_t> map(static_cast<size_t>(peaks.rows + 2) * padded, EDGE_NONE);
+    std::vector<uint8_t *> strong;
+
+    for (int y = 0; y < peaks.rows; y++)
+    {
+        const int16_t *src = peaks.ptr<int16_t>(y);
+        uint8_t *row = map.data() + static_cast<size_t>(y + 1) * padded + 1;
+        for (int x = 0; x < peaks.cols; x++)
+        {
+            if (src[x] > high)
+            {
+                row[x] = EDGE_STRONG;
+                strong.push_back(row + x);
+            }
+            else if (src[x] > low)
+            {
+                row[x] = EDGE_WEAK;
+            }
+        }
+    }
+
+    grow_strong_edges(map.data(), padded, 0, peaks.rows, strong);
+    dilate_edge_rows(map.data(), padded, 0, peaks.rows, edges);
+}
+
+// ============================================================================
+// External contour tracer (bounding-box rejection before tracing)
+// ============================================================================
+
+/**
+ * Horizontal run of equal pixels in one row
+ */
+struct PixelRun
+{
+    int y;
+    int x0;
+    int x1;       // Inclusive
+    int left_bg;  // Background run ending just left of a foreground run (-1 = image edge)
+};
+
+/**
+ * Split the rows of a binary image into foreground and background runs and
+ * join them into components (8-connected foreground, 4-connected background)
+ */
+static void label_runs(
+    const cv::Mat &binary,
+    std::vector<PixelRun> &fg,
+    std::vector<int> &fg_parent,
+    std::vector<PixelRun> &bg,
+    std::vector<int> &bg_parent)
+{
+    size_t prev_fg = 0, prev_bg = 0;
+    for (int y = 0; y < binary.rows; y++)
+    {
+        const uint8_t *row = binary.ptr<uint8_t>(y);
+        const size_t row_fg = fg.size(), row_bg = bg.size();
+
+        for (int x = 0; x < binary.cols;)
+        {
+            bool on = row[x] != 0;
+            int start = x;
+            while (x < binary.cols && (row[x] != 0) == on)
+                x++;
+
+            if (on)
+            {
+                int left = start > 0 ? static_cast<int>(bg.size()) - 1 : -1;
+                fg.push_back({y, start, x - 1, left});
+                fg_parent.push_back(static_cast<int>(fg_parent.size()));
+            }
+            else
+            {
+                bg.push_back({y, start, x - 1, -1});
+                bg_parent.push_back(static_cast<int>(bg_parent.size()));
+            }
+        }
+
+        // Join with the previous row; foreground runs also touch diagonally
+        for (size_t a = prev_fg, b = row_fg; a < row_fg && b < fg.size();)
+        {
+            if (fg[a].x0 <= fg[b].x1 + 1 && fg[b].x0 <= fg[a].x1 + 1)
+                union_roots(fg_parent, static_cast<int>(a), static_cast<int>(b));
+            if (fg[a].x1 < fg[b].x1)
+                a++;
+            else
+                b++;
+        }
+        for (size_t a = prev_bg, b = row_bg; a < row_bg && b < bg.size();)
+        {
+            if (bg[a].x0 <= bg[b].x1 && bg[b].x0 <= bg[a].x1)
+                union_roots(bg_parent, static_cast<int>(a), static_cast<int>(b));
+            if (bg[a].x1 < bg[b].x1)
+                a++;
+            else
+                b++;
+        }
+
+        prev_fg = row_fg;
+        prev_bg = row_bg;
+    }
+}
+
+/**
+ * Trace the outer border of the component whose first pixel (in raster
+ * order) is at `start`
+ *
+ * Suzuki-Abe outer border following. Points are compressed as with
+ * CHAIN_APPROX_SIMPLE.
+ *
+ * @return Area enclosed by the border (as cv::contourArea)
+ */
+static float trace_outer_border(const cv::Mat &binary, cv::Point start, std::vector<cv::Point> &contour)
+{
+    // Clockwise (y down) from east
+    static const int dx[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+    static const int dy[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    auto is_set = [&](int x, int y)
+    {
+        return x >= 0 && y >= 0 && x < binary.cols && y < binary.rows && binary.ptr<uint8_t>(y)[x] != 0;
+    };
+
+    contour.clear();
+
+    // Last border pixel: first set neighbour clockwise from the west
+    int first_dir = -1;
+    for (int k = 1; k <= 8 && first_dir < 0; k++)
+    {
+        int d = (4 + k) % 8;
+        if (is_set(start.x + dx[d], start.y + dy[d]))
+            first_dir = d;
+    }
+    if (first_dir < 0)
+    {
+        contour.push_back(start);
+        return 0;
+    }
+
+    const cv::Point last(start.x + dx[first_dir], start.y + dy[first_dir]);
+    cv::Point current = start;
+    int back_dir = first_dir; // Direction from current to the previous border pixel
+    int prev_move = -1;
+    double twice_area = 0;
+
+    while (true)
+    {
+        // Next border pixel: first set neighbour counter-clockwise after the previous one
+        int move = back_dir;
+        for (int k = 1; k <= 8; k++)
+        {
+            int d = (back_dir + 8 - k) % 8;
+            if (is_set(current.x + dx[d], current.y + dy[d]))
+            {
+                move = d;
+                break;
+            }
+        }
+
+        cv::Point next(current.x + dx[move], current.y + dy[move]);
+        twice_area += static_cast<double>(current.x) * next.y - static_cast<double>(next.x) * current.y;
+
+        // Keep only the points where the chain turns
+        if (move != prev_move)
+            contour.push_back(current);
+        prev_move = move;
+
+        if (next == start && current == last)
+            break;
+
+        current = next;
+        back_dir = (move + 4) % 8;
+    }
+
+    return static_cast<float>(std::abs(twice_area) / 2);
+}
+
+/**
+ * External contours of a binary image whose enclosed area is at least
+ * min_area (same contours as findContours with RETR_EXTERNAL and
+ * CHAIN_APPROX_SIMPLE, minus the small ones)
+ *
+ * Components are labelled on row runs first. A component can only enclose
+ * as much area as its bounding box, so small blobs and components nested
+ * inside other components' holes are rejected without being traced.
+ */
+static void trace_external_contours(
+    const cv::Mat &binary,
+    float min_area,
+    std::vector<std::vector<cv::Point>> &contours)
+{
+    std::vector<PixelRun> fg, bg;
+    std::vector<int> fg_parent, bg_parent;
+    label_runs(binary, fg, fg_parent, bg, bg_parent);
+
+    // Background connected to the image border is the outside
+    std::vector<uint8_t> outside(bg.size(), 0);
+    for (size_t i = 0; i < bg.size(); i++)
+    {
+        const PixelRun &run = bg[i];
+        if (run.y == 0 || run.y == binary.rows - 1 || run.x0 == 0 || run.x1 == binary.cols - 1)
+            outside[find_root(bg_parent, static_cast<int>(i))] = 1;
+    }
+
+    // Per component (indexed by its root, which is its first run in raster
+    // order): bounding box, and whether any run touches the outside
+    struct ComponentBox
+    {
+        int x0 = INT_MAX, y0 = INT_MAX, x1 = -1, y1 = -1;
+        bool external = false;
+    };
+    std::vector<ComponentBox> boxes(fg.size());
+    for (size_t i = 0; i < fg.size(); i++)
+    {
+        const PixelRun &run = fg[i];
+        ComponentBox &box = boxes[find_root(fg_parent, static_cast<int>(i))];
+        box.x0 = std::min(box.x0, run.x0);
+        box.x1 = std::max(box.x1, run.x1);
+        box.y0 = std::min(box.y0, run.y);
+        box.y1 = std::max(box.y1, run.y);
+        if (run.left_bg < 0 || outside[find_root(bg_parent, run.left_bg)])
+            box.external = true;
+    }
+
+    std::vector<cv::Point> contour;
+    for (size_t i = 0; i < fg.size(); i++)
+    {
+        const ComponentBox &box = boxes[i];
+        if (fg_parent[i] != static_cast<int>(i) || !box.external)
+            continue;
+
+        // The border runs through pixel centres, hence the -1
+        if (static_cast<float>(box.x1 - box.x0) * (box.y1 - box.y0) < min_area)
+            continue;
+
+        if (trace_outer_border(binary, cv::Point(fg[i].x0, fg[i].y), contour) >= min_area)
+            contours.push_back(contour);
+    }
+}
+
+// ============================================================================
+// Perspective warp (fixed-point bilinear, tile-parallel)
+// ============================================================================
+
+// Bilinear weights are Q7: the two weights of each axis sum to WARP_ONE, so a
+// blended row value fits 16 bits and the final sum 32 bits
+static const int WARP_WEIGHT_BITS = 7;
+static const int WARP_ONE = 1 << WARP_WEIGHT_BITS;
+
+// Output tiles processed per task; a 64x64 tile reads a compact source patch
+// whatever the orientation of the quad
+static const int WARP_TILE_SIZE = 64;
+
+/**
+ * Fixed-point source positions of output pixels (x0 .. x0 + n - 1, y)
+ *
+ * H maps output pixel centres to source pixel coordinates. Positions are
+ * clamped to the source (edge pixels repeat) and stored as the byte offset
+ * of the top-left neighbour plus Q7 horizontal and vertical weights of the
+ * right and bottom neighbours. The source must be at least 2x2.
+ */
+static void warp_map_row(const cv::Matx33d &H, int x0, int y, int n,
+                         cv::Size src_size, int src_step, int channels,
+                         int32_t *offset, uint8_t *wx, uint8_t *wy)
+{
+    // Row constants in double; per-pixel work in float is exact to far below 1/128 pixel
+    const double yc = y + 0.5;
+    const float bx = static_cast<float>(H(0, 1) * yc + H(0, 2));
+    const float by = static_cast<float>(H(1, 1) * yc + H(1, 2));
+    const float bw = static_cast<float>(H(2, 1) * yc + H(2, 2));
+    const float h0 = static_cast<float>(H(0, 0));
+    const float h1 = static_cast<float>(H(1, 0));
+    const float h2 = static_cast<float>(H(2, 0));
+    const float max_x = static_cast<float>(src_size.width - 1);
+    const float max_y = static_cast<float>(src_size.height - 1);
+
+    int i = 0;
+#if defined(HG_SIMD_NEON)
+    const float32x4_t ramp = {0.5f, 1.5f, 2.5f, 3.5f};
+    auto map_lanes = [&](float32x4_t xs, int32x4_t &off, int32x4_t &fx, int32x4_t &fy)
+    {
+        float32x4_t w = vmlaq_n_f32(vdupq_n_f32(bw), xs, h2);
+        float32x4_t inv = vrecpeq_f32(w);
+        inv = vmulq_f32(inv, vrecpsq_f32(w, inv));
+        inv = vmulq_f32(inv, vrecpsq_f32(w, inv));
+        float32x4_t sx = vmulq_f32(vmlaq_n_f32(vdupq_n_f32(bx), xs, h0), inv);
+        float32x4_t sy = vmulq_f32(vmlaq_n_f32(vdupq_n_f32(by), xs, h1), inv);
+
+        // vmaxq propagates NaN: send w <= 0 and NaN lanes to the top-left pixel first
+        uint32x4_t ok = vandq_u32(vcgtq_f32(w, vdupq_n_f32(0)), vandq_u32(vceqq_f32(sx, sx), vceqq_f32(sy, sy)));
+        sx = vbslq_f32(ok, sx, vdupq_n_f32(0));
+        sy = vbslq_f32(ok, sy, vdupq_n_f32(0));
+        sx = vminq_f32(vmaxq_f32(sx, vdupq_n_f32(0)), vdupq_n_f32(max_x));
+        sy = vminq_f32(vmaxq_f32(sy, vdupq_n_f32(0)), vdupq_n_f32(max_y));
+
+        // Non-negative, so truncation is floor; the last row/column blends from the one before
+        int32x4_t ix = vminq_s32(vcvtq_s32_f32(sx), vdupq_n_s32(src_size.width - 2));
+        int32x4_t iy = vminq_s32(vcvtq_s32_f32(sy), vdupq_n_s32(src_size.height - 2));
+        const float32x4_t one = vdupq_n_f32(static_cast<float>(WARP_ONE));
+        const float32x4_t half = vdupq_n_f32(0.5f);
+        fx = vcvtq_s32_f32(vmlaq_f32(half, vsubq_f32(sx, vcvtq_f32_s32(ix)), one));
+        fy = vcvtq_s32_f32(vmlaq_f32(half, vsubq_f32(sy, vcvtq_f32_s32(iy)), one));
+        off = vmlaq_n_s32(vmulq_n_s32(iy, src_step), ix, channels);
+    };
+    for (; i <= n - 8; i += 8)
+    {
+        float32x4_t xs = vaddq_f32(vdupq_n_f32(static_cast<float>(x0 + i)), ramp);
+        int32x4_t off_lo, off_hi, fx_lo, fx_hi, fy_lo, fy_hi;
+        map_lanes(xs, off_lo, fx_lo, fy_lo);
+        map_lanes(vaddq_f32(xs, vdupq_n_f32(4.0f)), off_hi, fx_hi, fy_hi);
+
+        vst1q_s32(offset + i, off_lo);
+        vst1q_s32(offset + i + 4, off_hi);
+        vst1_u8(wx + i, vqmovn_u16(vcombine_u16(vqmovun_s32(fx_lo), vqmovun_s32(fx_hi))));
+        vst1_u8(wy + i, vqmovn_u16(vcombine_u16(vqmovun_s32(fy_lo), vqmovun_s32(fy_hi))));
+    }
+#elif defined(HG_SIMD_AVX2)
+    const __m256 ramp = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 one = _mm256_set1_ps(static_cast<float>(WARP_ONE));
+    auto narrow = [](__m256i v)
+    {
+        __m128i r = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        return _mm_packus_epi16(r, r);
+    };
+    for (; i <= n - 8; i += 8)
+    {
+        __m256 xs = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x0 + i)), ramp);
+        __m256 w = _mm256_add_ps(_mm256_set1_ps(bw), _mm256_mul_ps(xs, _mm256_set1_ps(h2)));
+        __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), w);
+        __m256 sx = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps(bx), _mm256_mul_ps(xs, _mm256_set1_ps(h0))), inv);
+        __m256 sy = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps(by), _mm256_mul_ps(xs, _mm256_set1_ps(h1))), inv);
+
+        // w <= 0 lanes go to the top-left pixel; max_ps returns its second operand for NaN
+        __m256 ok = _mm256_cmp_ps(w, _mm256_setzero_ps(), _CMP_GT_OQ);
+        sx = _mm256_and_ps(sx, ok);
+        sy = _mm256_and_ps(sy, ok);
+        sx = _mm256_min_ps(_mm256_max_ps(sx, _mm256_setzero_ps()), _mm256_set1_ps(max_x));
+        sy = _mm256_min_ps(_mm256_max_ps(sy, _mm256_setzero_ps()), _mm256_set1_ps(max_y));
+
+        __m256i ix = _mm256_min_epi32(_mm256_cvttps_epi32(sx), _mm256_set1_epi32(src_size.width - 2));
+        __m256i iy = _mm256_min_epi32(_mm256_cvttps_epi32(sy), _mm256_set1_epi32(src_size.height - 2));
+        __m256i fx = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_sub_ps(sx, _mm256_cvtepi32_ps(ix)), one));
+        __m256i fy = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_sub_ps(sy, _mm256_cvtepi32_ps(iy)), one));
+        __m256i off = _mm256_add_epi32(_mm256_mullo_epi32(iy, _mm256_set1_epi32(src_step)),
+                                       _mm256_mullo_epi32(ix, _mm256_set1_epi32(channels)));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(offset + i), off);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(wx + i), narrow(fx));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(wy + i), narrow(fy));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        float xs = x0 + i + 0.5f;
+        float w = bw + h2 * xs;
+        float sx = 0, sy = 0;
+        if (w > 0)
+        {
+            sx = (bx + h0 * xs) / w;
+            sy = (by + h1 * xs) / w;
+        }
+
+        // std::max(0, NaN) is 0, so non-finite coordinates clamp to the border too
+        sx = std::min(std::max(0.0f, sx), max_x);
+        sy = std::min(std::max(0.0f, sy), max_y);
+
+        int ix = std::min(static_cast<int>(sx), src_size.width - 2);
+        int iy = std::min(static_cast<int>(sy), src_size.height - 2);
+        offset[i] = iy * src_step + ix * channels;
+        wx[i] = static_cast<uint8_t>(cvRound((sx - ix) * WARP_ONE));
+        wy[i] = static_cast<uint8_t>(cvRound((sy - iy) * WARP_ONE));
+    }
+}
+
+/**
+ * Bilinear blend of n output pixels from their fixed-point map
+ *
+ * Neighbour reads never leave the 2x2 block at offset, so any source buffer
+ * of src_step * height bytes is safe.
+ */
+static void warp_blend_row(const uint8_t *src, int src_step, int channels,
+                           const int32_t *offset, const uint8_t *wx, const uint8_t *wy,
+                           uint8_t *dst, int n)
+{
+    const int shift = 2 * WARP_WEIGHT_BITS;
+    int i = 0;
+#if defined(HG_SIMD_NEON)
+    if (channels == 1)
+    {
+        for (; i <= n - 8; i += 8)
+        {
+            // No gather on NEON: collect the neighbours, blend 8 pixels at once
+            uint8_t p00[8], p01[8], p10[8], p11[8];
+            for (int k = 0; k < 8; k++)
+            {
+                const uint8_t *p = src + offset[i + k];
+                p00[k] = p[0];
+                p01[k] = p[1];
+                p10[k] = p[src_step];
+                p11[k] = p[src_step + 1];
+            }
+            uint16x8_t fx = vmovl_u8(vld1_u8(wx + i));
+            uint16x8_t fy = vmovl_u8(vld1_u8(wy + i));
+            uint16x8_t ifx = vsubq_u16(vdupq_n_u16(WARP_ONE), fx);
+            uint16x8_t ify = vsubq_u16(vdupq_n_u16(WARP_ONE), fy);
+            uint16x8_t top = vmlaq_u16(vmulq_u16(vmovl_u8(vld1_u8(p00)), ifx), vmovl_u8(vld1_u8(p01)), fx);
+            uint16x8_t bottom = vmlaq_u16(vmulq_u16(vmovl_u8(vld1_u8(p10)), ifx), vmovl_u8(vld1_u8(p11)), fx);
+            uint32x4_t lo = vmlal_u16(vmull_u16(vget_low_u16(top), vget_low_u16(ify)), vget_low_u16(bottom), vget_low_u16(fy));
+            uint32x4_t hi = vmlal_u16(vmull_u16(vget_high_u16(top), vget_high_u16(ify)), vget_high_u16(bottom), vget_high_u16(fy));
+            vst1_u8(dst + i, vmovn_u16(vcombine_u16(vrshrn_n_u32(lo, 14), vrshrn_n_u32(hi, 14))));
+        }
+    }
+    else if (channels == 4)
+    {
+        for (; i < n; i++)
+        {
+            // Both neighbours of a row in one 8-byte load
+            const uint8_t *p = src + offset[i];
+            const int fx = wx[i], fy = wy[i];
+            uint16x8_t w = vcombine_u16(vdup_n_u16(static_cast<uint16_t>(WARP_ONE - fx)), vdup_n_u16(static_cast<uint16_t>(fx)));
+            uint16x8_t t = vmulq_u16(vmovl_u8(vld1_u8(p)), w);
+            uint16x8_t b = vmulq_u16(vmovl_u8(vld1_u8(p + src_step)), w);
+            uint16x4_t top = vadd_u16(vget_low_u16(t), vget_high_u16(t));
+            uint16x4_t bottom = vadd_u16(vget_low_u16(b), vget_high_u16(b));
+            uint32x4_t sum = vmlal_n_u16(vmull_n_u16(top, static_cast<uint16_t>(WARP_ONE - fy)), bottom, static_cast<uint16_t>(fy));
+            uint16x4_t r = vrshrn_n_u32(sum, 14);
+            vst1_lane_u32(reinterpret_cast<uint32_t *>(dst + i * 4), vreinterpret_u32_u8(vmovn_u16(vcombine_u16(r, r))), 0);
+        }
+    }
+#elif defined(HG_SIMD_AVX2)
+    if (channels == 1)
+    {
+        // Gather 4 bytes per row: p00 p01 from the top row at offset, and the
+        // bottom pair as the last two bytes at offset + step - 2 (stays inside
+        // the source on the last row)
+        const int *top_base = reinterpret_cast<const int *>(src);
+        const int *bottom_base = reinterpret_cast<const int *>(src + src_step - 2);
+        const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+        const __m256i one = _mm256_set1_epi32(WARP_ONE);
+        const __m256i round = _mm256_set1_epi32(1 << (shift - 1));
+        for (; i <= n - 8; i += 8)
+        {
+            __m256i off = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(offset + i));
+            __m256i t = _mm256_i32gather_epi32(top_base, off, 1);
+            __m256i b = _mm256_i32gather_epi32(bottom_base, off, 1);
+            __m256i p00 = _mm256_and_si256(t, byte_mask);
+            __m256i p01 = _mm256_and_si256(_mm256_srli_epi32(t, 8), byte_mask);
+            __m256i p10 = _mm256_and_si256(_mm256_srli_epi32(b, 16), byte_mask);
+            __m256i p11 = _mm256_srli_epi32(b, 24);
+
+            __m256i fx = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(wx + i)));
+            __m256i fy = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(wy + i)));
+            __m256i top = _mm256_add_epi32(_mm256_slli_epi32(p00, WARP_WEIGHT_BITS),
+                                           _mm256_mullo_epi32(_mm256_sub_epi32(p01, p00), fx));
+            __m256i bottom = _mm256_add_epi32(_mm256_slli_epi32(p10, WARP_WEIGHT_BITS),
+                                              _mm256_mullo_epi32(_mm256_sub_epi32(p11, p10), fx));
+            __m256i sum = _mm256_add_epi32(_mm256_mullo_epi32(top, _mm256_sub_epi32(one, fy)),
+                                           _mm256_mullo_epi32(bottom, fy));
+            sum = _mm256_srli_epi32(_mm256_add_epi32(sum, round), shift);
+
+            __m128i r = _mm_packus_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(r, r));
+        }
+    }
+    else if (channels == 4)
+    {
+        const __m128i round = _mm_set1_epi32(1 << (shift - 1));
+        for (; i < n; i++)
+        {
+            // Both neighbours of a row in one 8-byte load
+            const uint8_t *p = src + offset[i];
+            const int fx = wx[i], fy = wy[i];
+            __m128i w = _mm_setr_epi16(WARP_ONE - fx, WARP_ONE - fx, WARP_ONE - fx, WARP_ONE - fx, fx, fx, fx, fx);
+            __m128i t = _mm_mullo_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))), w);
+            __m128i b = _mm_mullo_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + src_step))), w);
+            t = _mm_add_epi16(t, _mm_srli_si128(t, 8));
+            b = _mm_add_epi16(b, _mm_srli_si128(b, 8));
+
+            // Rows interleaved per channel, blended vertically with one madd
+            __m128i sum = _mm_madd_epi16(_mm_unpacklo_epi16(t, b), _mm_set1_epi32((fy << 16) | (WARP_ONE - fy)));
+            sum = _mm_srli_epi32(_mm_add_epi32(sum, round), shift);
+            __m128i r = _mm_packus_epi32(sum, sum);
+            int packed = _mm_cvtsi128_si32(_mm_packus_epi16(r, r));
+            std::memcpy(dst + i * 4, &packed, 4);
+        }
+    }
+#endif
+    for (; i < n; i++)
+    {
+        const uint8_t *p = src + offset[i];
+        const int fx = wx[i], fy = wy[i];
+        for (int c = 0; c < channels; c++)
+        {
+            int top = p[c] * (WARP_ONE - fx) + p[c + channels] * fx;
+            int bottom = p[c + src_step] * (WARP_ONE - fx) + p[c + src_step + channels] * fx;
+            dst[i * channels + c] = static_cast<uint8_t>((top * (WARP_ONE - fy) + bottom * fy + (1 << (shift - 1))) >> shift);
+        }
+    }
+}
+
+/**
+ * Number of warp tiles covering an output image
+ */
+static int warp_tile_count(cv::Size out_size)
+{
+    return ((out_size.width + WARP_TILE_SIZE - 1) / WARP_TILE_SIZE) *
+           ((out_size.height + WARP_TILE_SIZE - 1) / WARP_TILE_SIZE);
+}
+
+/**
+ * Output rectangle of warp tile t (row-major)
+ */
+static cv::Rect warp_tile(int t, cv::Size out_size)
+{
+    const int tiles_x = (out_size.width + WARP_TILE_SIZE - 1) / WARP_TILE_SIZE;
+    const int x0 = (t % tiles_x) * WARP_TILE_SIZE;
+    const int y0 = (t / tiles_x) * WARP_TILE_SIZE;
+    return cv::Rect(x0, y0, std::min(WARP_TILE_SIZE, out_size.width - x0), std::min(WARP_TILE_SIZE, out_size.height - y0));
+}
+
+/**
+ * Warp src into dst (same channels) through H, output pixel -> source pixel,
+ * with the fixed-point bilinear kernels; tiles run in parallel
+ */
+static void warp_perspective_fixed(const cv::Mat &src, const cv::Matx33d &H, cv::Mat &dst)
+{
+    const int channels = src.channels();
+    const int src_step = static_cast<int>(src.step);
+
+    cv::parallel_for_(cv::Range(0, warp_tile_count(dst.size())), [&](const cv::Range &range)
+                      {
+        int32_t offset[WARP_TILE_SIZE];
+        uint8_t wx[WARP_TILE_SIZE], wy[WARP_TILE_SIZE];
+
+        for (int t = range.start; t < range.end; t++)
+        {
+            const cv::Rect tile = warp_tile(t, dst.size());
+            for (int y = tile.y; y < tile.y + tile.height; y++)
+            {
+                warp_map_row(H, tile.x, y, tile.width, src.size(), src_step, channels, offset, wx, wy);
+                warp_blend_row(src.data, src_step, channels, offset, wx, wy,
+                               dst.ptr<uint8_t>(y) + tile.x * channels, tile.width);
+            }
+        } });
+}
+
+/**
+ * Largest distance in source pixels between where two homographies send the
+ * corner pixels of an output rectangle
+ *
+ * Two nearby homographies differ smoothly, so over a warp tile the corners
+ * bound the difference closely.
+ */
+static double warp_tile_deviation(const cv::Matx33d &A, const cv::Matx33d &B, cv::Rect tile)
+{
+    double deviation = 0;
+    for (int corner = 0; corner < 4; corner++)
+    {
+        double x = (corner & 1) ? tile.x + tile.width - 0.5 : tile.x + 0.5;
+        double y = (corner & 2) ? tile.y + tile.height - 0.5 : tile.y + 0.5;
+
+        double wa = A(2, 0) * x + A(2, 1) * y + A(2, 2);
+        double wb = B(2, 0) * x + B(2, 1) * y + B(2, 2);
+        double dx = (A(0, 0) * x + A(0, 1) * y + A(0, 2)) / wa - (B(0, 0) * x + B(0, 1) * y + B(0, 2)) / wb;
+        double dy = (A(1, 0) * x + A(1, 1) * y + A(1, 2)) / wa - (B(1, 0) * x + B(1, 1) * y + B(1, 2)) / wb;
+        deviation = std::max(deviation, std::sqrt(dx * dx + dy * dy));
+    }
+    return deviation;
+}
+
+/**
+ * Output pixel -> source pixel homography of a paper quad warped to out_size
+ *
+ * The output rectangle's outer edges map onto the quad corners (TL, TR, BR, BL).
+ */
+static cv::Matx33d rectify_homography(const float *corners, cv::Size out_size)
+{
+    std::vector<cv::Point2f> rect = {
+        {0, 0},
+        {static_cast<float>(out_size.width), 0},
+        {static_cast<float>(out_size.width), static_cast<float>(out_size.height)},
+        {0, static_cast<float>(out_size.height)}};
+    std::vector<cv::Point2f> quad(4);
+    for (int i = 0; i < 4; i++)
+    {
+        quad[i] = cv::Point2f(corners[i * 2], corners[i * 2 + 1]);
+    }
+
+    cv::Mat H = cv::getPerspectiveTransform(rect, quad);
+    return cv::Matx33d(H.ptr<double>());
+}
+
+// ============================================================================
+// Batched point transforms (SIMD)
+// ============================================================================
+
+/**
+ * Map n points through a homography, in place if in == out
+ *
+ * Interleaved arrays hold x0,y0,x1,y1,...; SoA arrays hold x0..xn-1 followed
+ * by y0..yn-1. Every block is loaded before it is stored, so aliasing in and
+ * out is safe. Points on the line at infinity (w = 0) come out non-finite.
+ */
+static void transform_points(const cv::Matx33d &H, const float *in, float *out, int n, int layout)
+{
+    const float h00 = static_cast<float>(H(0, 0)), h01 = static_cast<float>(H(0, 1)), h02 = static_cast<float>(H(0, 2));
+    const float h10 = static_cast<float>(H(1, 0)), h11 = static_cast<float>(H(1, 1)), h12 = static_cast<float>(H(1, 2));
+    const float h20 = static_cast<float>(H(2, 0)), h21 = static_cast<float>(H(2, 1)), h22 = static_cast<float>(H(2, 2));
+    const bool soa = layout == HG_POINTS_SOA;
+    const float *in_y = in + n;
+    float *out_y = out + n;
+
+    int i = 0;
+#if defined(HG_SIMD_NEON)
+    auto map_lanes = [&](float32x4_t x, float32x4_t y, float32x4_t &tx, float32x4_t &ty)
+    {
+        float32x4_t w = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(h22), x, h20), y, h21);
+        float32x4_t inv = vrecpeq_f32(w);
+        inv = vmulq_f32(inv, vrecpsq_f32(w, inv));
+        inv = vmulq_f32(inv, vrecpsq_f32(w, inv));
+        tx = vmulq_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(h02), x, h00), y, h01), inv);
+        ty = vmulq_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(h12), x, h10), y, h11), inv);
+    };
+    if (soa)
+    {
+        for (; i <= n - 4; i += 4)
+        {
+            float32x4_t tx, ty;
+            map_lanes(vld1q_f32(in + i), vld1q_f32(in_y + i), tx, ty);
+            vst1q_f32(out + i, tx);
+            vst1q_f32(out_y + i, ty);
+        }
+    }
+    else
+    {
+        for (; i <= n - 4; i += 4)
+        {
+            float32x4x2_t xy = vld2q_f32(in + 2 * i);
+            map_lanes(xy.val[0], xy.val[1], xy.val[0], xy.val[1]);
+            vst2q_f32(out + 2 * i, xy);
+        }
+    }
+#elif defined(HG_SIMD_AVX2)
+    auto map_lanes = [&](__m256 x, __m256 y, __m256 &tx, __m256 &ty)
+    {
+        __m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(h20)),
+                                               _mm256_mul_ps(y, _mm256_set1_ps(h21))),
+                                 _mm256_set1_ps(h22));
+        __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), w);
+        tx = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(h00)),
+                                                       _mm256_mul_ps(y, _mm256_set1_ps(h01))),
+                                         _mm256_set1_ps(h02)),
+                           inv);
+        ty = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(h10)),
+                                                       _mm256_mul_ps(y, _mm256_set1_ps(h11))),
+                                         _mm256_set1_ps(h12)),
+                           inv);
+    };
+    if (soa)
+    {
+        for (; i <= n - 8; i += 8)
+        {
+            __m256 tx, ty;
+            map_lanes(_mm256_loadu_ps(in + i), _mm256_loadu_ps(in_y + i), tx, ty);
+            _mm256_storeu_ps(out + i, tx);
+            _mm256_storeu_ps(out_y + i, ty);
+        }
+    }
+    else
+    {
+        for (; i <= n - 8; i += 8)
+        {
+            // Deinterleave per 128-bit lane (points 0,1,4,5 | 2,3,6,7); unpack restores the order
+            __m256 a = _mm256_loadu_ps(in + 2 * i);
+            __m256 b = _mm256_loadu_ps(in + 2 * i + 8);
+            __m256 tx, ty;
+            map_lanes(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                      _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), tx, ty);
+            _mm256_storeu_ps(out + 2 * i, _mm256_unpacklo_ps(tx, ty));
+            _mm256_storeu_ps(out + 2 * i + 8, _mm256_unpackhi_ps(tx, ty));
+        }
+    }
+#endif
+    for (; i < n; i++)
+    {
+        const float x = soa ? in[i] : in[2 * i];
+        const float y = soa ? in_y[i] : in[2 * i + 1];
+        const float inv = 1.0f / (h20 * x + h21 * y + h22);
+        const float tx = (h00 * x + h01 * y + h02) * inv;
+        const float ty = (h10 * x + h11 * y + h12) * inv;
+        if (soa)
+        {
+            out[i] = tx;
+            out_y[i] = ty;
+        }
+        else
+        {
+            out[2 * i] = tx;
+            out[2 * i + 1] = ty;
+        }
+    }
+}
+
+extern "C"
+{
+
+    HomographyResult hg_find_homography(
+        const uint8_t *anchor_bytes, size_t anchor_size,
+        const uint8_t *scene_bytes, size_t scene_size)
+    {
+        return hg_find_homography_ex(anchor_bytes, anchor_size, scene_bytes, scene_size, nullptr);
+    }
+
+    HomographyResult hg_find_homography_ex(
+        const uint8_t *anchor_bytes, size_t anchor_size,
+        const uint8_t *scene_bytes, size_t scene_size,
+        const HgDecodeOptions *options)
+    {
+        return hg_find_homography_pose(anchor_bytes, anchor_size, scene_bytes, scene_size, options, nullptr, nullptr);
+    }
+
+    HomographyResult hg_find_homography_pose(
+        const uint8_t *anchor_bytes, size_t anchor_size,
+        const uint8_t *scene_bytes, size_t scene_size,
+        const HgDecodeOptions *options,
+        const HgCameraIntrinsics *intrinsics,
+        HgPose *out_pose)
+    {
+        HomographyResult result = {};
+        if (out_pose != nullptr)
+            *out_pose = HgPose{};
+        CaptureScope capture(HG_CALL_FIND_HOMOGRAPHY);
+        capture.options(options);
+        capture.intrinsics(intrinsics);
+        capture.field<uint64_t>(anchor_size);
+        capture.field<uint64_t>(scene_size);
+        capture.blob(anchor_bytes, anchor_size);
+        capture.blob(scene_bytes, scene_size);
+        CallStatsScope call_stats;
+        StageTimer stages;
+
+        // Validate input
+        if (anchor_bytes == nullptr || scene_bytes == nullptr)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        if (anchor_size == 0 || scene_size == 0)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        // Decode anchor image
+        stages.begin("decode");
+        cv::Size anchor_original;
+        int anchor_orientation;
+        cv::Mat anchor = decode_gray(anchor_bytes, anchor_size, options, anchor_original, anchor_orientation);
+
+        if (anchor.empty())
+        {
+            result.status = -2;
+            return result;
+        }
+
+        // Decode scene image
+        cv::Size scene_original;
+        int scene_orientation;
+        cv::Mat scene = decode_gray(scene_bytes, scene_size, options, scene_original, scene_orientation);
+
+        if (scene.empty())
+        {
+            result.status = -3;
+            return result;
+        }
+
+        stages.end();
+        bool want_pose = out_pose != nullptr && intrinsics != nullptr && intrinsics->focal_length > 0;
+        std::vector<cv::Point2f> inlier_anchor, inlier_scene;
+        result = compute_homography_internal(anchor, scene,
+                                             want_pose ? &inlier_anchor : nullptr,
+                                             want_pose ? &inlier_scene : nullptr);
+
+        // Map results back to original pixel coordinates
+        if (result.status == 1 && (anchor.size() != anchor_original || scene.size() != scene_original))
+        {
+            scale_homography_result(result,
+                                    static_cast<double>(anchor_original.width) / anchor.cols,
+                                    static_cast<double>(anchor_original.height) / anchor.rows,
+                                    static_cast<double>(scene_original.width) / scene.cols,
+                                    static_cast<double>(scene_original.height) / scene.rows);
+        }
+
+        // Apply deferred EXIF orientation
+        if (result.status == 1 && (anchor_orientation != 1 || scene_orientation != 1))
+        {
+            orient_homography_result(result, anchor_orientation, anchor_original, scene_orientation, scene_original);
+        }
+
+        // Pose in the frame of the results: inliers go through the same mappings
+        if (result.status == 1 && want_pose)
+        {
+            stages.begin("pose");
+            cv::Size anchor_displayed, scene_displayed;
+            cv::Matx33d anchor_map = orientation_matrix(anchor_orientation, anchor_original, anchor_displayed) *
+                                     resize_matrix(static_cast<double>(anchor_original.width) / anchor.cols,
+                                                   static_cast<double>(anchor_original.height) / anchor.rows);
+            cv::Matx33d scene_map = orientation_matrix(scene_orientation, scene_original, scene_displayed) *
+                                    resize_matrix(static_cast<double>(scene_original.width) / scene.cols,
+                                                  static_cast<double>(scene_original.height) / scene.rows);
+            map_points_affine(inlier_anchor, anchor_map);
+            map_points_affine(inlier_scene, scene_map);
+            solve_anchor_pose(*out_pose, inlier_anchor, inlier_scene, *intrinsics, anchor_displayed.width, scene_displayed);
+        }
+        return result;
+    }
+
+    HomographyResult hg_find_homography_file(
+        const char *anchor_path, const char *scene_path,
+        const HgDecodeOptions *options)
+    {
+        HomographyResult result = {};
+
+        MappedFile anchor(anchor_path);
+        if (anchor.data == nullptr)
+        {
+            result.status = -2;
+            return result;
+        }
+
+        MappedFile scene(scene_path);
+        if (scene.data == nullptr)
+        {
+            result.status = -3;
+            return result;
+        }
+
+        return hg_find_homography_ex(anchor.data, anchor.size, scene.data, scene.size, options);
+    }
+
+    HomographyResult hg_find_homography_raw(
+        const uint8_t *anchor_data, int anchor_width, int anchor_height, int anchor_channels,
+        const uint8_t *scene_data, int scene_width, int scene_height, int scene_channels)
+    {
+        return hg_find_homography_raw_pose(anchor_data, anchor_width, anchor_height, anchor_channels,
+                                           scene_data, scene_width, scene_height, scene_channels, nullptr, nullptr);
+    }
+
+    HomographyResult hg_find_homography_raw_pose(
+        const uint8_t *anchor_data, int anchor_width, int anchor_height, int anchor_channels,
+        const uint8_t *scene_data, int scene_width, int scene_height, int scene_channels,
+        const HgCameraIntrinsics *intrinsics,
+        HgPose *out_pose)
+    {
+        HomographyResult result = {};
+        if (out_pose != nullptr)
+            *out_pose = HgPose{};
+        CaptureScope capture(HG_CALL_FIND_HOMOGRAPHY_RAW);
+        CallStatsScope call_stats;
+        StageTimer stages;
+
+        // Validate input
+        if (anchor_data == nullptr || scene_data == nullptr)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        if (anchor_width <= 0 || anchor_height <= 0 ||
+            scene_width <= 0 || scene_height <= 0)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        if (anchor_channels != 1 && anchor_channels != 3 && anchor_channels != 4)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        if (scene_channels != 1 && scene_channels != 3 && scene_channels != 4)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        capture.intrinsics(intrinsics);
+        capture.field<int32_t>(anchor_width);
+        capture.field<int32_t>(anchor_height);
+        capture.field<int32_t>(anchor_channels);
+        capture.field<int32_t>(scene_width);
+        capture.field<int32_t>(scene_height);
+        capture.field<int32_t>(scene_channels);
+        capture.blob(anchor_data, static_cast<size_t>(anchor_width) * anchor_height * anchor_channels);
+        capture.blob(scene_data, static_cast<size_t>(scene_width) * scene_height * scene_channels);
+
+        // Create cv::Mat from raw data
+        int anchor_type = anchor_channels == 1 ? CV_8UC1 : anchor_channels == 3 ? CV_8UC3
+                                                                                : CV_8UC4;
+        int scene_type = scene_channels == 1 ? CV_8UC1 : scene_channels == 3 ? CV_8UC3
+                                                                             : CV_8UC4;
 
         cv::Mat anchor(anchor_height, anchor_width, anchor_type, const_cast<uint8_t *>(anchor_data));
         cv::Mat scene(scene_height, scene_width, scene_type, const_cast<uint8_t *>(scene_data));
 
-        // Convert to grayscale
-        cv::Mat anchor_gray, scene_gray;
+        // Convert to grayscale
+        stages.begin("convert");
+        cv::Mat anchor_gray, scene_gray;
+
+        if (anchor_channels == 1)
+        {
+            anchor_gray = anchor;
+        }
+        else if (anchor_channels == 3)
+        {
+            cv::cvtColor(anchor, anchor_gray, cv::COLOR_RGB2GRAY);
+        }
+        else
+        {
+            cv::cvtColor(anchor, anchor_gray, cv::COLOR_RGBA2GRAY);
+        }
+
+        if (scene_channels == 1)
+        {
+            scene_gray = scene;
+        }
+        else if (scene_channels == 3)
+        {
+            cv::cvtColor(scene, scene_gray, cv::COLOR_RGB2GRAY);
+        }
+        else
+        {
+            cv::cvtColor(scene, scene_gray, cv::COLOR_RGBA2GRAY);
+        }
+
+        stages.end();
+        if (out_pose == nullptr || intrinsics == nullptr || intrinsics->focal_length <= 0)
+            return compute_homography_internal(anchor_gray, scene_gray);
+
+        std::vector<cv::Point2f> inlier_anchor, inlier_scene;
+        result = compute_homography_internal(anchor_gray, scene_gray, &inlier_anchor, &inlier_scene);
+        if (result.status == 1)
+        {
+            stages.begin("pose");
+            solve_anchor_pose(*out_pose, inlier_anchor, inlier_scene, *intrinsics, anchor_width, scene_gray.size());
+        }
+        return result;
+    }
+
+    HomographyResult hg_find_homography_from_points(
+        const float *pts0_x, const float *pts0_y,
+        const float *pts1_x, const float *pts1_y,
+        int num_points,
+        int anchor_width, int anchor_height)
+    {
+        return hg_find_homography_from_points_pose(pts0_x, pts0_y, pts1_x, pts1_y, num_points,
+                                                   anchor_width, anchor_height, nullptr, nullptr);
+    }
+
+    HomographyResult hg_find_homography_from_points_pose(
+        const float *pts0_x, const float *pts0_y,
+        const float *pts1_x, const float *pts1_y,
+        int num_points,
+        int anchor_width, int anchor_height,
+        const HgCameraIntrinsics *intrinsics,
+        HgPose *out_pose)
+    {
+        HomographyResult result = {};
+        if (out_pose != nullptr)
+            *out_pose = HgPose{};
+        CaptureScope capture(HG_CALL_FIND_HOMOGRAPHY_FROM_POINTS);
+        CallStatsScope call_stats;
+        StageTimer stages;
+
+        // Validate input
+        if (pts0_x == nullptr || pts0_y == nullptr ||
+            pts1_x == nullptr || pts1_y == nullptr)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        if (num_points < 4)
+        {
+            result.status = 0;
+            result.num_matches = num_points;
+            return result;
+        }
+
+        if (anchor_width <= 0 || anchor_height <= 0)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        size_t coords_size = static_cast<size_t>(num_points) * sizeof(float);
+        capture.intrinsics(intrinsics);
+        capture.field<int32_t>(num_points);
+        capture.field<int32_t>(anchor_width);
+        capture.field<int32_t>(anchor_height);
+        capture.blob(pts0_x, coords_size);
+        capture.blob(pts0_y, coords_size);
+        capture.blob(pts1_x, coords_size);
+        capture.blob(pts1_y, coords_size);
+
+        // Convert to OpenCV point vectors
+        std::vector<cv::Point2f> pts_anchor, pts_scene;
+        pts_anchor.reserve(num_points);
+        pts_scene.reserve(num_points);
+
+        for (int i = 0; i < num_points; i++)
+        {
+            pts_anchor.push_back(cv::Point2f(pts0_x[i], pts0_y[i]));
+            pts_scene.push_back(cv::Point2f(pts1_x[i], pts1_y[i]));
+        }
+
+        result.num_matches = num_points;
+
+        // Compute homography using RANSAC
+        stages.begin("ransac");
+        std::vector<char> inliers_mask;
+        cv::Mat H = cv::findHomography(pts_anchor, pts_scene, cv::RANSAC, RANSAC_THRESH, inliers_mask);
+
+        // Check if homography was found
+        if (H.empty() || H.rows != 3 || H.cols != 3)
+        {
+            result.status = 0;
+            return result;
+        }
+
+        stages.begin("verify");
+
+        // Count inliers
+        int num_inliers = 0;
+        for (char inlier : inliers_mask)
+        {
+            if (inlier)
+                num_inliers++;
+        }
+
+        // Verify homography quality
+        if (num_inliers < MIN_MATCHES || num_inliers < num_points * 0.3)
+        {
+            result.status = 0;
+            return result;
+        }
+
+        // Copy homography matrix to result
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                result.homography[i * 3 + j] = H.at<double>(i, j);
+            }
+        }
+
+        // Transform anchor corners to scene coordinates
+        std::vector<cv::Point2f> anchor_corners = {
+            {0, 0},
+            {static_cast<float>(anchor_width), 0},
+            {static_cast<float>(anchor_width), static_cast<float>(anchor_height)},
+            {0, static_cast<float>(anchor_height)}};
+
+        std::vector<cv::Point2f> scene_corners;
+        cv::perspectiveTransform(anchor_corners, scene_corners, H);
+
+        // Store corners in result
+        for (int i = 0; i < 4; i++)
+        {
+            result.corners[i * 2] = scene_corners[i].x;
+            result.corners[i * 2 + 1] = scene_corners[i].y;
+        }
+
+        // Compute center (average of corners)
+        result.center_x = 0;
+        result.center_y = 0;
+        for (const auto &corner : scene_corners)
+        {
+            result.center_x += corner.x;
+            result.center_y += corner.y;
+        }
+        result.center_x /= 4.0f;
+        result.center_y /= 4.0f;
+
+        // Compute rotation angle from top edge
+        float dx = scene_corners[1].x - scene_corners[0].x;
+        float dy = scene_corners[1].y - scene_corners[0].y;
+        result.rotation = std::atan2(dy, dx);
+
+        // Compute scale (average of top and left edge ratios)
+        float top_edge = std::sqrt(dx * dx + dy * dy);
+        float left_dx = scene_corners[3].x - scene_corners[0].x;
+        float left_dy = scene_corners[3].y - scene_corners[0].y;
+        float left_edge = std::sqrt(left_dx * left_dx + left_dy * left_dy);
+
+        float original_width = static_cast<float>(anchor_width);
+        float original_height = static_cast<float>(anchor_height);
+
+        result.scale = (top_edge / original_width + left_edge / original_height) / 2.0f;
+
+        // Validate the detected quadrilateral (should be convex)
+        auto cross_product = [](const cv::Point2f &o, const cv::Point2f &a, const cv::Point2f &b)
+        {
+            return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+        };
+
+        float cp1 = cross_product(scene_corners[0], scene_corners[1], scene_corners[2]);
+        float cp2 = cross_product(scene_corners[1], scene_corners[2], scene_corners[3]);
+        float cp3 = cross_product(scene_corners[2], scene_corners[3], scene_corners[0]);
+        float cp4 = cross_product(scene_corners[3], scene_corners[0], scene_corners[1]);
+
+        bool is_convex = (cp1 > 0 && cp2 > 0 && cp3 > 0 && cp4 > 0) ||
+                         (cp1 < 0 && cp2 < 0 && cp3 < 0 && cp4 < 0);
+
+        if (!is_convex)
+        {
+            result.status = 0;
+            return result;
+        }
+
+        // Check aspect ratio distortion
+        float aspect_ratio = top_edge / left_edge;
+        float original_aspect = original_width / original_height;
+        float aspect_distortion = aspect_ratio / original_aspect;
+
+        if (aspect_distortion < 0.3f || aspect_distortion > 3.0f)
+        {
+            result.status = 0;
+            return result;
+        }
+
+        result.num_matches = num_inliers;
+        result.status = 1;
+
+        // No scene size is known here, so the principal point must be given
+        if (out_pose != nullptr && intrinsics != nullptr && intrinsics->focal_length > 0 && intrinsics->cx > 0 && intrinsics->cy > 0)
+        {
+            stages.begin("pose");
+            std::vector<cv::Point2f> inlier_anchor, inlier_scene;
+            for (size_t i = 0; i < inliers_mask.size(); i++)
+            {
+                if (!inliers_mask[i])
+                    continue;
+                inlier_anchor.push_back(pts_anchor[i]);
+                inlier_scene.push_back(pts_scene[i]);
+            }
+            solve_anchor_pose(*out_pose, inlier_anchor, inlier_scene, *intrinsics, anchor_width, cv::Size());
+        }
+        return result;
+    }
+
+    const char *hg_lib_version(void)
+    {
+        return HOMOGRAPHY_LIB_VERSION;
+    }
+
+    // ============================================================================
+    // Paper Detection Implementation
+    // ============================================================================
+
+    /**
+     * Order four points in clockwise order starting from top-left
+     */
+    static void order_quad_clockwise(const cv::Point2f *pts, cv::Point2f *ordered)
+    {
+        // Sum of coordinates: top-left has smallest sum, bottom-right has largest
+        // Difference: top-right has smallest diff, bottom-left has largest
+        float sums[4], diffs[4];
+        for (int i = 0; i < 4; i++)
+        {
+            sums[i] = pts[i].x + pts[i].y;
+            diffs[i] = pts[i].y - pts[i].x;
+        }
+
+        ordered[0] = pts[std::min_element(sums, sums + 4) - sums];    // top-left
+        ordered[1] = pts[std::min_element(diffs, diffs + 4) - diffs]; // top-right
+        ordered[2] = pts[std::max_element(sums, sums + 4) - sums];    // bottom-right
+        ordered[3] = pts[std::max_element(diffs, diffs + 4) - diffs]; // bottom-left
+    }
+
+    /**
+     * Order points in clockwise order starting from top-left
+     */
+    static std::vector<cv::Point2f> order_points_clockwise(const std::vector<cv::Point2f> &pts)
+    {
+        if (pts.size() != 4)
+            return pts;
+
+        std::vector<cv::Point2f> ordered(4);
+        order_quad_clockwise(pts.data(), ordered.data());
+        return ordered;
+    }
+
+    /**
+     * Check if four points form a convex quadrilateral
+     */
+    static bool is_convex_quad(const cv::Point2f *pts)
+    {
+        auto cross_product = [](const cv::Point2f &o, const cv::Point2f &a, const cv::Point2f &b)
+        {
+            return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+        };
+
+        float cp1 = cross_product(pts[0], pts[1], pts[2]);
+        float cp2 = cross_product(pts[1], pts[2], pts[3]);
+        float cp3 = cross_product(pts[2], pts[3], pts[0]);
+        float cp4 = cross_product(pts[3], pts[0], pts[1]);
+
+        return (cp1 > 0 && cp2 > 0 && cp3 > 0 && cp4 > 0) ||
+               (cp1 < 0 && cp2 < 0 && cp3 < 0 && cp4 < 0);
+    }
+
+    /**
+     * Check if a quadrilateral is convex
+     */
+    static bool is_convex_quadrilateral(const std::vector<cv::Point2f> &pts)
+    {
+        return pts.size() == 4 && is_convex_quad(pts.data());
+    }
+
+    /**
+     * Compute edge length
+     */
+    static float edge_length(const cv::Point2f &p1, const cv::Point2f &p2)
+    {
+        float dx = p2.x - p1.x;
+        float dy = p2.y - p1.y;
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    /**
+     * Wrap raw 1/3/4-channel pixels and convert them to grayscale (no copy for 1 channel)
+     */
+    static cv::Mat raw_to_gray(const uint8_t *image_data, int image_width, int image_height, int image_channels)
+    {
+        // Create cv::Mat from raw data
+        int cv_type = image_channels == 1 ? CV_8UC1 : image_channels == 3 ? CV_8UC3
+                                                                          : CV_8UC4;
+
+        cv::Mat image(image_height, image_width, cv_type, const_cast<uint8_t *>(image_data));
+
+        // Convert to grayscale
+        cv::Mat gray;
+        if (image_channels == 1)
+        {
+            gray = image;
+        }
+        else if (image_channels == 3)
+        {
+            cv::cvtColor(image, gray, cv::COLOR_RGB2GRAY);
+        }
+        else
+        {
+            cv::cvtColor(image, gray, cv::COLOR_RGBA2GRAY);
+        }
+        return gray;
+    }
+
+    /**
+     * Resolve detection configuration (defaults if not provided)
+     */
+    static PaperDetectionConfig resolve_paper_config(const PaperDetectionConfig *config)
+    {
+        return config != nullptr ? *config : hg_default_paper_config();
+    }
+
+    /**
+     * Blur, Canny and dilate a grayscale image into a binary edge map
+     */
+    static void compute_paper_edges(
+        const cv::Mat &gray,
+        const PaperDetectionConfig &cfg,
+        cv::Mat &edges,
+        StageTimer &stages)
+    {
+        if (cfg.edge_method == HG_EDGE_FUSED || cfg.edge_method == HG_EDGE_PARALLEL)
+        {
+            stages.begin("edges");
+            if (cfg.edge_method == HG_EDGE_PARALLEL)
+                parallel_edge_map(gray, cfg.blur_kernel_size, cfg.canny_threshold1, cfg.canny_threshold2, edges);
+            else
+                fused_edge_map(gray, cfg.blur_kernel_size, cfg.canny_threshold1, cfg.canny_threshold2, edges);
+            return;
+        }
+
+        // Apply Gaussian blur to reduce noise
+        stages.begin("blur");
+        cv::Mat blurred;
+        if (cfg.blur_kernel_size > 0 && cfg.blur_kernel_size % 2 == 1)
+        {
+            cv::GaussianBlur(gray, blurred, cv::Size(cfg.blur_kernel_size, cfg.blur_kernel_size), 0);
+        }
+        else
+        {
+            blurred = gray;
+        }
+
+        // Apply Canny edge detection
+        stages.begin("canny");
+        cv::Canny(blurred, edges, cfg.canny_threshold1, cfg.canny_threshold2);
+
+        // Dilate edges to close gaps
+        stages.begin("dilate");
+        cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
+        cv::dilate(edges, edges, kernel);
+    }
+
+    /**
+     * Banded edge extraction for very large images
+     *
+     * Runs blur, Canny and dilate on horizontal bands of cfg.stream_band_rows
+     * rows plus halo rows, and OR-pools each band into an edge map downscaled
+     * by `downscale`. Only the input frame is full size; all temporaries are
+     * band sized. Canny hysteresis links weak edges within a band and its halo
+     * only, so weak chains crossing band boundaries may differ slightly.
+     */
+    static void compute_paper_edges_streamed(
+        const cv::Mat &gray,
+        const PaperDetectionConfig &cfg,
+        int downscale,
+        cv::Mat &edges_small)
+    {
+        int blur_radius = (cfg.blur_kernel_size > 0 && cfg.blur_kernel_size % 2 == 1) ? cfg.blur_kernel_size / 2 : 0;
+        int halo = blur_radius + STREAM_HALO_ROWS;
+        int band_rows = (std::max(cfg.stream_band_rows, downscale) + downscale - 1) / downscale * downscale;
+
+        edges_small = cv::Mat::zeros((gray.rows + downscale - 1) / downscale,
+                                     (gray.cols + downscale - 1) / downscale, CV_8UC1);
+
+        cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
+        cv::Mat blurred, edges;
+
+        for (int y0 = 0; y0 < gray.rows; y0 += band_rows)
+        {
+            int y1 = std::min(gray.rows, y0 + band_rows);
+            int src0 = std::max(0, y0 - halo);
+            int src1 = std::min(gray.rows, y1 + halo);
+
+            // The band is a view into the frame, so the blur reads real
+            // neighbouring rows rather than a synthetic border
+            cv::Mat band = gray.rowRange(src0, src1);
+            if (cfg.edge_method == HG_EDGE_PARALLEL)
+            {
+                parallel_edge_map(band, cfg.blur_kernel_size, cfg.canny_threshold1, cfg.canny_threshold2, edges);
+            }
+            else if (cfg.edge_method == HG_EDGE_FUSED)
+            {
+                fused_edge_map(band, cfg.blur_kernel_size, cfg.canny_threshold1, cfg.canny_threshold2, edges);
+            }
+            else
+            {
+                if (blur_radius > 0)
+                {
+                    cv::GaussianBlur(band, blurred, cv::Size(cfg.blur_kernel_size, cfg.blur_kernel_size), 0);
+                }
+                else
+                {
+                    blurred = band;
+                }
+
+                cv::Canny(blurred, edges, cfg.canny_threshold1, cfg.canny_threshold2);
+                cv::dilate(edges, edges, kernel);
+            }
+
+            // OR-pool the band's own rows (not the halo) into the downscaled map
+            for (int y = y0; y < y1; y++)
+            {
+                const uchar *src = edges.ptr<uchar>(y - src0);
+                uchar *dst = edges_small.ptr<uchar>(y / downscale);
+                for (int x = 0; x < gray.cols; x++)
+                {
+                    dst[x / downscale] |= src[x];
+                }
+            }
+        }
+    }
+
+    /**
+     * Paper-like quadrilateral found in an edge map
+     */
+    struct QuadCandidate
+    {
+        std::vector<cv::Point2f> quad; // Clockwise from top-left
+        float area = 0;                // Contour area
+        float score = -1.0f;
+    };
+
+    /**
+     * Shape checks shared by the quad engines: convexity, minimum side length
+     * and expected aspect ratio
+     *
+     * @param quad  Corners ordered clockwise from top-left
+     * @return Aspect ratio score in [0, 1], or -1 if the quad is rejected
+     */
+    static float quad_shape_score(
+        const cv::Point2f *quad,
+        const PaperDetectionConfig &cfg,
+        float min_edge_length)
+    {
+        // Check if convex
+        if (!is_convex_quad(quad))
+            return -1.0f;
+
+        // Compute edge lengths
+        float edge0 = edge_length(quad[0], quad[1]); // top
+        float edge1 = edge_length(quad[1], quad[2]); // right
+        float edge2 = edge_length(quad[2], quad[3]); // bottom
+        float edge3 = edge_length(quad[3], quad[0]); // left
+
+        // Check minimum edge length (filter out small noise contours)
+        float min_edge = std::min({edge0, edge1, edge2, edge3});
+        if (min_edge < min_edge_length)
+            return -1.0f;
+
+        // Compute aspect ratio (width / height)
+        float width = (edge0 + edge2) / 2.0f;
+        float height = (edge1 + edge3) / 2.0f;
+
+        // Ensure width < height for portrait orientation
+        float aspect_ratio = std::min(width, height) / std::max(width, height);
+
+        // Check aspect ratio if expected ratio is provided
+        if (cfg.expected_aspect_ratio <= 0)
+            return 1.0f;
+
+        float ratio_diff = std::abs(aspect_ratio - cfg.expected_aspect_ratio) / cfg.expected_aspect_ratio;
+        if (ratio_diff > cfg.aspect_ratio_tolerance)
+            return -1.0f;
+
+        return 1.0f - ratio_diff;
+    }
+
+    /**
+     * Infinite line through merged collinear Hough segments
+     */
+    struct SegmentLine
+    {
+        cv::Point2f point;               // A point on the line
+        cv::Point2f direction;           // Unit direction
+        float angle = 0;                 // Direction angle in [0, pi)
+        float support = 0;               // Total length of merged segments
+        std::vector<cv::Vec4i> segments; // Merged segments (x0, y0, x1, y1)
+    };
+
+    /**
+     * Least-squares fit of a line to its segments' endpoints, weighted by length
+     */
+    static void fit_segment_line(SegmentLine &line)
+    {
+        double sw = 0, sx = 0, sy = 0, sxx = 0, sxy = 0, syy = 0;
+        for (const auto &seg : line.segments)
+        {
+            double w = std::hypot(seg[2] - seg[0], seg[3] - seg[1]);
+            for (int e = 0; e < 4; e += 2)
+            {
+                sw += w;
+                sx += w * seg[e];
+                sy += w * seg[e + 1];
+                sxx += w * seg[e] * seg[e];
+                sxy += w * seg[e] * seg[e + 1];
+                syy += w * seg[e + 1] * seg[e + 1];
+            }
+        }
+
+        double mx = sx / sw, my = sy / sw;
+        double cxx = sxx / sw - mx * mx, cxy = sxy / sw - mx * my, cyy = syy / sw - my * my;
+        double angle = 0.5 * std::atan2(2 * cxy, cxx - cyy);
+        if (angle < 0)
+            angle += CV_PI;
+
+        line.point = cv::Point2f(static_cast<float>(mx), static_cast<float>(my));
+        line.direction = cv::Point2f(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+        line.angle = static_cast<float>(angle);
+    }
+
+    static bool intersect_lines(const SegmentLine &a, const SegmentLine &b, cv::Point2f &out)
+    {
+        float denom = a.direction.x * b.direction.y - a.direction.y * b.direction.x;
+        if (std::abs(denom) < 1e-3f)
+            return false;
+
+        cv::Point2f d = b.point - a.point;
+        float t = (d.x * b.direction.y - d.y * b.direction.x) / denom;
+        out = a.point + a.direction * t;
+        return true;
+    }
+
+    /**
+     * Fraction of the side between two corners on a line that its segments cover
+     */
+    static float side_coverage(const SegmentLine &line, const cv::Point2f &p0, const cv::Point2f &p1)
+    {
+        float t0 = (p0 - line.point).dot(line.direction);
+        float t1 = (p1 - line.point).dot(line.direction);
+        if (t0 > t1)
+            std::swap(t0, t1);
+        if (t1 - t0 < 1.0f)
+            return 0.0f;
+
+        // Segments from both borders of a thick edge overlap; count each pixel once
+        cv::Vec2f clipped[MAX_QUAD_SEGMENTS];
+        int num_clipped = 0;
+        for (const auto &seg : line.segments)
+        {
+            float s0 = (cv::Point2f(static_cast<float>(seg[0]), static_cast<float>(seg[1])) - line.point).dot(line.direction);
+            float s1 = (cv::Point2f(static_cast<float>(seg[2]), static_cast<float>(seg[3])) - line.point).dot(line.direction);
+            float a = std::max(std::min(s0, s1), t0), b = std::min(std::max(s0, s1), t1);
+            if (b > a)
+                clipped[num_clipped++] = cv::Vec2f(a, b);
+        }
+        std::sort(clipped, clipped + num_clipped, [](const cv::Vec2f &x, const cv::Vec2f &y)
+                  { return x[0] < y[0]; });
+
+        float covered = 0, reach = t0;
+        for (int i = 0; i < num_clipped; i++)
+        {
+            float a = std::max(clipped[i][0], reach);
+            if (clipped[i][1] > a)
+            {
+                covered += clipped[i][1] - a;
+                reach = clipped[i][1];
+            }
+        }
+        return covered / (t1 - t0);
+    }
+
+    /**
+     * Shortest quad side accepted in an image (to filter out noise)
+     *
+     * At least 5% of the smaller dimension. Region searches pass the value of
+     * the whole frame, so they accept the same quads as a full scan.
+     */
+    static float quad_min_edge_length(cv::Size image_size)
+    {
+        return std::min(image_size.width, image_size.height) * 0.05f;
+    }
+
+    /**
+     * Find the best quadrilateral from line segments instead of contours
+     *
+     * Hough segments of the edge map are merged into lines, the lines are
+     * split into the two dominant orientations, and every pair of lines from
+     * one family is intersected with every pair from the other. A quad only
+     * needs part of each side to be visible, so occluded borders still work.
+     */
+    static bool find_best_quad_segments(
+        const cv::Mat &edges,
+        const PaperDetectionConfig &cfg,
+        QuadCandidate &best,
+        StageTimer &stages,
+        std::vector<QuadCandidate> *candidates,
+        float min_edge_length)
+    {
+        float image_area = static_cast<float>(edges.cols * edges.rows);
+        float min_area = image_area * cfg.min_area_ratio;
+        float max_area = image_area * cfg.max_area_ratio;
+
+        // Extract segments; gaps up to half the minimum length are bridged
+        stages.begin("segments");
+        std::vector<cv::Vec4i> segments;
+        int min_length = std::max(cvRound(min_edge_length), 8);
+        cv::HoughLinesP(edges, segments, 1, CV_PI / 180, min_length, min_length, min_length / 2);
+
+        if (segments.size() < 4)
+            return false;
+
+        auto segment_length = [](const cv::Vec4i &s)
+        {
+            return std::hypot(static_cast<float>(s[2] - s[0]), static_cast<float>(s[3] - s[1]));
+        };
+        std::sort(segments.begin(), segments.end(), [&](const cv::Vec4i &a, const cv::Vec4i &b)
+                  { return segment_length(a) > segment_length(b); });
+        if (segments.size() > static_cast<size_t>(MAX_QUAD_SEGMENTS))
+            segments.resize(MAX_QUAD_SEGMENTS);
+
+        // Merge collinear segments into lines, longest first
+        stages.begin("lines");
+        const float merge_angle = static_cast<float>(3.0 * CV_PI / 180);
+        const float merge_distance = std::max(3.0f, min_edge_length * 0.1f);
+        std::vector<SegmentLine> lines;
+
+        for (const auto &seg : segments)
+        {
+            cv::Point2f p0(static_cast<float>(seg[0]), static_cast<float>(seg[1]));
+            cv::Point2f p1(static_cast<float>(seg[2]), static_cast<float>(seg[3]));
+            float length = segment_length(seg);
+            cv::Point2f direction = (p1 - p0) * (1.0f / length);
+            float angle = std::atan2(direction.y, direction.x);
+            if (angle < 0)
+            {
+                angle += static_cast<float>(CV_PI);
+                direction = -direction;
+            }
+
+            cv::Point2f mid = (p0 + p1) * 0.5f;
+            SegmentLine *target = nullptr;
+            for (auto &line : lines)
+            {
+                float diff = std::abs(angle - line.angle);
+                diff = std::min(diff, static_cast<float>(CV_PI) - diff);
+                cv::Point2f offset = mid - line.point;
+                float distance = std::abs(offset.x * line.direction.y - offset.y * line.direction.x);
+                if (diff <= merge_angle && distance <= merge_distance)
+                {
+                    target = &line;
+                    break;
+                }
+            }
+
+            if (target == nullptr)
+            {
+                lines.emplace_back();
+                target = &lines.back();
+                target->point = p0;
+                target->direction = direction;
+                target->angle = angle;
+            }
+
+            target->segments.push_back(seg);
+            target->support += length;
+        }
+
+        // Lines were seeded by single segments; fit them to all their segments
+        for (auto &line : lines)
+            fit_segment_line(line);
+
+        // Two dominant orientations from a support-weighted histogram (5 degree
+        // bins, smoothed); opposite sides stay roughly parallel under moderate
+        // perspective
+        const int num_bins = 36;
+        float histogram[num_bins] = {};
+        for (const auto &line : lines)
+        {
+            int bin = std::min(static_cast<int>(line.angle / CV_PI * num_bins), num_bins - 1);
+            histogram[bin] += line.support;
+        }
+
+        float smoothed[num_bins];
+        for (int i = 0; i < num_bins; i++)
+            smoothed[i] = histogram[(i + num_bins - 1) % num_bins] + histogram[i] + histogram[(i + 1) % num_bins];
+
+        int peak0 = static_cast<int>(std::max_element(smoothed, smoothed + num_bins) - smoothed);
+        int peak1 = -1;
+        for (int i = 0; i < num_bins; i++)
+        {
+            int gap = std::abs(i - peak0);
+            if (std::min(gap, num_bins - gap) >= 6 && (peak1 < 0 || smoothed[i] > smoothed[peak1]))
+                peak1 = i;
+        }
+        if (peak1 < 0 || smoothed[peak1] <= 0)
+            return false;
+
+        // Assign lines to the nearer orientation, strongest lines first
+        const float family_tolerance = static_cast<float>(20.0 * CV_PI / 180);
+        std::vector<const SegmentLine *> families[2];
+        const int peaks[2] = {peak0, peak1};
+        for (const auto &line : lines)
+        {
+            float diffs[2];
+            for (int f = 0; f < 2; f++)
+            {
+                float center = static_cast<float>((peaks[f] + 0.5) * CV_PI / num_bins);
+                float diff = std::abs(line.angle - center);
+                diffs[f] = std::min(diff, static_cast<float>(CV_PI) - diff);
+            }
+            int f = diffs[0] <= diffs[1] ? 0 : 1;
+            if (diffs[f] <= family_tolerance)
+                families[f].push_back(&line);
+        }
+
+        for (auto &family : families)
+        {
+            std::sort(family.begin(), family.end(), [](const SegmentLine *a, const SegmentLine *b)
+                      { return a->support > b->support; });
+            if (family.size() > static_cast<size_t>(MAX_FAMILY_LINES))
+                family.resize(MAX_FAMILY_LINES);
+            if (family.size() < 2)
+                return false;
+        }
+
+        // Enumerate quads from two lines of each family
+        stages.begin("candidates");
+        const float margin = std::max(edges.cols, edges.rows) * 0.02f;
+        const cv::Rect2f bounds(-margin, -margin, edges.cols + 2 * margin, edges.rows + 2 * margin);
+        const std::vector<const SegmentLine *> &fa = families[0], &fb = families[1];
+
+        for (size_t i = 0; i < fa.size(); i++)
+        {
+            for (size_t j = i + 1; j < fa.size(); j++)
+            {
+                for (size_t k = 0; k < fb.size(); k++)
+                {
+                    for (size_t l = k + 1; l < fb.size(); l++)
+                    {
+                        // Corners in cycle order; side n lies on sides[n]
+                        const SegmentLine *sides[4] = {fa[i], fb[l], fa[j], fb[k]};
+                        std::vector<cv::Point2f> corners(4);
+                        bool valid = true;
+                        for (int n = 0; n < 4 && valid; n++)
+                        {
+                            valid = intersect_lines(*sides[(n + 3) % 4], *sides[n], corners[n]) &&
+                                    bounds.contains(corners[n]);
+                        }
+                        if (!valid)
+                            continue;
+
+                        float area = static_cast<float>(cv::contourArea(corners));
+                        if (area < min_area || area > max_area)
+                            continue;
+
+                        float coverage = 0;
+                        for (int n = 0; n < 4 && valid; n++)
+                        {
+                            float side = side_coverage(*sides[n], corners[n], corners[(n + 1) % 4]);
+                            valid = side >= MIN_SIDE_COVERAGE;
+                            coverage += side / 4.0f;
+                        }
+                        if (!valid)
+                            continue;
+
+                        std::vector<cv::Point2f> quad = order_points_clockwise(corners);
+                        float aspect_score = quad_shape_score(quad.data(), cfg, min_edge_length);
+                        if (aspect_score < 0)
+                            continue;
+
+                        // Prefer large, well-shaped quads with visible borders
+                        float score = area * aspect_score * coverage;
+                        if (candidates != nullptr)
+                            candidates->push_back({quad, area, score});
+                        if (score > best.score)
+                        {
+                            best.score = score;
+                            best.quad = quad;
+                            best.area = area;
+                        }
+                    }
+                }
+            }
+        }
+
+        return !best.quad.empty();
+    }
+
+    /**
+     * Approximate one contour by a paper-like quad and score it
+     *
+     * @param quad  Receives the corners, clockwise from top-left
+     * @param area  Receives the contour area
+     * @return Area times aspect score, or -1 if the contour is rejected
+     */
+    static float score_contour_quad(
+        const std::vector<cv::Point> &contour,
+        const PaperDetectionConfig &cfg,
+        float min_area,
+        float max_area,
+        float min_edge_length,
+        cv::Point2f *quad,
+        float &area)
+    {
+        area = static_cast<float>(cv::contourArea(contour));
+
+        // Filter by area
+        if (area < min_area || area > max_area)
+            return -1.0f;
+
+        // Approximate the contour to a polygon
+        // Use larger epsilon (0.03-0.04) for more aggressive simplification
+        // The buffer is per thread and keeps its capacity between contours
+        thread_local std::vector<cv::Point> approx;
+        float peri = static_cast<float>(cv::arcLength(contour, true));
+        cv::approxPolyDP(contour, approx, 0.035 * peri, true);
+
+        // We need exactly 4 points (quadrilateral)
+        if (approx.size() != 4)
+            return -1.0f;
+
+        // Convert to Point2f and order clockwise
+        cv::Point2f corners[4];
+        for (int i = 0; i < 4; i++)
+        {
+            corners[i] = cv::Point2f(static_cast<float>(approx[i].x), static_cast<float>(approx[i].y));
+        }
+        order_quad_clockwise(corners, quad);
+
+        float aspect_score = quad_shape_score(quad, cfg, min_edge_length);
+        if (aspect_score < 0)
+            return -1.0f;
+
+        // Score: prefer larger area with better aspect ratio match
+        return area * aspect_score;
+    }
+
+    /**
+     * Find the best-scoring paper-like quadrilateral in a binary edge map
+     *
+     * @param candidates       If not NULL, receives every quad passing the filters (unordered)
+     * @param min_edge_length  Shortest accepted side in pixels (<= 0 = quad_min_edge_length of edges)
+     * @return false if no contour passes the area, shape and aspect filters
+     */
+    static bool find_best_quad(
+        const cv::Mat &edges,
+        const PaperDetectionConfig &cfg,
+        QuadCandidate &best,
+        StageTimer &stages,
+        std::vector<QuadCandidate> *candidates = nullptr,
+        float min_edge_length = 0)
+    {
+        if (min_edge_length <= 0)
+            min_edge_length = quad_min_edge_length(edges.size());
+
+        if (cfg.quad_method == HG_QUAD_SEGMENTS)
+            return find_best_quad_segments(edges, cfg, best, stages, candidates, min_edge_length);
+
+        float image_area = static_cast<float>(edges.cols * edges.rows);
+        float min_area = image_area * cfg.min_area_ratio;
+        float max_area = image_area * cfg.max_area_ratio;
+
+        // Find contours
+        stages.begin("contours");
+        std::vector<std::vector<cv::Point>> contours;
+        if (cfg.quad_method == HG_QUAD_TRACED)
+            trace_external_contours(edges, min_area, contours);
+        else
+            cv::findContours(edges, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+
+        if (contours.empty())
+            return false;
+
+        // Find the best quadrilateral contour
+        stages.begin("candidates");
+
+        // Best (score, index) packed into one word so threads reduce it with a
+        // compare-and-swap. Scores are non-negative, so their float bits order
+        // like the values; the index is inverted so ties keep the first
+        // contour, as a serial scan would.
+        std::atomic<uint64_t> best_key(0);
+
+        // When every candidate is wanted, each contour writes its own slot
+        struct ContourQuad
+        {
+            cv::Point2f quad[4];
+            float area;
+            float score = -1.0f;
+        };
+        std::vector<ContourQuad> slots(candidates != nullptr ? contours.size() : 0);
+
+        auto evaluate = [&](const cv::Range &range)
+        {
+            cv::Point2f quad[4];
+            float area;
+            for (int i = range.start; i < range.end; i++)
+            {
+                float score = score_contour_quad(contours[i], cfg, min_area, max_area, min_edge_length, quad, area);
+                if (score < 0)
+                    continue;
+
+                if (!slots.empty())
+                {
+                    std::copy(quad, quad + 4, slots[i].quad);
+                    slots[i].area = area;
+                    slots[i].score = score;
+                }
+
+                uint32_t bits;
+                std::memcpy(&bits, &score, sizeof(bits));
+                uint64_t key = (static_cast<uint64_t>(bits) << 32) | (UINT32_MAX - static_cast<uint32_t>(i));
+                uint64_t current = best_key.load(std::memory_order_relaxed);
+                while (key > current && !best_key.compare_exchange_weak(current, key, std::memory_order_relaxed))
+                {
+                }
+            }
+        };
+
+        const int num_contours = static_cast<int>(contours.size());
+        if (num_contours >= MIN_PARALLEL_CONTOURS)
+            cv::parallel_for_(cv::Range(0, num_contours), evaluate, num_contours / (MIN_PARALLEL_CONTOURS / 4.0));
+        else
+            evaluate(cv::Range(0, num_contours));
+
+        for (const ContourQuad &slot : slots)
+        {
+            if (slot.score >= 0)
+                candidates->push_back({std::vector<cv::Point2f>(slot.quad, slot.quad + 4), slot.area, slot.score});
+        }
+
+        uint64_t key = best_key.load();
+        if (key != 0)
+        {
+            // Only the winner's corners are needed; evaluate it once more
+            cv::Point2f quad[4];
+            float area;
+            int index = static_cast<int>(UINT32_MAX - static_cast<uint32_t>(key));
+            float score = score_contour_quad(contours[index], cfg, min_area, max_area, min_edge_length, quad, area);
+
+            if (score > best.score)
+            {
+                best.score = score;
+                best.quad.assign(quad, quad + 4);
+                best.area = area;
+            }
+        }
+
+        return !best.quad.empty();
+    }
+
+    /**
+     * Keep the best candidates that do not overlap each other
+     *
+     * Candidates are sorted by descending score and kept greedily; a quad is
+     * dropped if it shares more than MAX_PAPER_OVERLAP of the smaller area with
+     * a quad kept before it. At most max_count candidates remain.
+     */
+    static void select_distinct_quads(std::vector<QuadCandidate> &candidates, int max_count)
+    {
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const QuadCandidate &a, const QuadCandidate &b)
+                         { return a.score > b.score; });
+
+        size_t kept = 0;
+        std::vector<cv::Point2f> shared;
+        for (size_t i = 0; i < candidates.size() && kept < static_cast<size_t>(max_count); i++)
+        {
+            bool distinct = true;
+            for (size_t j = 0; j < kept && distinct; j++)
+            {
+                float overlap = cv::intersectConvexConvex(candidates[i].quad, candidates[j].quad, shared, true);
+                distinct = overlap <= MAX_PAPER_OVERLAP * std::min(candidates[i].area, candidates[j].area);
+            }
+
+            // Rejected entries before i are no longer needed; kept ones stay in order
+            if (distinct)
+                std::swap(candidates[kept++], candidates[i]);
+        }
+        candidates.resize(kept);
+    }
+
+    /**
+     * Quad search over several Canny threshold pairs
+     *
+     * Pair k is the configured thresholds scaled by canny_hypothesis_scale^k.
+     * Gradients and non-maximum suppression are computed once for all pairs;
+     * hysteresis, dilation and the quad search then run concurrently per pair,
+     * and the best-scoring quad over all pairs wins (the first pair on ties).
+     */
+    static bool find_best_quad_hypotheses(
+        const cv::Mat &gray,
+        const PaperDetectionConfig &cfg,
+        QuadCandidate &best,
+        StageTimer &stages,
+        std::vector<QuadCandidate> *candidates,
+        float min_edge_length)
+    {
+        const int count = std::min(cfg.canny_hypotheses, MAX_CANNY_HYPOTHESES);
+        const int low = std::min(cfg.canny_threshold1, cfg.canny_threshold2);
+        const int high = std::max(cfg.canny_threshold1, cfg.canny_threshold2);
+        std::vector<double> scales(count);
+        for (int k = 0; k < count; k++)
+            scales[k] = std::pow(static_cast<double>(cfg.canny_hypothesis_scale), k);
+
+        stages.begin("gradients");
+        int floor = low;
+        for (double scale : scales)
+            floor = std::min(floor, cvRound(low * scale));
+        cv::Mat peaks;
+        edge_peak_map(gray, cfg.blur_kernel_size, floor, peaks);
+
+        stages.begin("hypotheses");
+        std::vector<QuadCandidate> found(count);
+        std::vector<std::vector<QuadCandidate>> found_all(candidates != nullptr ? count : 0);
+        cv::parallel_for_(cv::Range(0, count), [&](const cv::Range &range)
+                          {
+            StageTimer quiet;
+            quiet.muted = true;
+            cv::Mat edges;
+            for (int k = range.start; k < range.end; k++)
+            {
+                threshold_edge_peaks(peaks, cvRound(low * scales[k]), cvRound(high * scales[k]), edges);
+                find_best_quad(edges, cfg, found[k], quiet, candidates != nullptr ? &found_all[k] : nullptr,
+                               min_edge_length);
+            } });
+        stages.end();
+
+        for (int k = 0; k < count; k++)
+        {
+            if (found[k].score > best.score)
+                best = found[k];
+            if (candidates != nullptr)
+                candidates->insert(candidates->end(), found_all[k].begin(), found_all[k].end());
+        }
+        return !best.quad.empty();
+    }
+
+    /**
+     * Edge extraction and quad search on a grayscale image
+     *
+     * @param candidates       As in find_best_quad
+     * @param min_edge_length  As in find_best_quad
+     */
+    static bool find_paper_quad(
+        const cv::Mat &gray,
+        const PaperDetectionConfig &cfg,
+        QuadCandidate &best,
+        StageTimer &stages,
+        std::vector<QuadCandidate> *candidates = nullptr,
+        float min_edge_length = 0)
+    {
+        if (cfg.canny_hypotheses > 1)
+            return find_best_quad_hypotheses(gray, cfg, best, stages, candidates, min_edge_length);
+
+        cv::Mat edges;
+        compute_paper_edges(gray, cfg, edges, stages);
+        return find_best_quad(edges, cfg, best, stages, candidates, min_edge_length);
+    }
+
+    /**
+     * Quality of a quad snapped to image edges
+     */
+    struct QuadFitStats
+    {
+        float min_support = 1.0f;  // Lowest fraction of profiles with an edge, over the sides
+        float max_residual = 0.0f; // Largest RMS line-fit residual in pixels, over the sides
+    };
+
+    /**
+     * Camera matrix of a paper config (default principal point: image center)
+     */
+    static cv::Matx33d paper_camera_matrix(const PaperDetectionConfig &cfg, cv::Size image_size)
+    {
+        return cv::Matx33d(cfg.focal_length, 0, cfg.cx > 0 ? cfg.cx : image_size.width / 2.0,
+                           0, cfg.focal_length, cfg.cy > 0 ? cfg.cy : image_size.height / 2.0,
+                           0, 0, 1);
+    }
+
+    /**
+     * Coarse map from undistorted to distorted (image) pixel positions
+     *
+     * Sampled every DISTORTION_MAP_STEP pixels over the frame plus a margin
+     * (undistorted positions of a barrel lens fall outside the frame) and
+     * interpolated bilinearly; lens models are smooth at that scale.
+     */
+    struct DistortionMap
+    {
+        cv::Mat grid; // CV_32FC2, image position of undistorted pixel (x * step - margin, y * step - margin)
+        float margin = 0;
+        cv::Matx33d K;
+        cv::Mat dist_coeffs;
+    };
+
+    /**
+     * Build the distortion map of a frame size; leaves it empty for an ideal
+     * lens or without intrinsics
+     */
+    static void build_distortion_map(const PaperDetectionConfig &cfg, cv::Size frame, DistortionMap &map)
+    {
+        map = DistortionMap();
+        if (cfg.focal_length <= 0)
+            return;
+
+        map.dist_coeffs = distortion_coeffs(cfg.dist_k1, cfg.dist_k2, cfg.dist_p1, cfg.dist_p2, cfg.dist_k3);
+        if (map.dist_coeffs.empty())
+            return;
+
+        map.K = paper_camera_matrix(cfg, frame);
+        map.margin = std::max(frame.width, frame.height) / 4.0f;
+
+        // A camera matrix scaled to the grid makes grid cell (x, y) the
+        // undistorted pixel (x * step - margin, y * step - margin)
+        const double s = 1.0 / DISTORTION_MAP_STEP;
+        cv::Matx33d grid_K(map.K(0, 0) * s, 0, (map.K(0, 2) + map.margin) * s,
+                           0, map.K(1, 1) * s, (map.K(1, 2) + map.margin) * s,
+                           0, 0, 1);
+        cv::Size grid_size(cvCeil((frame.width + 2 * map.margin) * s) + 2,
+                           cvCeil((frame.height + 2 * map.margin) * s) + 2);
+
+        cv::Mat unused;
+        cv::initUndistortRectifyMap(map.K, map.dist_coeffs, cv::noArray(), grid_K, grid_size, CV_32FC2,
+                                    map.grid, unused);
+    }
+
+    /**
+     * Image position of an undistorted pixel position
+     */
+    static cv::Point2f distort_point(const DistortionMap &map, cv::Point2f p)
+    {
+        const float s = 1.0f / DISTORTION_MAP_STEP;
+        float gx = std::min(std::max((p.x + map.margin) * s, 0.0f), static_cast<float>(map.grid.cols - 2));
+        float gy = std::min(std::max((p.y + map.margin) * s, 0.0f), static_cast<float>(map.grid.rows - 2));
+
+        int x0 = static_cast<int>(gx);
+        int y0 = static_cast<int>(gy);
+        float fx = gx - x0;
+        float fy = gy - y0;
+
+        const cv::Point2f *r0 = map.grid.ptr<cv::Point2f>(y0);
+        const cv::Point2f *r1 = map.grid.ptr<cv::Point2f>(y0 + 1);
+        cv::Point2f top = r0[x0] + (r0[x0 + 1] - r0[x0]) * fx;
+        cv::Point2f bottom = r1[x0] + (r1[x0 + 1] - r1[x0]) * fx;
+        return top + (bottom - top) * fy;
+    }
+
+    /**
+     * Bilinear intensity lookup, clamped to the image
+     */
+    static float sample_gray(const cv::Mat &gray, float x, float y)
+    {
+        x = std::min(std::max(x, 0.0f), static_cast<float>(gray.cols - 1));
+        y = std::min(std::max(y, 0.0f), static_cast<float>(gray.rows - 1));
+
+        int x0 = std::min(static_cast<int>(x), gray.cols - 2);
+        int y0 = std::min(static_cast<int>(y), gray.rows - 2);
+        float fx = x - x0;
+        float fy = y - y0;
+
+        const uchar *r0 = gray.ptr<uchar>(y0);
+        const uchar *r1 = gray.ptr<uchar>(y0 + 1);
+        float top = r0[x0] + (r0[x0 + 1] - r0[x0]) * fx;
+        float bottom = r1[x0] + (r1[x0 + 1] - r1[x0]) * fx;
+        return top + (bottom - top) * fy;
+    }
+
+    /**
+     * Snap each side of a quad to the strongest nearby intensity edge
+     *
+     * Samples short intensity profiles perpendicular to each side (within
+     * +/- search_radius pixels), takes the sub-pixel gradient maximum of each
+     * profile and fits a line through those points; corners are re-intersected
+     * from the fitted lines. Sides with too little edge support, and corners
+     * that would move implausibly far, keep their original position.
+     *
+     * @param stats       Optional edge support and fit residual of the sides
+     * @param distortion  If not NULL, quad is in undistorted pixels (where the
+     *                    sides are straight) and the image is sampled through
+     *                    the map
+     * @return Number of sides that were refined
+     */
+    static int refine_quad_edges(const cv::Mat &gray, std::vector<cv::Point2f> &quad, float search_radius,
+                                 QuadFitStats *stats = nullptr, const DistortionMap *distortion = nullptr)
+    {
+        if (stats != nullptr)
+            *stats = QuadFitStats();
+
+        if (quad.size() != 4 || gray.cols < 2 || gray.rows < 2)
+            return 0;
+
+        const int radius = std::max(1, static_cast<int>(std::ceil(search_radius)));
+        std::vector<float> profile(2 * radius + 3);
+
+        auto sample = [&](cv::Point2f q)
+        {
+            if (distortion != nullptr)
+                q = distort_point(*distortion, q);
+            return sample_gray(gray, q.x, q.y);
+        };
+
+        cv::Point2f line_point[4], line_dir[4];
+        int refined = 0;
+
+        for (int side = 0; side < 4; side++)
+        {
+            const cv::Point2f p0 = quad[side];
+            const cv::Point2f p1 = quad[(side + 1) % 4];
+            float len = edge_length(p0, p1);
+
+            line_point[side] = p0;
+            line_dir[side] = len > 0 ? (p1 - p0) * (1.0f / len) : cv::Point2f(1, 0);
+            if (len < 4)
+                continue;
+
+            const cv::Point2f dir = line_dir[side];
+            const cv::Point2f normal(-dir.y, dir.x);
+
+            // Stay away from the corners, where the other side's edge interferes
+            int num_samples = std::min(48, std::max(8, static_cast<int>(len / 8)));
+            std::vector<cv::Point2f> edge_points;
+            edge_points.reserve(num_samples);
+
+            for (int i = 0; i < num_samples; i++)
+            {
+                float t = 0.15f + 0.7f * (i + 0.5f) / num_samples;
+                cv::Point2f base = p0 + (p1 - p0) * t;
+
+                // Profile across the side, averaged over three tangent offsets
+                for (int k = 0; k < static_cast<int>(profile.size()); k++)
+                {
+                    cv::Point2f q = base + normal * static_cast<float>(k - radius - 1);
+                    profile[k] = (sample(q - dir) + sample(q) + sample(q + dir)) / 3.0f;
+                }
+
+                // Strongest central-difference gradient along the normal
+                int best_k = -1;
+                float best_grad = 0;
+                for (int k = 1; k < static_cast<int>(profile.size()) - 1; k++)
+                {
+                    float grad = std::abs(profile[k + 1] - profile[k - 1]);
+                    if (grad > best_grad)
+                    {
+                        best_grad = grad;
+                        best_k = k;
+                    }
+                }
+
+                if (best_k < 0 || best_grad < MIN_EDGE_GRADIENT)
+                    continue;
+
+                // Parabolic sub-pixel peak
+                float offset = 0;
+                if (best_k > 1 && best_k < static_cast<int>(profile.size()) - 2)
+                {
+                    float a = std::abs(profile[best_k] - profile[best_k - 2]);
+                    float c = std::abs(profile[best_k + 2] - profile[best_k]);
+                    float denom = a - 2 * best_grad + c;
+                    if (denom < 0)
+                        offset = 0.5f * (a - c) / denom;
+                }
+
+                edge_points.push_back(base + normal * (best_k - radius - 1 + offset));
+            }
+
+            float support = static_cast<float>(edge_points.size()) / num_samples;
+            if (stats != nullptr)
+                stats->min_support = std::min(stats->min_support, support);
+
+            if (static_cast<int>(edge_points.size()) < std::max(4, num_samples / 2))
+                continue;
+
+            cv::Vec4f line;
+            cv::fitLine(edge_points, line, cv::DIST_HUBER, 0, 0.01, 0.01);
+            line_dir[side] = cv::Point2f(line[0], line[1]);
+            line_point[side] = cv::Point2f(line[2], line[3]);
+            refined++;
+
+            if (stats != nullptr)
+            {
+                // RMS distance of the edge points from the fitted line
+                float sum_sq = 0;
+                for (const auto &p : edge_points)
+                {
+                    cv::Point2f d = p - line_point[side];
+                    float dist = d.x * line_dir[side].y - d.y * line_dir[side].x;
+                    sum_sq += dist * dist;
+                }
+                stats->max_residual = std::max(stats->max_residual, std::sqrt(sum_sq / edge_points.size()));
+            }
+        }
+
+        if (refined == 0)
+            return 0;
+
+        // Corner i is the intersection of side i-1 and side i
+        const float max_shift = 2 * search_radius + 2;
+        for (int i = 0; i < 4; i++)
+        {
+            int prev = (i + 3) % 4;
+            const cv::Point2f &d = line_dir[prev];
+            const cv::Point2f &e = line_dir[i];
+            float denom = d.x * e.y - d.y * e.x;
+            if (std::abs(denom) < 1e-6f)
+                continue;
+
+            cv::Point2f w = line_point[i] - line_point[prev];
+            float t = (w.x * e.y - w.y * e.x) / denom;
+            cv::Point2f corner = line_point[prev] + d * t;
+
+            if (edge_length(corner, quad[i]) <= max_shift)
+                quad[i] = corner;
+        }
+
+        return refined;
+    }
+
+    /**
+     * Map a quad found on a downscaled image back to full resolution and snap
+     * it to the full resolution edges
+     *
+     * @param sx, sy  Full / downscaled image size ratios
+     */
+    static void refine_coarse_quad(const cv::Mat &gray, QuadCandidate &best, double sx, double sy)
+    {
+        // Pixel centres: x_full = (x + 0.5) * sx - 0.5
+        for (auto &p : best.quad)
+        {
+            p = cv::Point2f(static_cast<float>((p.x + 0.5) * sx - 0.5),
+                            static_cast<float>((p.y + 0.5) * sy - 0.5));
+        }
+        best.area *= static_cast<float>(sx * sy);
+
+        // A coarse pixel spans sx full pixels; search a little beyond that
+        refine_quad_edges(gray, best.quad, static_cast<float>(2 * std::max(sx, sy) + 2));
+    }
+
+    /**
+     * Physical paper size (mm) in the orientation of a detected quad
+     */
+    static void paper_dimensions(
+        const std::vector<cv::Point2f> &quad,
+        const PaperDetectionConfig &cfg,
+        float &paper_w,
+        float &paper_h)
+    {
+        float width = (edge_length(quad[0], quad[1]) + edge_length(quad[3], quad[2])) / 2.0f;
+        float height = (edge_length(quad[0], quad[3]) + edge_length(quad[1], quad[2])) / 2.0f;
+
+        paper_w = (cfg.paper_width_mm > 0) ? cfg.paper_width_mm : 210.0f;
+        paper_h = (cfg.paper_height_mm > 0) ? cfg.paper_height_mm : 297.0f;
+
+        // Determine orientation: if detected quad is more wide than tall, swap dimensions
+        if (width > height)
+        {
+            std::swap(paper_w, paper_h);
+        }
+    }
+
+    /**
+     * Planar pose from H ~ K [r1 r2 t] (canonical paper plane to image)
+     *
+     * The first two columns of K^-1 H are scaled to unit length, completed by
+     * their cross product and projected onto the nearest rotation.
+     */
+    static bool pose_from_homography(const cv::Matx33d &H, const cv::Matx33d &K, double *rvec_out, double *tvec_out)
+    {
+        cv::Matx33d M = K.inv() * H;
+        double n1 = std::sqrt(M(0, 0) * M(0, 0) + M(1, 0) * M(1, 0) + M(2, 0) * M(2, 0));
+        double n2 = std::sqrt(M(0, 1) * M(0, 1) + M(1, 1) * M(1, 1) + M(2, 1) * M(2, 1));
+        if (n1 < 1e-12 || n2 < 1e-12)
+            return false;
+
+        // The paper lies in front of the camera
+        double scale = 2.0 / (n1 + n2);
+        if (M(2, 2) < 0)
+            scale = -scale;
+
+        double r1[3], r2[3];
+        for (int i = 0; i < 3; i++)
+        {
+            r1[i] = M(i, 0) * scale;
+            r2[i] = M(i, 1) * scale;
+            tvec_out[i] = M(i, 2) * scale;
+        }
+        cv::Matx33d R(r1[0], r2[0], r1[1] * r2[2] - r1[2] * r2[1],
+                      r1[1], r2[1], r1[2] * r2[0] - r1[0] * r2[2],
+                      r1[2], r2[2], r1[0] * r2[1] - r1[1] * r2[0]);
+
+        cv::Mat w, u, vt;
+        cv::SVDecomp(R, w, u, vt);
+        cv::Mat rvec;
+        cv::Rodrigues(cv::Mat(u * vt), rvec);
+        for (int i = 0; i < 3; i++)
+            rvec_out[i] = rvec.at<double>(i);
+        return true;
+    }
+
+    /**
+     * Camera pose of a detected paper (cfg.focal_length > 0)
+     *
+     * @param homography  Canonical rectangle to image homography, row-major (HG_POSE_HOMOGRAPHY)
+     * @param guess       Previous rvec then tvec to start HG_POSE_ITERATIVE from, or NULL
+     * @return false if no pose was found
+     */
+    static bool estimate_paper_pose(
+        const std::vector<cv::Point2f> &quad,
+        const double *homography,
+        const PaperDetectionConfig &cfg,
+        cv::Size image_size,
+        const double *guess,
+        double *rvec_out,
+        double *tvec_out)
+    {
+        float paper_w, paper_h;
+        paper_dimensions(quad, cfg, paper_w, paper_h);
 
-        if (anchor_channels == 1)
+        cv::Matx33d K = paper_camera_matrix(cfg, image_size);
+
+        // Undistort the four corners only; the solvers then see an ideal lens
+        cv::Mat dist_coeffs = distortion_coeffs(cfg.dist_k1, cfg.dist_k2, cfg.dist_p1, cfg.dist_p2, cfg.dist_k3);
+        std::vector<cv::Point2f> image_points = quad;
+        undistort_pixels(image_points, K, dist_coeffs);
+
+        if (cfg.pose_method == HG_POSE_HOMOGRAPHY)
         {
-            anchor_gray = anchor;
+            if (dist_coeffs.empty())
+                return pose_from_homography(cv::Matx33d(homography), K, rvec_out, tvec_out);
+
+            std::vector<cv::Point2f> canonical_corners = {
+                {0, 0},
+                {paper_w, 0},
+                {paper_w, paper_h},
+                {0, paper_h}};
+            cv::Mat H = cv::getPerspectiveTransform(canonical_corners, image_points);
+            return pose_from_homography(cv::Matx33d(H.ptr<double>()), K, rvec_out, tvec_out);
         }
-        else if (anchor_channels == 3)
+
+        // 3D object points (paper corners in paper coordinate system, Z=0)
+        std::vector<cv::Point3f> object_points = {
+            {0, 0, 0},
+            {paper_w, 0, 0},
+            {paper_w, paper_h, 0},
+            {0, paper_h, 0}};
+
+        cv::Mat rvec, tvec;
+        bool solved;
+        if (cfg.pose_method == HG_POSE_IPPE)
         {
-            cv::cvtColor(anchor, anchor_gray, cv::COLOR_RGB2GRAY);
+            solved = cv::solvePnP(object_points, image_points, K, cv::Mat(), rvec, tvec, false, cv::SOLVEPNP_IPPE);
+        }
+        else if (guess != nullptr)
+        {
+            rvec = (cv::Mat_<double>(3, 1) << guess[0], guess[1], guess[2]);
+            tvec = (cv::Mat_<double>(3, 1) << guess[3], guess[4], guess[5]);
+            solved = cv::solvePnP(object_points, image_points, K, cv::Mat(), rvec, tvec, true, cv::SOLVEPNP_ITERATIVE);
         }
         else
         {
-            cv::cvtColor(anchor, anchor_gray, cv::COLOR_RGBA2GRAY);
+            solved = cv::solvePnP(object_points, image_points, K, cv::Mat(), rvec, tvec);
         }
 
-        if (scene_channels == 1)
+        if (!solved)
+            return false;
+
+        for (int i = 0; i < 3; i++)
         {
-            scene_gray = scene;
+            rvec_out[i] = rvec.at<double>(i);
+            tvec_out[i] = tvec.at<double>(i);
         }
-        else if (scene_channels == 3)
+        return true;
+    }
+
+    /**
+     * Fill corners, center, metrics, homography and pose of a detected quad
+     *
+     * @param image_size  Size of the image the quad was detected in (default principal point)
+     */
+    static void fill_paper_result(
+        PaperDetectionResult &result,
+        const std::vector<cv::Point2f> &best_quad,
+        float best_area,
+        const PaperDetectionConfig &cfg,
+        cv::Size image_size,
+        StageTimer &stages)
+    {
+        // Store corners
+        for (int i = 0; i < 4; i++)
         {
-            cv::cvtColor(scene, scene_gray, cv::COLOR_RGB2GRAY);
+            result.corners[i * 2] = best_quad[i].x;
+            result.corners[i * 2 + 1] = best_quad[i].y;
         }
-        else
+
+        // Compute center
+        result.center_x = 0;
+        result.center_y = 0;
+        for (const auto &p : best_quad)
         {
-            cv::cvtColor(scene, scene_gray, cv::COLOR_RGBA2GRAY);
+            result.center_x += p.x;
+            result.center_y += p.y;
+        }
+        result.center_x /= 4.0f;
+        result.center_y /= 4.0f;
+
+        // Compute area and perimeter
+        result.area = best_area;
+        result.perimeter = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            result.perimeter += edge_length(best_quad[i], best_quad[(i + 1) % 4]);
+        }
+
+        // Compute aspect ratio
+        float width = (edge_length(best_quad[0], best_quad[1]) + edge_length(best_quad[3], best_quad[2])) / 2.0f;
+        float height = (edge_length(best_quad[0], best_quad[3]) + edge_length(best_quad[1], best_quad[2])) / 2.0f;
+        result.aspect_ratio = std::min(width, height) / std::max(width, height);
+
+        // Compute homography from canonical rectangle to detected quad
+        // Canonical rectangle: [0,0], [paper_width, 0], [paper_width, paper_height], [0, paper_height]
+        float paper_w, paper_h;
+        paper_dimensions(best_quad, cfg, paper_w, paper_h);
+
+        std::vector<cv::Point2f> canonical_corners = {
+            {0, 0},
+            {paper_w, 0},
+            {paper_w, paper_h},
+            {0, paper_h}};
+
+        cv::Mat H = cv::findHomography(canonical_corners, best_quad);
+
+        if (!H.empty() && H.rows == 3 && H.cols == 3)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                for (int j = 0; j < 3; j++)
+                {
+                    result.homography[i * 3 + j] = H.at<double>(i, j);
+                }
+            }
+        }
+
+        // Compute camera pose if intrinsics are provided
+        if (cfg.focal_length > 0)
+        {
+            stages.begin("pose");
+            estimate_paper_pose(best_quad, result.homography, cfg, image_size, nullptr, result.rvec, result.tvec);
         }
 
-        return compute_homography_internal(anchor_gray, scene_gray);
+        result.status = 1;
     }
 
-    HomographyResult hg_find_homography_from_points(
-        const float *pts0_x, const float *pts0_y,
-        const float *pts1_x, const float *pts1_y,
-        int num_points,
-        int anchor_width, int anchor_height)
+    /**
+     * Streaming variant of detect_paper_internal for very large images
+     *
+     * Contours come from the downscaled banded edge map; the winning quad is
+     * scaled back and its sides are snapped to the full resolution edges.
+     */
+    static PaperDetectionResult detect_paper_streamed(
+        const cv::Mat &gray,
+        const PaperDetectionConfig &cfg,
+        StageTimer &stages)
     {
-        HomographyResult result = {};
+        PaperDetectionResult result = {};
 
-        // Validate input
-        if (pts0_x == nullptr || pts0_y == nullptr ||
-            pts1_x == nullptr || pts1_y == nullptr)
+        int downscale = cfg.stream_edge_downscale == 1 || cfg.stream_edge_downscale == 4 ? cfg.stream_edge_downscale : 2;
+
+        stages.begin("edges");
+        cv::Mat edges_small;
+        compute_paper_edges_streamed(gray, cfg, downscale, edges_small);
+
+        QuadCandidate best;
+        if (!find_best_quad(edges_small, cfg, best, stages))
         {
-            result.status = -1;
+            result.status = 0;
             return result;
         }
 
-        if (num_points < 4)
+        stages.begin("refine");
+        refine_coarse_quad(gray, best, downscale, downscale);
+        stages.end();
+
+        fill_paper_result(result, best.quad, best.area, cfg, gray.size(), stages);
+        return result;
+    }
+
+    /**
+     * Coarse-to-fine variant of detect_paper_internal
+     *
+     * Blur, Canny, dilate and contours run on a copy no larger than
+     * cfg.coarse_max_dimension; only the corner refinement touches the full
+     * resolution image.
+     */
+    static PaperDetectionResult detect_paper_coarse(
+        const cv::Mat &gray,
+        const PaperDetectionConfig &cfg,
+        StageTimer &stages)
+    {
+        PaperDetectionResult result = {};
+
+        stages.begin("resize");
+        double f = static_cast<double>(cfg.coarse_max_dimension) / std::max(gray.cols, gray.rows);
+        cv::Mat small;
+        cv::resize(gray, small, cv::Size(std::max(1, cvRound(gray.cols * f)), std::max(1, cvRound(gray.rows * f))),
+                   0, 0, cv::INTER_AREA);
+
+        QuadCandidate best;
+        if (!find_paper_quad(small, cfg, best, stages))
         {
             result.status = 0;
-            result.num_matches = num_points;
             return result;
         }
 
-        if (anchor_width <= 0 || anchor_height <= 0)
+        stages.begin("refine");
+        refine_coarse_quad(gray, best,
+                           static_cast<double>(gray.cols) / small.cols,
+                           static_cast<double>(gray.rows) / small.rows);
+        stages.end();
+
+        fill_paper_result(result, best.quad, best.area, cfg, gray.size(), stages);
+        return result;
+    }
+
+    /**
+     * Internal function to detect paper in grayscale image
+     */
+    static PaperDetectionResult detect_paper_internal(
+        const cv::Mat &gray,
+        const PaperDetectionConfig *config)
+    {
+        PaperDetectionResult result = {};
+        StageTimer stages;
+
+        // Use default config if not provided
+        PaperDetectionConfig cfg = resolve_paper_config(config);
+
+        if (cfg.stream_band_rows > 0)
+            return detect_paper_streamed(gray, cfg, stages);
+
+        if (cfg.coarse_max_dimension > 0 && std::max(gray.cols, gray.rows) > cfg.coarse_max_dimension)
+            return detect_paper_coarse(gray, cfg, stages);
+
+        QuadCandidate best;
+        if (!find_paper_quad(gray, cfg, best, stages))
         {
-            result.status = -1;
+            result.status = 0;
             return result;
         }
 
-        // Convert to OpenCV point vectors
-        std::vector<cv::Point2f> pts_anchor, pts_scene;
-        pts_anchor.reserve(num_points);
-        pts_scene.reserve(num_points);
+        stages.end();
+        fill_paper_result(result, best.quad, best.area, cfg, gray.size(), stages);
+        return result;
+    }
 
-        for (int i = 0; i < num_points; i++)
+    /**
+     * Internal function to detect several papers in a grayscale image
+     *
+     * @return Number of results written (0..max_results)
+     */
+    static int detect_papers_internal(
+        const cv::Mat &gray,
+        const PaperDetectionConfig &cfg,
+        PaperDetectionResult *results,
+        int max_results,
+        StageTimer &stages)
+    {
+        // Coarse-to-fine as in detect_paper_coarse, refining every kept quad
+        cv::Mat search = gray;
+        if (cfg.coarse_max_dimension > 0 && std::max(gray.cols, gray.rows) > cfg.coarse_max_dimension)
         {
-            pts_anchor.push_back(cv::Point2f(pts0_x[i], pts0_y[i]));
-            pts_scene.push_back(cv::Point2f(pts1_x[i], pts1_y[i]));
+            stages.begin("resize");
+            double f = static_cast<double>(cfg.coarse_max_dimension) / std::max(gray.cols, gray.rows);
+            cv::resize(gray, search, cv::Size(std::max(1, cvRound(gray.cols * f)), std::max(1, cvRound(gray.rows * f))),
+                       0, 0, cv::INTER_AREA);
         }
 
-        result.num_matches = num_points;
+        QuadCandidate best;
+        std::vector<QuadCandidate> candidates;
+        if (!find_paper_quad(search, cfg, best, stages, &candidates))
+            return 0;
 
-        // Compute homography using RANSAC
-        std::vector<char> inliers_mask;
-        cv::Mat H = cv::findHomography(pts_anchor, pts_scene, cv::RANSAC, RANSAC_THRESH, inliers_mask);
+        stages.begin("select");
+        select_distinct_quads(candidates, max_results);
 
-        // Check if homography was found
-        if (H.empty() || H.rows != 3 || H.cols != 3)
+        if (search.data != gray.data)
+        {
+            stages.begin("refine");
+            for (QuadCandidate &candidate : candidates)
+            {
+                refine_coarse_quad(gray, candidate,
+                                   static_cast<double>(gray.cols) / search.cols,
+                                   static_cast<double>(gray.rows) / search.rows);
+            }
+        }
+
+        stages.end();
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            results[i] = {};
+            fill_paper_result(results[i], candidates[i].quad, candidates[i].area, cfg, gray.size(), stages);
+        }
+        return static_cast<int>(candidates.size());
+    }
+
+    /**
+     * Detect paper inside a region of the frame (tracking)
+     *
+     * Area ratios and the minimum side length keep referring to the whole
+     * frame, and the quad, homography and pose are returned in frame coordinates.
+     */
+    static PaperDetectionResult detect_paper_in_roi(
+        const cv::Mat &gray,
+        const PaperDetectionConfig &cfg,
+        cv::Rect roi,
+        StageTimer &stages)
+    {
+        PaperDetectionResult result = {};
+
+        PaperDetectionConfig roi_cfg = cfg;
+        float frame_to_roi = static_cast<float>(gray.total()) / roi.area();
+        roi_cfg.min_area_ratio *= frame_to_roi;
+        roi_cfg.max_area_ratio *= frame_to_roi;
+
+        QuadCandidate best;
+        if (!find_paper_quad(gray(roi), roi_cfg, best, stages, nullptr, quad_min_edge_length(gray.size())))
         {
             result.status = 0;
             return result;
-        }
+        }
+
+        for (auto &p : best.quad)
+        {
+            p += cv::Point2f(static_cast<float>(roi.x), static_cast<float>(roi.y));
+        }
+
+        stages.end();
+        fill_paper_result(result, best.quad, best.area, cfg, gray.size(), stages);
+        return result;
+    }
+
+    PaperDetectionResult hg_detect_paper(
+        const uint8_t *image_data, int image_width, int image_height, int image_channels,
+        const PaperDetectionConfig *config)
+    {
+        PaperDetectionResult result = {};
+        CaptureScope capture(HG_CALL_DETECT_PAPER);
+        CallStatsScope call_stats;
+        StageTimer stages;
+
+        // Validate input
+        if (image_data == nullptr)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        if (image_width <= 0 || image_height <= 0)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        if (image_channels != 1 && image_channels != 3 && image_channels != 4)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        capture.config(config);
+        capture.field<int32_t>(image_width);
+        capture.field<int32_t>(image_height);
+        capture.field<int32_t>(image_channels);
+        capture.blob(image_data, static_cast<size_t>(image_width) * image_height * image_channels);
+
+        // Convert to grayscale
+        stages.begin("convert");
+        cv::Mat gray = raw_to_gray(image_data, image_width, image_height, image_channels);
+
+        stages.end();
+        return detect_paper_internal(gray, config);
+    }
+
+    int hg_detect_papers(
+        const uint8_t *image_data, int image_width, int image_height, int image_channels,
+        const PaperDetectionConfig *config,
+        PaperDetectionResult *results, int max_results)
+    {
+        CaptureScope capture(HG_CALL_DETECT_PAPERS);
+        CallStatsScope call_stats;
+        StageTimer stages;
+
+        // Validate input
+        if (image_data == nullptr || results == nullptr || max_results <= 0)
+            return -1;
+
+        if (image_width <= 0 || image_height <= 0)
+            return -1;
+
+        if (image_channels != 1 && image_channels != 3 && image_channels != 4)
+            return -1;
+
+        capture.config(config);
+        capture.field<int32_t>(image_width);
+        capture.field<int32_t>(image_height);
+        capture.field<int32_t>(image_channels);
+        capture.field<int32_t>(max_results);
+        capture.blob(image_data, static_cast<size_t>(image_width) * image_height * image_channels);
+
+        // Convert to grayscale
+        stages.begin("convert");
+        cv::Mat gray = raw_to_gray(image_data, image_width, image_height, image_channels);
+
+        stages.end();
+        PaperDetectionConfig cfg = resolve_paper_config(config);
+        return detect_papers_internal(gray, cfg, results, max_results, stages);
+    }
+
+    PaperDetectionResult hg_detect_paper_encoded(
+        const uint8_t *image_bytes, size_t image_size,
+        const PaperDetectionConfig *config)
+    {
+        return hg_detect_paper_encoded_ex(image_bytes, image_size, config, nullptr);
+    }
+
+    PaperDetectionResult hg_detect_paper_encoded_ex(
+        const uint8_t *image_bytes, size_t image_size,
+        const PaperDetectionConfig *config,
+        const HgDecodeOptions *options)
+    {
+        PaperDetectionResult result = {};
+        CaptureScope capture(HG_CALL_DETECT_PAPER_ENCODED);
+        capture.config(config);
+        capture.options(options);
+        capture.field<uint64_t>(image_size);
+        capture.blob(image_bytes, image_size);
+        CallStatsScope call_stats;
+        StageTimer stages;
+
+        // Validate input
+        if (image_bytes == nullptr || image_size == 0)
+        {
+            result.status = -1;
+            return result;
+        }
+
+        // Decode image
+        stages.begin("decode");
+        cv::Size original;
+        int orientation;
+        cv::Mat gray = decode_gray(image_bytes, image_size, options, original, orientation);
+
+        if (gray.empty())
+        {
+            result.status = -1;
+            return result;
+        }
+
+        stages.end();
+        if (gray.size() == original && orientation == 1)
+            return detect_paper_internal(gray, config);
+
+        double sx = static_cast<double>(original.width) / gray.cols;
+        double sy = static_cast<double>(original.height) / gray.rows;
+
+        // Intrinsics refer to the original image; express them in decoded pixels
+        PaperDetectionConfig cfg = resolve_paper_config(config);
+        PaperDetectionConfig scaled_cfg = cfg;
+        scaled_cfg.focal_length /= static_cast<float>(sx);
+        if (cfg.cx > 0)
+            scaled_cfg.cx = static_cast<float>((cfg.cx + 0.5) / sx - 0.5);
+        if (cfg.cy > 0)
+            scaled_cfg.cy = static_cast<float>((cfg.cy + 0.5) / sy - 0.5);
+
+        // Pose is solved after orienting the corners
+        if (orientation != 1)
+            scaled_cfg.focal_length = 0;
+
+        result = detect_paper_internal(gray, &scaled_cfg);
+        if (result.status != 1)
+            return result;
 
-        // Count inliers
-        int num_inliers = 0;
-        for (char inlier : inliers_mask)
+        if (gray.size() != original)
+            scale_paper_result(result, sx, sy);
+
+        if (orientation != 1)
         {
-            if (inlier)
-                num_inliers++;
+            // Move the corners into the displayed frame and rebuild the geometry
+            // there; the 4-point homography equals O * H up to corner order
+            cv::Size displayed;
+            cv::Matx33d O = orientation_matrix(orientation, original, displayed);
+            std::vector<cv::Point2f> quad(4);
+            for (int i = 0; i < 4; i++)
+            {
+                double x = result.corners[i * 2];
+                double y = result.corners[i * 2 + 1];
+                quad[i] = cv::Point2f(static_cast<float>(O(0, 0) * x + O(0, 1) * y + O(0, 2)),
+                                      static_cast<float>(O(1, 0) * x + O(1, 1) * y + O(1, 2)));
+            }
+            quad = order_points_clockwise(quad);
+
+            float area = result.area;
+            result = {};
+            fill_paper_result(result, quad, area, cfg, displayed, stages);
         }
+        return result;
+    }
 
-        // Verify homography quality
-        if (num_inliers < MIN_MATCHES || num_inliers < num_points * 0.3)
+    PaperDetectionResult hg_detect_paper_file(
+        const char *image_path,
+        const PaperDetectionConfig *config,
+        const HgDecodeOptions *options)
+    {
+        PaperDetectionResult result = {};
+
+        MappedFile image(image_path);
+        if (image.data == nullptr)
         {
-            result.status = 0;
+            result.status = -1;
             return result;
         }
 
-        // Copy homography matrix to result
-        for (int i = 0; i < 3; i++)
+        return hg_detect_paper_encoded_ex(image.data, image.size, config, options);
+    }
+
+    HgDecodeOptions hg_default_decode_options(void)
+    {
+        HgDecodeOptions options = {};
+        options.max_dimension = 0;     // Full resolution
+        options.defer_orientation = 0; // Decoder applies EXIF orientation
+        return options;
+    }
+
+    PaperDetectionConfig hg_default_paper_config(void)
+    {
+        PaperDetectionConfig config = {};
+        config.canny_threshold1 = 50;
+        config.canny_threshold2 = 150;
+        config.blur_kernel_size = 5;
+        config.min_area_ratio = 0.05f;
+        config.max_area_ratio = 0.95f;
+        config.expected_aspect_ratio = 210.0f / 297.0f; // A4
+        config.aspect_ratio_tolerance = 0.3f;
+        config.paper_width_mm = 210.0f;
+        config.paper_height_mm = 297.0f;
+        config.focal_length = 0; // Skip pose estimation by default
+        config.cx = 0;
+        config.cy = 0;
+        config.stream_band_rows = 0; // In-memory processing
+        config.stream_edge_downscale = 2;
+        config.coarse_max_dimension = 0; // Full resolution contours
+        config.edge_method = HG_EDGE_OPENCV;
+        config.quad_method = HG_QUAD_CONTOURS;
+        config.canny_hypotheses = 1;
+        config.canny_hypothesis_scale = 0.5f;
+        config.pose_method = HG_POSE_ITERATIVE;
+        config.dist_k1 = 0; // Ideal lens
+        config.dist_k2 = 0;
+        config.dist_p1 = 0;
+        config.dist_p2 = 0;
+        config.dist_k3 = 0;
+        return config;
+    }
+
+    // ============================================================================
+    // Corner Filter Implementation
+    // ============================================================================
+
+    struct HgCornerFilter
+    {
+        HgCornerFilterConfig config;
+        bool initialized = false;
+        float position[8] = {}; // Filtered corners
+        float velocity[8] = {}; // Filtered corner velocity (pixels/second)
+        double last_timestamp = 0;
+        int missed_frames = 0;
+    };
+
+    /**
+     * One-Euro smoothing factor for a step of dt seconds at the given cutoff
+     */
+    static float one_euro_alpha(double dt, float cutoff)
+    {
+        double tau = 1.0 / (2.0 * CV_PI * std::max(cutoff, 1e-3f));
+        return static_cast<float>(1.0 / (1.0 + tau / dt));
+    }
+
+    /**
+     * Seconds between the last measurement and a frame at the given time
+     */
+    static double corner_filter_step(const HgCornerFilter &filter, double timestamp)
+    {
+        if (timestamp > 0 && filter.last_timestamp > 0 && timestamp > filter.last_timestamp)
+            return timestamp - filter.last_timestamp;
+
+        // Fixed frame rate; missed frames still advance time
+        float rate = filter.config.frame_rate > 0 ? filter.config.frame_rate : 30.0f;
+        return (filter.missed_frames + 1) / static_cast<double>(rate);
+    }
+
+    static void corner_filter_measure(HgCornerFilter &filter, const float *corners, double timestamp)
+    {
+        if (!filter.initialized)
         {
-            for (int j = 0; j < 3; j++)
+            std::copy(corners, corners + 8, filter.position);
+            std::fill(filter.velocity, filter.velocity + 8, 0.0f);
+            filter.initialized = true;
+        }
+        else
+        {
+            const HgCornerFilterConfig &cfg = filter.config;
+            double dt = corner_filter_step(filter, timestamp);
+            float derivative_alpha = one_euro_alpha(dt, cfg.derivative_cutoff);
+
+            for (int i = 0; i < 4; i++)
             {
-                result.homography[i * 3 + j] = H.at<double>(i, j);
+                float *p = filter.position + i * 2;
+                float *v = filter.velocity + i * 2;
+                const float *m = corners + i * 2;
+
+                // The corner's speed sets the position cutoff: heavy smoothing
+                // at rest, little lag while the quad moves
+                for (int k = 0; k < 2; k++)
+                    v[k] += derivative_alpha * (static_cast<float>((m[k] - p[k]) / dt) - v[k]);
+
+                float speed = std::sqrt(v[0] * v[0] + v[1] * v[1]);
+                float alpha = one_euro_alpha(dt, cfg.min_cutoff + cfg.beta * speed);
+                for (int k = 0; k < 2; k++)
+                    p[k] += alpha * (m[k] - p[k]);
             }
         }
 
-        // Transform anchor corners to scene coordinates
-        std::vector<cv::Point2f> anchor_corners = {
-            {0, 0},
-            {static_cast<float>(anchor_width), 0},
-            {static_cast<float>(anchor_width), static_cast<float>(anchor_height)},
-            {0, static_cast<float>(anchor_height)}};
+        filter.last_timestamp = timestamp > 0 ? timestamp : 0;
+        filter.missed_frames = 0;
+    }
 
-        std::vector<cv::Point2f> scene_corners;
-        cv::perspectiveTransform(anchor_corners, scene_corners, H);
+    static void corner_filter_predict(const HgCornerFilter &filter, double timestamp, float *out_corners)
+    {
+        float dt = static_cast<float>(corner_filter_step(filter, timestamp));
+        for (int i = 0; i < 8; i++)
+            out_corners[i] = filter.position[i] + filter.velocity[i] * dt;
+    }
 
-        // Store corners in result
+    /**
+     * Re-fit a homography so the source points it mapped onto `measured`
+     * land on `filtered` instead
+     */
+    static void refit_homography(double *homography, const float *measured, const float *filtered)
+    {
+        cv::Matx33d H(homography);
+        if (std::abs(cv::determinant(H)) < 1e-12)
+            return;
+
+        std::vector<cv::Point2f> measured_pts(4), filtered_pts(4), source_pts;
         for (int i = 0; i < 4; i++)
         {
-            result.corners[i * 2] = scene_corners[i].x;
-            result.corners[i * 2 + 1] = scene_corners[i].y;
+            measured_pts[i] = cv::Point2f(measured[i * 2], measured[i * 2 + 1]);
+            filtered_pts[i] = cv::Point2f(filtered[i * 2], filtered[i * 2 + 1]);
         }
+        cv::perspectiveTransform(measured_pts, source_pts, cv::Matx33d(H.inv()));
 
-        // Compute center (average of corners)
-        result.center_x = 0;
-        result.center_y = 0;
-        for (const auto &corner : scene_corners)
-        {
-            result.center_x += corner.x;
-            result.center_y += corner.y;
-        }
-        result.center_x /= 4.0f;
-        result.center_y /= 4.0f;
+        cv::Mat fitted = cv::getPerspectiveTransform(source_pts, filtered_pts);
+        if (fitted.empty())
+            return;
 
-        // Compute rotation angle from top edge
-        float dx = scene_corners[1].x - scene_corners[0].x;
-        float dy = scene_corners[1].y - scene_corners[0].y;
-        result.rotation = std::atan2(dy, dx);
+        for (int i = 0; i < 9; i++)
+            homography[i] = fitted.at<double>(i / 3, i % 3);
+    }
 
-        // Compute scale (average of top and left edge ratios)
-        float top_edge = std::sqrt(dx * dx + dy * dy);
-        float left_dx = scene_corners[3].x - scene_corners[0].x;
-        float left_dy = scene_corners[3].y - scene_corners[0].y;
-        float left_edge = std::sqrt(left_dx * left_dx + left_dy * left_dy);
+    HgCornerFilterConfig hg_default_corner_filter_config(void)
+    {
+        HgCornerFilterConfig config = {};
+        config.min_cutoff = 1.0f;
+        config.beta = 0.01f;
+        config.derivative_cutoff = 1.0f;
+        config.frame_rate = 30.0f;
+        config.max_missed_frames = 3;
+        config.roi_margin = 0.15f;
+        return config;
+    }
 
-        float original_width = static_cast<float>(anchor_width);
-        float original_height = static_cast<float>(anchor_height);
+    HgCornerFilter *hg_corner_filter_create(const HgCornerFilterConfig *config)
+    {
+        HgCornerFilter *filter = new (std::nothrow) HgCornerFilter();
+        if (filter == nullptr)
+            return nullptr;
 
-        result.scale = (top_edge / original_width + left_edge / original_height) / 2.0f;
+        filter->config = config != nullptr ? *config : hg_default_corner_filter_config();
+        return filter;
+    }
 
-        // Validate the detected quadrilateral (should be convex)
-        auto cross_product = [](const cv::Point2f &o, const cv::Point2f &a, const cv::Point2f &b)
-        {
-            return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
-        };
+    void hg_corner_filter_destroy(HgCornerFilter *filter)
+    {
+        delete filter;
+    }
 
-        float cp1 = cross_product(scene_corners[0], scene_corners[1], scene_corners[2]);
-        float cp2 = cross_product(scene_corners[1], scene_corners[2], scene_corners[3]);
-        float cp3 = cross_product(scene_corners[2], scene_corners[3], scene_corners[0]);
-        float cp4 = cross_product(scene_corners[3], scene_corners[0], scene_corners[1]);
+    void hg_corner_filter_reset(HgCornerFilter *filter)
+    {
+        if (filter == nullptr)
+            return;
 
-        bool is_convex = (cp1 > 0 && cp2 > 0 && cp3 > 0 && cp4 > 0) ||
-                         (cp1 < 0 && cp2 < 0 && cp3 < 0 && cp4 < 0);
+        filter->initialized = false;
+        filter->last_timestamp = 0;
+        filter->missed_frames = 0;
+    }
 
-        if (!is_convex)
+    int hg_corner_filter_update(
+        HgCornerFilter *filter,
+        const float *corners,
+        double *homography,
+        double timestamp,
+        float *out_corners)
+    {
+        if (filter == nullptr || out_corners == nullptr)
+            return -1;
+
+        if (corners == nullptr)
         {
-            result.status = 0;
-            return result;
+            // Coast on the last velocity for a few frames before giving up
+            if (filter->initialized && ++filter->missed_frames > filter->config.max_missed_frames)
+                hg_corner_filter_reset(filter);
+            return 0;
         }
 
-        // Check aspect ratio distortion
-        float aspect_ratio = top_edge / left_edge;
-        float original_aspect = original_width / original_height;
-        float aspect_distortion = aspect_ratio / original_aspect;
+        // out_corners may alias corners
+        float measured[8];
+        std::copy(corners, corners + 8, measured);
 
-        if (aspect_distortion < 0.3f || aspect_distortion > 3.0f)
-        {
-            result.status = 0;
-            return result;
-        }
+        corner_filter_measure(*filter, measured, timestamp);
+        std::copy(filter->position, filter->position + 8, out_corners);
 
-        result.num_matches = num_inliers;
-        result.status = 1;
-        return result;
+        if (homography != nullptr)
+            refit_homography(homography, measured, out_corners);
+        return 1;
     }
 
-    const char *hg_lib_version(void)
+    int hg_corner_filter_predict(
+        HgCornerFilter *filter,
+        double timestamp,
+        float *out_corners,
+        float *out_roi)
     {
-        return HOMOGRAPHY_LIB_VERSION;
+        if (filter == nullptr || !filter->initialized)
+            return 0;
+
+        float predicted[8];
+        corner_filter_predict(*filter, timestamp, predicted);
+
+        if (out_corners != nullptr)
+            std::copy(predicted, predicted + 8, out_corners);
+
+        if (out_roi != nullptr)
+        {
+            float min_x = predicted[0], max_x = predicted[0];
+            float min_y = predicted[1], max_y = predicted[1];
+            for (int i = 1; i < 4; i++)
+            {
+                min_x = std::min(min_x, predicted[i * 2]);
+                max_x = std::max(max_x, predicted[i * 2]);
+                min_y = std::min(min_y, predicted[i * 2 + 1]);
+                max_y = std::max(max_y, predicted[i * 2 + 1]);
+            }
+
+            float pad = filter->config.roi_margin * std::max(max_x - min_x, max_y - min_y);
+            out_roi[0] = min_x - pad;
+            out_roi[1] = min_y - pad;
+            out_roi[2] = max_x - min_x + 2 * pad;
+            out_roi[3] = max_y - min_y + 2 * pad;
+        }
+        return 1;
     }
 
     // ============================================================================
-    // Paper Detection Implementation
+    // Paper Tracking Implementation
     // ============================================================================
 
+    struct HgPaperTracker
+    {
+        PaperDetectionConfig config;
+        PaperDetectionConfig search_config; // config without pose; update() solves it once per frame
+        HgTrackerConfig tracker_config;
+        cv::Size frame_size;
+        std::vector<cv::Point2f> quad; // Clockwise from top-left; empty when lost
+        int frames_since_full_scan = 0;
+        HgCornerFilter filter; // Used when tracker_config.filter_corners is set
+        bool has_pose = false;
+        double pose[6];            // rvec then tvec of the last frame (tracker_config.seed_pose)
+        DistortionMap distortion;  // Snap sampling map of frame_size; empty for an ideal lens
+    };
+
     /**
-     * Order points in clockwise order starting from top-left
+     * Search region around the previously tracked quad, clipped to the frame
      */
-    static std::vector<cv::Point2f> order_points_clockwise(const std::vector<cv::Point2f> &pts)
+    static cv::Rect tracking_roi(const std::vector<cv::Point2f> &quad, float margin, cv::Size frame)
     {
-        if (pts.size() != 4)
-            return pts;
+        cv::Rect box = cv::boundingRect(quad);
+        int pad = cvCeil(margin * std::max(box.width, box.height));
 
-        std::vector<cv::Point2f> ordered(4);
+        cv::Rect roi(box.x - pad, box.y - pad, box.width + 2 * pad, box.height + 2 * pad);
+        return roi & cv::Rect(0, 0, frame.width, frame.height);
+    }
 
-        // Sum of coordinates: top-left has smallest sum, bottom-right has largest
-        // Difference: top-right has smallest diff, bottom-left has largest
-        std::vector<float> sums(4), diffs(4);
-        for (int i = 0; i < 4; i++)
+    /**
+     * Snap the tracked quad to the edges of a new frame
+     *
+     * @return false if the fit is too weak to trust (caller falls back to detection)
+     */
+    static bool snap_tracked_quad(
+        const cv::Mat &gray,
+        const HgPaperTracker &tracker,
+        PaperDetectionResult &result,
+        StageTimer &stages)
+    {
+        const HgTrackerConfig &tcfg = tracker.tracker_config;
+        const PaperDetectionConfig &cfg = tracker.search_config;
+
+        stages.begin("snap");
+        std::vector<cv::Point2f> quad = tracker.quad;
+        const DistortionMap *distortion = tracker.distortion.grid.empty() ? nullptr : &tracker.distortion;
+
+        // Fit straight sides in undistorted pixels, then map the corners back
+        if (distortion != nullptr)
+            undistort_pixels(quad, distortion->K, distortion->dist_coeffs);
+
+        QuadFitStats fit;
+        if (refine_quad_edges(gray, quad, tcfg.snap_search_radius, &fit, distortion) != 4)
+            return false;
+
+        if (fit.min_support < tcfg.snap_min_support || fit.max_residual > tcfg.snap_max_residual)
+            return false;
+
+        if (distortion != nullptr)
         {
-            sums[i] = pts[i].x + pts[i].y;
-            diffs[i] = pts[i].y - pts[i].x;
+            for (cv::Point2f &p : quad)
+                p = distort_point(*distortion, p);
         }
 
-        auto min_sum_it = std::min_element(sums.begin(), sums.end());
-        auto max_sum_it = std::max_element(sums.begin(), sums.end());
-        auto min_diff_it = std::min_element(diffs.begin(), diffs.end());
-        auto max_diff_it = std::max_element(diffs.begin(), diffs.end());
+        if (!is_convex_quadrilateral(quad))
+            return false;
 
-        ordered[0] = pts[min_sum_it - sums.begin()];   // top-left
-        ordered[1] = pts[min_diff_it - diffs.begin()]; // top-right
-        ordered[2] = pts[max_sum_it - sums.begin()];   // bottom-right
-        ordered[3] = pts[max_diff_it - diffs.begin()]; // bottom-left
+        float area = static_cast<float>(cv::contourArea(quad));
+        float image_area = static_cast<float>(gray.total());
+        if (area < image_area * cfg.min_area_ratio || area > image_area * cfg.max_area_ratio)
+            return false;
 
-        return ordered;
+        stages.end();
+        fill_paper_result(result, quad, area, cfg, gray.size(), stages);
+        return true;
     }
 
-    /**
-     * Check if a quadrilateral is convex
-     */
-    static bool is_convex_quadrilateral(const std::vector<cv::Point2f> &pts)
+    HgTrackerConfig hg_default_tracker_config(void)
     {
-        if (pts.size() != 4)
-            return false;
+        HgTrackerConfig config = {};
+        config.roi_margin = 0.15f;
+        config.full_scan_interval = 15;
+        config.snap_tracking = 0;
+        config.snap_search_radius = 12.0f;
+        config.snap_min_support = 0.6f;
+        config.snap_max_residual = 1.5f;
+        config.filter_corners = 0;
+        config.filter_min_cutoff = 1.0f;
+        config.filter_beta = 0.01f;
+        config.filter_frame_rate = 30.0f;
+        config.seed_pose = 1;
+        return config;
+    }
 
-        auto cross_product = [](const cv::Point2f &o, const cv::Point2f &a, const cv::Point2f &b)
-        {
-            return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
-        };
+    HgPaperTracker *hg_paper_tracker_create(
+        const PaperDetectionConfig *config,
+        const HgTrackerConfig *tracker_config)
+    {
+        HgPaperTracker *tracker = new (std::nothrow) HgPaperTracker();
+        if (tracker == nullptr)
+            return nullptr;
+
+        tracker->config = resolve_paper_config(config);
+        tracker->search_config = tracker->config;
+        tracker->search_config.focal_length = 0;
+        tracker->tracker_config = tracker_config != nullptr ? *tracker_config : hg_default_tracker_config();
+
+        tracker->filter.config = hg_default_corner_filter_config();
+        tracker->filter.config.min_cutoff = tracker->tracker_config.filter_min_cutoff;
+        tracker->filter.config.beta = tracker->tracker_config.filter_beta;
+        tracker->filter.config.frame_rate = tracker->tracker_config.filter_frame_rate;
+        return tracker;
+    }
 
-        float cp1 = cross_product(pts[0], pts[1], pts[2]);
-        float cp2 = cross_product(pts[1], pts[2], pts[3]);
-        float cp3 = cross_product(pts[2], pts[3], pts[0]);
-        float cp4 = cross_product(pts[3], pts[0], pts[1]);
+    void hg_paper_tracker_destroy(HgPaperTracker *tracker)
+    {
+        delete tracker;
+    }
 
-        return (cp1 > 0 && cp2 > 0 && cp3 > 0 && cp4 > 0) ||
-               (cp1 < 0 && cp2 < 0 && cp3 < 0 && cp4 < 0);
+    void hg_paper_tracker_reset(HgPaperTracker *tracker)
+    {
+        if (tracker == nullptr)
+            return;
+
+        tracker->quad.clear();
+        tracker->frames_since_full_scan = 0;
+        tracker->has_pose = false;
+        hg_corner_filter_reset(&tracker->filter);
     }
 
-    /**
-     * Compute edge length
-     */
-    static float edge_length(const cv::Point2f &p1, const cv::Point2f &p2)
+    PaperDetectionResult hg_paper_tracker_update(
+        HgPaperTracker *tracker,
+        const uint8_t *image_data, int image_width, int image_height, int image_channels)
     {
-        float dx = p2.x - p1.x;
-        float dy = p2.y - p1.y;
-        return std::sqrt(dx * dx + dy * dy);
+        return hg_paper_tracker_update_at(tracker, image_data, image_width, image_height, image_channels, 0);
     }
 
-    /**
-     * Internal function to detect paper in grayscale image
-     */
-    static PaperDetectionResult detect_paper_internal(
-        const cv::Mat &gray,
-        const PaperDetectionConfig *config)
+    PaperDetectionResult hg_paper_tracker_update_at(
+        HgPaperTracker *tracker,
+        const uint8_t *image_data, int image_width, int image_height, int image_channels,
+        double timestamp)
     {
         PaperDetectionResult result = {};
+        CallStatsScope call_stats;
+        StageTimer stages;
 
-        // Use default config if not provided
-        PaperDetectionConfig cfg;
-        if (config != nullptr)
+        // Validate input
+        if (tracker == nullptr || image_data == nullptr)
         {
-            cfg = *config;
+            result.status = -1;
+            return result;
         }
-        else
-        {
-            cfg.canny_threshold1 = 50;
-            cfg.canny_threshold2 = 150;
-            cfg.blur_kernel_size = 5;
-            cfg.min_area_ratio = 0.05f;
-            cfg.max_area_ratio = 0.95f;
-            cfg.expected_aspect_ratio = 210.0f / 297.0f; // A4
-            cfg.aspect_ratio_tolerance = 0.3f;
-            cfg.paper_width_mm = 210.0f;
-            cfg.paper_height_mm = 297.0f;
-            cfg.focal_length = 0; // Skip pose estimation
-            cfg.cx = 0;
-            cfg.cy = 0;
-        }
-
-        float image_area = static_cast<float>(gray.cols * gray.rows);
-        float min_area = image_area * cfg.min_area_ratio;
-        float max_area = image_area * cfg.max_area_ratio;
 
-        // Apply Gaussian blur to reduce noise
-        cv::Mat blurred;
-        if (cfg.blur_kernel_size > 0 && cfg.blur_kernel_size % 2 == 1)
-        {
-            cv::GaussianBlur(gray, blurred, cv::Size(cfg.blur_kernel_size, cfg.blur_kernel_size), 0);
-        }
-        else
+        if (image_width <= 0 || image_height <= 0)
         {
-            blurred = gray;
+            result.status = -1;
+            return result;
         }
 
-        // Apply Canny edge detection
-        cv::Mat edges;
-        cv::Canny(blurred, edges, cfg.canny_threshold1, cfg.canny_threshold2);
-
-        // Dilate edges to close gaps
-        cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
-        cv::dilate(edges, edges, kernel);
-
-        // Find contours
-        std::vector<std::vector<cv::Point>> contours;
-        cv::findContours(edges, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-        if (contours.empty())
+        if (image_channels != 1 && image_channels != 3 && image_channels != 4)
         {
-            result.status = 0;
+            result.status = -1;
             return result;
         }
 
-        // Find the best quadrilateral contour
-        std::vector<cv::Point2f> best_quad;
-        float best_score = -1.0f;
-        float best_area = 0;
+        // Convert to grayscale
+        stages.begin("convert");
+        cv::Mat gray = raw_to_gray(image_data, image_width, image_height, image_channels);
+        stages.end();
 
-        // Minimum edge length in pixels (to filter out noise)
-        float min_edge_length = std::min(gray.cols, gray.rows) * 0.05f; // At least 5% of smaller dimension
-        
-        for (const auto &contour : contours)
+        // A resized stream invalidates the tracked position
+        if (gray.size() != tracker->frame_size)
         {
-            float area = static_cast<float>(cv::contourArea(contour));
+            hg_paper_tracker_reset(tracker);
+            tracker->frame_size = gray.size();
+            if (tracker->tracker_config.snap_tracking)
+                build_distortion_map(tracker->config, gray.size(), tracker->distortion);
+        }
 
-            // Filter by area
-            if (area < min_area || area > max_area)
-                continue;
+        bool full_scan = tracker->quad.empty() ||
+                         ++tracker->frames_since_full_scan >= tracker->tracker_config.full_scan_interval;
+        bool filtering = tracker->tracker_config.filter_corners != 0;
 
-            // Approximate the contour to a polygon
-            // Use larger epsilon (0.03-0.04) for more aggressive simplification
-            float peri = static_cast<float>(cv::arcLength(contour, true));
-            std::vector<cv::Point> approx;
-            cv::approxPolyDP(contour, approx, 0.035 * peri, true);
+        // Search where the filter expects the quad rather than where it was
+        if (!full_scan && filtering && tracker->filter.initialized)
+        {
+            float predicted[8];
+            corner_filter_predict(tracker->filter, timestamp, predicted);
+            for (int i = 0; i < 4; i++)
+            {
+                tracker->quad[i] = cv::Point2f(predicted[i * 2], predicted[i * 2 + 1]);
+            }
+        }
 
-            // We need exactly 4 points (quadrilateral)
-            if (approx.size() != 4)
-                continue;
+        // Snapping needs no edge detection at all; try it first
+        bool snapped = false;
+        if (!full_scan && tracker->tracker_config.snap_tracking)
+            snapped = snap_tracked_quad(gray, *tracker, result, stages);
 
-            // Convert to Point2f
-            std::vector<cv::Point2f> quad;
-            for (const auto &p : approx)
+        if (!full_scan && !snapped)
+        {
+            cv::Rect roi = tracking_roi(tracker->quad, tracker->tracker_config.roi_margin, gray.size());
+            if (roi.area() > 0 && roi.area() < static_cast<int>(gray.total()))
             {
-                quad.push_back(cv::Point2f(static_cast<float>(p.x), static_cast<float>(p.y)));
+                result = detect_paper_in_roi(gray, tracker->search_config, roi, stages);
             }
 
-            // Order points clockwise
-            quad = order_points_clockwise(quad);
+            // Lost inside the region: re-acquire on the whole frame
+            full_scan = result.status != 1;
+        }
 
-            // Check if convex
-            if (!is_convex_quadrilateral(quad))
-                continue;
+        if (full_scan)
+        {
+            stages.end();
+            result = detect_paper_internal(gray, &tracker->search_config);
+            tracker->frames_since_full_scan = 0;
+        }
 
-            // Compute edge lengths
-            float edge0 = edge_length(quad[0], quad[1]); // top
-            float edge1 = edge_length(quad[1], quad[2]); // right
-            float edge2 = edge_length(quad[2], quad[3]); // bottom
-            float edge3 = edge_length(quad[3], quad[0]); // left
-            
-            // Check minimum edge length (filter out small noise contours)
-            float min_edge = std::min({edge0, edge1, edge2, edge3});
-            if (min_edge < min_edge_length)
-                continue;
-            
-            // Compute aspect ratio (width / height)
-            float width = (edge0 + edge2) / 2.0f;
-            float height = (edge1 + edge3) / 2.0f;
+        tracker->quad.clear();
+        if (result.status != 1)
+        {
+            tracker->has_pose = false;
+
+            // Count the miss like a standalone filter, keeping the velocity
+            // for the next detection until max_missed_frames runs out
+            float coasted[8];
+            if (filtering)
+                hg_corner_filter_update(&tracker->filter, nullptr, nullptr, timestamp, coasted);
+            return result;
+        }
+
+        for (int i = 0; i < 4; i++)
+        {
+            tracker->quad.push_back(cv::Point2f(result.corners[i * 2], result.corners[i * 2 + 1]));
+        }
 
-            // Ensure width < height for portrait orientation
-            float aspect_ratio = std::min(width, height) / std::max(width, height);
+        if (filtering)
+        {
+            // Report the filtered quad (with pose and homography re-derived from it)
+            corner_filter_measure(tracker->filter, result.corners, timestamp);
 
-            // Check aspect ratio if expected ratio is provided
-            if (cfg.expected_aspect_ratio > 0)
+            std::vector<cv::Point2f> filtered(4);
+            for (int i = 0; i < 4; i++)
             {
-                float ratio_diff = std::abs(aspect_ratio - cfg.expected_aspect_ratio) / cfg.expected_aspect_ratio;
-                if (ratio_diff > cfg.aspect_ratio_tolerance)
-                    continue;
+                filtered[i] = cv::Point2f(tracker->filter.position[i * 2], tracker->filter.position[i * 2 + 1]);
             }
-
-            // Score: prefer larger area with better aspect ratio match
-            float aspect_score = 1.0f;
-            if (cfg.expected_aspect_ratio > 0)
+            if (is_convex_quadrilateral(filtered))
             {
-                float ratio_diff = std::abs(aspect_ratio - cfg.expected_aspect_ratio) / cfg.expected_aspect_ratio;
-                aspect_score = 1.0f - ratio_diff;
+                fill_paper_result(result, filtered, static_cast<float>(cv::contourArea(filtered)),
+                                  tracker->search_config, gray.size(), stages);
             }
+        }
 
-            float score = area * aspect_score;
+        // Pose of the returned quad, solved once per frame
+        if (tracker->config.focal_length > 0)
+        {
+            stages.begin("pose");
+            std::vector<cv::Point2f> quad(4);
+            for (int i = 0; i < 4; i++)
+            {
+                quad[i] = cv::Point2f(result.corners[i * 2], result.corners[i * 2 + 1]);
+            }
 
-            if (score > best_score)
+            bool seeded = tracker->tracker_config.seed_pose && tracker->has_pose;
+            tracker->has_pose = estimate_paper_pose(quad, result.homography, tracker->config, gray.size(),
+                                                    seeded ? tracker->pose : nullptr, result.rvec, result.tvec);
+            if (tracker->has_pose)
             {
-                best_score = score;
-                best_quad = quad;
-                best_area = area;
+                std::copy(result.rvec, result.rvec + 3, tracker->pose);
+                std::copy(result.tvec, result.tvec + 3, tracker->pose + 3);
             }
         }
+        return result;
+    }
 
-        if (best_quad.empty())
-        {
-            result.status = 0;
-            return result;
-        }
+    // ============================================================================
+    // Paper Rectification Implementation
+    // ============================================================================
 
-        // Store corners
+    /**
+     * Corners must be finite and form a convex quad; a self-intersecting or
+     * degenerate one can put w = 0 of the warp inside the output
+     */
+    static bool valid_rectify_corners(const float *corners)
+    {
+        cv::Point2f quad[4];
         for (int i = 0; i < 4; i++)
         {
-            result.corners[i * 2] = best_quad[i].x;
-            result.corners[i * 2 + 1] = best_quad[i].y;
+            if (!std::isfinite(corners[i * 2]) || !std::isfinite(corners[i * 2 + 1]))
+                return false;
+            quad[i] = cv::Point2f(corners[i * 2], corners[i * 2 + 1]);
         }
+        return is_convex_quad(quad);
+    }
 
-        // Compute center
-        result.center_x = 0;
-        result.center_y = 0;
-        for (const auto &p : best_quad)
-        {
-            result.center_x += p.x;
-            result.center_y += p.y;
-        }
-        result.center_x /= 4.0f;
-        result.center_y /= 4.0f;
+    int hg_rectify_paper(
+        const uint8_t *image_data, int image_width, int image_height, int image_channels,
+        const float *corners,
+        int out_width, int out_height,
+        uint8_t *out_data)
+    {
+        CallStatsScope call_stats;
+        StageTimer stages;
 
-        // Compute area and perimeter
-        result.area = best_area;
-        result.perimeter = 0;
-        for (int i = 0; i < 4; i++)
-        {
-            result.perimeter += edge_length(best_quad[i], best_quad[(i + 1) % 4]);
-        }
+        // Validate input
+        if (image_data == nullptr || corners == nullptr || out_data == nullptr)
+            return -1;
 
-        // Compute aspect ratio
-        float width = (edge_length(best_quad[0], best_quad[1]) + edge_length(best_quad[3], best_quad[2])) / 2.0f;
-        float height = (edge_length(best_quad[0], best_quad[3]) + edge_length(best_quad[1], best_quad[2])) / 2.0f;
-        result.aspect_ratio = std::min(width, height) / std::max(width, height);
+        if (image_width < 2 || image_height < 2 || out_width <= 0 || out_height <= 0)
+            return -1;
 
-        // Compute homography from canonical rectangle to detected quad
-        // Canonical rectangle: [0,0], [paper_width, 0], [paper_width, paper_height], [0, paper_height]
-        float paper_w = (cfg.paper_width_mm > 0) ? cfg.paper_width_mm : 210.0f;
-        float paper_h = (cfg.paper_height_mm > 0) ? cfg.paper_height_mm : 297.0f;
+        if (image_channels != 1 && image_channels != 3 && image_channels != 4)
+            return -1;
 
-        // Determine orientation: if detected quad is more wide than tall, swap dimensions
-        if (width > height)
-        {
-            std::swap(paper_w, paper_h);
-        }
+        if (!valid_rectify_corners(corners))
+            return -1;
 
-        std::vector<cv::Point2f> canonical_corners = {
-            {0, 0},
-            {paper_w, 0},
-            {paper_w, paper_h},
-            {0, paper_h}};
+        const int type = CV_8UC(image_channels);
+        cv::Mat src(image_height, image_width, type, const_cast<uint8_t *>(image_data));
+        cv::Mat dst(out_height, out_width, type, out_data);
 
-        cv::Mat H = cv::findHomography(canonical_corners, best_quad);
+        stages.begin("warp");
+        warp_perspective_fixed(src, rectify_homography(corners, dst.size()), dst);
+        return 1;
+    }
 
-        if (!H.empty() && H.rows == 3 && H.cols == 3)
+    struct HgRectifier
+    {
+        HgRectifierConfig config;
+        cv::Size src_size; // Source geometry the offsets were computed for
+        int src_step = 0;
+        int channels = 0;
+        cv::Size out_size;
+        std::vector<int32_t> offset; // Fixed-point remap tables, one entry per output pixel
+        std::vector<uint8_t> wx, wy;
+        std::vector<cv::Matx33d> tile_homography; // Homography each tile's tables were built with
+        std::vector<uint8_t> tile_valid;
+    };
+
+    HgRectifierConfig hg_default_rectifier_config(void)
+    {
+        HgRectifierConfig config = {};
+        config.reuse_tolerance = 0.25f;
+        return config;
+    }
+
+    HgRectifier *hg_rectifier_create(const HgRectifierConfig *config)
+    {
+        HgRectifier *rectifier = new (std::nothrow) HgRectifier();
+        if (rectifier == nullptr)
+            return nullptr;
+
+        rectifier->config = config != nullptr ? *config : hg_default_rectifier_config();
+        return rectifier;
+    }
+
+    void hg_rectifier_destroy(HgRectifier *rectifier)
+    {
+        delete rectifier;
+    }
+
+    void hg_rectifier_reset(HgRectifier *rectifier)
+    {
+        if (rectifier == nullptr)
+            return;
+
+        std::fill(rectifier->tile_valid.begin(), rectifier->tile_valid.end(), 0);
+    }
+
+    int hg_rectifier_rectify(
+        HgRectifier *rectifier,
+        const uint8_t *image_data, int image_width, int image_height, int image_channels,
+        const float *corners,
+        int out_width, int out_height,
+        uint8_t *out_data)
+    {
+        CallStatsScope call_stats;
+        StageTimer stages;
+
+        // Validate input
+        if (rectifier == nullptr || image_data == nullptr || corners == nullptr || out_data == nullptr)
+            return -1;
+
+        if (image_width < 2 || image_height < 2 || out_width <= 0 || out_height <= 0)
+            return -1;
+
+        if (image_channels != 1 && image_channels != 3 && image_channels != 4)
+            return -1;
+
+        if (!valid_rectify_corners(corners))
+            return -1;
+
+        const int type = CV_8UC(image_channels);
+        cv::Mat src(image_height, image_width, type, const_cast<uint8_t *>(image_data));
+        cv::Mat dst(out_height, out_width, type, out_data);
+        const int src_step = static_cast<int>(src.step);
+
+        // Offsets are byte positions in the source: any change of geometry
+        // invalidates every tile
+        HgRectifier &r = *rectifier;
+        if (src.size() != r.src_size || src_step != r.src_step || image_channels != r.channels || dst.size() != r.out_size)
         {
-            for (int i = 0; i < 3; i++)
+            stages.begin("alloc");
+            r.src_size = src.size();
+            r.src_step = src_step;
+            r.channels = image_channels;
+            r.out_size = dst.size();
+
+            const size_t pixels = dst.total();
+            r.offset.resize(pixels);
+            r.wx.resize(pixels);
+            r.wy.resize(pixels);
+            r.tile_homography.resize(warp_tile_count(dst.size()));
+            r.tile_valid.assign(r.tile_homography.size(), 0);
+        }
+
+        // Tiles whose tables still sample within reuse_tolerance of the new
+        // homography keep them; the others are rebuilt with it
+        stages.begin("warp");
+        const cv::Matx33d H = rectify_homography(corners, dst.size());
+        const double tolerance = r.config.reuse_tolerance;
+        cv::parallel_for_(cv::Range(0, static_cast<int>(r.tile_homography.size())), [&](const cv::Range &range)
+                          {
+            for (int t = range.start; t < range.end; t++)
             {
-                for (int j = 0; j < 3; j++)
+                const cv::Rect tile = warp_tile(t, dst.size());
+                bool rebuild = !r.tile_valid[t] || warp_tile_deviation(r.tile_homography[t], H, tile) > tolerance;
+                if (rebuild)
                 {
-                    result.homography[i * 3 + j] = H.at<double>(i, j);
+                    r.tile_homography[t] = H;
+                    r.tile_valid[t] = 1;
                 }
-            }
-        }
-
-        // Compute camera pose if intrinsics are provided
-        if (cfg.focal_length > 0)
-        {
-            // Camera matrix
-            cv::Mat camera_matrix = (cv::Mat_<double>(3, 3) << cfg.focal_length, 0, cfg.cx > 0 ? cfg.cx : gray.cols / 2.0,
-                                     0, cfg.focal_length, cfg.cy > 0 ? cfg.cy : gray.rows / 2.0,
-                                     0, 0, 1);
 
-            // No distortion
-            cv::Mat dist_coeffs = cv::Mat::zeros(4, 1, CV_64F);
+                for (int y = tile.y; y < tile.y + tile.height; y++)
+                {
+                    const size_t row = static_cast<size_t>(y) * dst.cols + tile.x;
+                    if (rebuild)
+                        warp_map_row(H, tile.x, y, tile.width, src.size(), src_step, image_channels,
+                                     &r.offset[row], &r.wx[row], &r.wy[row]);
+                    warp_blend_row(src.data, src_step, image_channels, &r.offset[row], &r.wx[row], &r.wy[row],
+                                   dst.ptr<uint8_t>(y) + tile.x * image_channels, tile.width);
+                }
+            } });
+        return 1;
+    }
 
-            // 3D object points (paper corners in paper coordinate system, Z=0)
-            std::vector<cv::Point3f> object_points = {
-                {0, 0, 0},
-                {paper_w, 0, 0},
-                {paper_w, paper_h, 0},
-                {0, paper_h, 0}};
+    struct HgImageBuffer
+    {
+        std::vector<uchar> bytes; // Encoded output; capacity is kept between calls
+        cv::Mat warped;           // Pixel scratch, reallocated only when the size changes
+        cv::Mat converted;
+        cv::Mat resized;
+        cv::Mat binary;
+    };
 
-            cv::Mat rvec, tvec;
-            bool solved = cv::solvePnP(object_points, best_quad, camera_matrix, dist_coeffs, rvec, tvec);
+    HgEncodeOptions hg_default_encode_options(void)
+    {
+        HgEncodeOptions options = {};
+        options.format = HG_ENCODE_JPEG;
+        options.quality = 90;
+        options.max_dimension = 0; // Requested output size
+        options.grayscale = 0;
+        options.binarize = 0;
+        return options;
+    }
 
-            if (solved)
-            {
-                result.rvec[0] = rvec.at<double>(0);
-                result.rvec[1] = rvec.at<double>(1);
-                result.rvec[2] = rvec.at<double>(2);
-                result.tvec[0] = tvec.at<double>(0);
-                result.tvec[1] = tvec.at<double>(1);
-                result.tvec[2] = tvec.at<double>(2);
-            }
-        }
+    HgImageBuffer *hg_image_buffer_create(void)
+    {
+        return new (std::nothrow) HgImageBuffer();
+    }
 
-        result.status = 1;
-        return result;
+    void hg_image_buffer_destroy(HgImageBuffer *buffer)
+    {
+        delete buffer;
     }
 
-    PaperDetectionResult hg_detect_paper(
+    HgEncodedImage hg_rectify_paper_encoded(
+        HgImageBuffer *buffer,
         const uint8_t *image_data, int image_width, int image_height, int image_channels,
-        const PaperDetectionConfig *config)
+        const float *corners,
+        int out_width, int out_height,
+        const HgEncodeOptions *options)
     {
-        PaperDetectionResult result = {};
+        HgEncodedImage result = {};
+        CallStatsScope call_stats;
+        StageTimer stages;
+
+        const HgEncodeOptions opts = options != nullptr ? *options : hg_default_encode_options();
 
         // Validate input
-        if (image_data == nullptr)
+        if (buffer == nullptr || image_data == nullptr || corners == nullptr)
         {
             result.status = -1;
             return result;
         }
 
-        if (image_width <= 0 || image_height <= 0)
+        if (image_width < 2 || image_height < 2 || out_width <= 0 || out_height <= 0)
         {
             result.status = -1;
             return result;
@@ -835,72 +5632,253 @@ extern "C"
             return result;
         }
 
-        // Create cv::Mat from raw data
-        int cv_type = image_channels == 1 ? CV_8UC1 : image_channels == 3 ? CV_8UC3
-                                                                          : CV_8UC4;
+        if (opts.format != HG_ENCODE_JPEG && opts.format != HG_ENCODE_PNG)
+        {
+            result.status = -1;
+            return result;
+        }
 
-        cv::Mat image(image_height, image_width, cv_type, const_cast<uint8_t *>(image_data));
+        if (!valid_rectify_corners(corners))
+        {
+            result.status = -1;
+            return result;
+        }
 
-        // Convert to grayscale
-        cv::Mat gray;
-        if (image_channels == 1)
+        // Warp in the source channels; the page is usually smaller than the
+        // frame, so converting afterwards touches fewer pixels
+        stages.begin("warp");
+        cv::Mat src(image_height, image_width, CV_8UC(image_channels), const_cast<uint8_t *>(image_data));
+        buffer->warped.create(out_height, out_width, src.type());
+        warp_perspective_fixed(src, rectify_homography(corners, buffer->warped.size()), buffer->warped);
+        cv::Mat image = buffer->warped;
+
+        // Encoders take BGR(A)
+        const bool gray = opts.grayscale || opts.binarize;
+        if (image_channels > 1)
         {
-            gray = image;
+            stages.begin("convert");
+            int code;
+            if (gray)
+                code = image_channels == 3 ? cv::COLOR_RGB2GRAY : cv::COLOR_RGBA2GRAY;
+            else if (image_channels == 3)
+                code = cv::COLOR_RGB2BGR;
+            else
+                code = opts.format == HG_ENCODE_PNG ? cv::COLOR_RGBA2BGRA : cv::COLOR_RGBA2BGR;
+            cv::cvtColor(image, buffer->converted, code);
+            image = buffer->converted;
         }
-        else if (image_channels == 3)
+
+        if (opts.max_dimension > 0 && std::max(image.cols, image.rows) > opts.max_dimension)
         {
-            cv::cvtColor(image, gray, cv::COLOR_RGB2GRAY);
+            stages.begin("resize");
+            double scale = static_cast<double>(opts.max_dimension) / std::max(image.cols, image.rows);
+            cv::Size size(std::max(1, cvRound(image.cols * scale)), std::max(1, cvRound(image.rows * scale)));
+            cv::resize(image, buffer->resized, size, 0, 0, cv::INTER_AREA);
+            image = buffer->resized;
+        }
+
+        if (opts.binarize)
+        {
+            stages.begin("binarize");
+            int block = std::max(3, (std::max(image.cols, image.rows) / 40) | 1);
+            cv::adaptiveThreshold(image, buffer->binary, 255, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY, block, 10);
+            image = buffer->binary;
+        }
+
+        stages.begin("encode");
+        std::vector<int> params;
+        if (opts.format == HG_ENCODE_JPEG)
+        {
+            params = {cv::IMWRITE_JPEG_QUALITY, std::min(std::max(opts.quality, 1), 100)};
         }
         else
         {
-            cv::cvtColor(image, gray, cv::COLOR_RGBA2GRAY);
+            params = {cv::IMWRITE_PNG_COMPRESSION, 3};
+            if (opts.binarize)
+            {
+                params.push_back(cv::IMWRITE_PNG_BILEVEL);
+                params.push_back(1);
+            }
         }
 
-        return detect_paper_internal(gray, config);
+        if (!cv::imencode(opts.format == HG_ENCODE_JPEG ? ".jpg" : ".png", image, buffer->bytes, params))
+        {
+            result.status = -2;
+            return result;
+        }
+
+        result.data = buffer->bytes.data();
+        result.size = buffer->bytes.size();
+        result.width = image.cols;
+        result.height = image.rows;
+        result.status = 1;
+        return result;
     }
 
-    PaperDetectionResult hg_detect_paper_encoded(
-        const uint8_t *image_bytes, size_t image_size,
-        const PaperDetectionConfig *config)
+    // ============================================================================
+    // Point Transform Implementation
+    // ============================================================================
+
+    int hg_transform_points(
+        const double *homography,
+        const float *in_xy, float *out_xy,
+        int n, int layout)
     {
-        PaperDetectionResult result = {};
+        CallStatsScope call_stats;
 
         // Validate input
-        if (image_bytes == nullptr || image_size == 0)
+        if (homography == nullptr || n < 0)
+            return -1;
+
+        if (layout != HG_POINTS_INTERLEAVED && layout != HG_POINTS_SOA)
+            return -1;
+
+        if (n > 0 && (in_xy == nullptr || out_xy == nullptr))
+            return -1;
+
+        for (int i = 0; i < 9; i++)
         {
-            result.status = -1;
-            return result;
+            if (!std::isfinite(homography[i]))
+                return -1;
         }
 
-        // Decode image
-        std::vector<uint8_t> image_vec(image_bytes, image_bytes + image_size);
-        cv::Mat gray = cv::imdecode(image_vec, cv::IMREAD_GRAYSCALE);
+        transform_points(cv::Matx33d(homography), in_xy, out_xy, n, layout);
+        return 1;
+    }
 
-        if (gray.empty())
+    int hg_transform_points_inverse(
+        const double *homography,
+        const float *in_xy, float *out_xy,
+        int n, int layout)
+    {
+        CallStatsScope call_stats;
+
+        if (homography == nullptr)
+            return -1;
+
+        cv::Matx33d H(homography);
+        const double det = cv::determinant(H);
+        if (!std::isfinite(det) || std::abs(det) < 1e-12)
+            return -1;
+
+        cv::Matx33d H_inv = H.inv();
+        return hg_transform_points(H_inv.val, in_xy, out_xy, n, layout);
+    }
+
+    int hg_perspective_matrix4(
+        const float *src_corners, const float *dst_corners,
+        double *out_matrix4)
+    {
+        CallStatsScope call_stats;
+
+        // Validate input
+        if (src_corners == nullptr || dst_corners == nullptr || out_matrix4 == nullptr)
+            return -1;
+
+        std::vector<cv::Point2f> src(4), dst(4);
+        for (int i = 0; i < 4; i++)
         {
-            result.status = -1;
-            return result;
+            src[i] = cv::Point2f(src_corners[i * 2], src_corners[i * 2 + 1]);
+            dst[i] = cv::Point2f(dst_corners[i * 2], dst_corners[i * 2 + 1]);
+            if (!std::isfinite(src[i].x) || !std::isfinite(src[i].y) ||
+                !std::isfinite(dst[i].x) || !std::isfinite(dst[i].y))
+                return -1;
         }
 
-        return detect_paper_internal(gray, config);
+        // Collinear corners leave the system singular
+        cv::Matx33d H(cv::getPerspectiveTransform(src, dst).ptr<double>());
+        const double det = cv::determinant(H);
+        if (!std::isfinite(det) || std::abs(det) < 1e-12)
+            return -1;
+
+        // (x, y, z, 1) -> (h00 x + h01 y + h02, h10 x + h11 y + h12, z, h20 x + h21 y + h22)
+        const double m[16] = {
+            H(0, 0), H(1, 0), 0, H(2, 0),
+            H(0, 1), H(1, 1), 0, H(2, 1),
+            0, 0, 1, 0,
+            H(0, 2), H(1, 2), 0, H(2, 2)};
+        std::memcpy(out_matrix4, m, sizeof(m));
+        return 1;
     }
 
-    PaperDetectionConfig hg_default_paper_config(void)
+    int hg_set_perf_counters_enabled(int enabled)
     {
-        PaperDetectionConfig config = {};
-        config.canny_threshold1 = 50;
-        config.canny_threshold2 = 150;
-        config.blur_kernel_size = 5;
-        config.min_area_ratio = 0.05f;
-        config.max_area_ratio = 0.95f;
-        config.expected_aspect_ratio = 210.0f / 297.0f; // A4
-        config.aspect_ratio_tolerance = 0.3f;
-        config.paper_width_mm = 210.0f;
-        config.paper_height_mm = 297.0f;
-        config.focal_length = 0; // Skip pose estimation by default
-        config.cx = 0;
-        config.cy = 0;
-        return config;
+        g_perf_counters_enabled.store(enabled != 0, std::memory_order_relaxed);
+#ifdef HG_HAVE_PERF_EVENTS
+        return 1;
+#else
+        return 0;
+#endif
+    }
+
+    int hg_get_last_call_stats(HgCallStats *out_stats)
+    {
+        if (out_stats == nullptr)
+            return -1;
+
+        if (!t_has_last_stats)
+        {
+            *out_stats = {};
+            return 0;
+        }
+
+        *out_stats = t_last_stats;
+        return 1;
+    }
+
+    int hg_set_alloc_tracking_enabled(int enabled)
+    {
+        static std::mutex allocator_mutex;
+        std::lock_guard<std::mutex> lock(allocator_mutex);
+
+        if (g_counting_allocator.base == nullptr)
+            g_counting_allocator.base = cv::Mat::getDefaultAllocator();
+
+        g_alloc_tracking.store(enabled != 0);
+        cv::Mat::setDefaultAllocator(enabled ? &g_counting_allocator : g_counting_allocator.base);
+
+#ifdef HG_ENABLE_ALLOC_TRACKING
+        return 1;
+#else
+        return 0;
+#endif
+    }
+
+    int hg_capture_start(const char *path, size_t max_bytes)
+    {
+        if (path == nullptr)
+            return -1;
+
+        std::lock_guard<std::mutex> lock(g_capture_mutex);
+        if (g_capture_file != nullptr)
+            std::fclose(g_capture_file);
+
+        g_capture_file = std::fopen(path, "wb");
+        if (g_capture_file == nullptr)
+        {
+            g_capture_active.store(false);
+            return -1;
+        }
+
+        const uint32_t version = HG_CAPTURE_VERSION;
+        std::fwrite(HG_CAPTURE_MAGIC, 1, 8, g_capture_file);
+        std::fwrite(&version, sizeof(version), 1, g_capture_file);
+
+        g_capture_bytes = 8 + sizeof(version);
+        g_capture_max_bytes = max_bytes > 0 ? max_bytes : HG_CAPTURE_DEFAULT_MAX_BYTES;
+        g_capture_active.store(true);
+        return 1;
+    }
+
+    void hg_capture_stop(void)
+    {
+        std::lock_guard<std::mutex> lock(g_capture_mutex);
+        g_capture_active.store(false);
+        if (g_capture_file != nullptr)
+        {
+            std::fclose(g_capture_file);
+            g_capture_file = nullptr;
+        }
     }
 
 } // extern "C"
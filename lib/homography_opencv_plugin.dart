@@ -32,6 +32,7 @@
 library;
 
 export 'src/camera_utils.dart';
+export 'src/corner_filter.dart';
 export 'src/corner_smoother.dart';
 export 'src/homography_lib.dart';
 export 'src/homography_result.dart';
@@ -6,6 +6,7 @@ import 'dart:ui' as ui show Image;
 import 'package:camera/camera.dart';
 import 'package:flutter/material.dart';
 
+import 'homography_lib.dart';
 import 'paper_detection_result.dart';
 import 'paper_detector.dart';
 
@@ -150,7 +151,9 @@ class CameraUtils {
   /// [cameraSize] - Размер камеры для масштабирования координат
   ///
   /// Возвращает Matrix4 для применения перспективной трансформации
-  /// Использует упрощенный подход через аффинную трансформацию
+  /// Матрица точная (проективная): углы изображения попадают ровно в углы объекта.
+  /// Если нативная функция недоступна, та же гомография считается на Dart.
+  /// Для вырожденных углов возвращает единичную матрицу
   static Matrix4 computePerspectiveMatrix({
     required Size imageSize,
     required Size canvasSize,
@@ -178,69 +181,56 @@ class CameraUtils {
       Offset(0, imageSize.height), // bottom-left
     ];
 
-    // Используем первые 3 точки для вычисления аффинной трансформации
-    // Аффинная трансформация: x' = a*x + b*y + c, y' = d*x + e*y + f
-    // Нужно решить систему из 6 уравнений для 6 неизвестных (a, b, c, d, e, f)
-
-    // Используем первые 3 точки для решения системы
-    final src0 = srcPoints[0];
-    final src1 = srcPoints[1];
-    final src2 = srcPoints[2];
-
-    final dst0 = dstPoints[0];
-    final dst1 = dstPoints[1];
-    final dst2 = dstPoints[2];
-
-    // Решаем систему уравнений для аффинной трансформации
-    // Используем метод Крамера для решения 2x2 системы для каждой координаты
+    // Гомография 3x3 по 4 парам точек, встроенная в Matrix4 (z не меняется)
+    return HomographyLib.instance.perspectiveMatrix(srcPoints, dstPoints) ??
+        _solvePerspectiveMatrix(srcPoints, dstPoints) ??
+        Matrix4.identity();
+  }
 
-    // Для x-координаты: решаем систему
-    // a*x0 + b*y0 + c = x0'
-    // a*x1 + b*y1 + c = x1'
-    // a*x2 + b*y2 + c = x2'
+  /// Гомография по 4 парам точек на Dart (запасной путь без нативной библиотеки)
+  ///
+  /// Решает систему 8x8 методом Гаусса с выбором ведущего элемента (h22 = 1)
+  /// и встраивает результат в Matrix4 так же, как hg_perspective_matrix4.
+  /// Возвращает null, если углы вырождены
+  static Matrix4? _solvePerspectiveMatrix(List<Offset> src, List<Offset> dst) {
+    // Для каждой пары: x' = (h0 x + h1 y + h2) / (h6 x + h7 y + 1), аналогично y'
+    final a = List.generate(8, (_) => List<double>.filled(9, 0));
+    for (int i = 0; i < 4; i++) {
+      final x = src[i].dx, y = src[i].dy;
+      final u = dst[i].dx, v = dst[i].dy;
+      a[i * 2].setAll(0, [x, y, 1, 0, 0, 0, -u * x, -u * y, u]);
+      a[i * 2 + 1].setAll(0, [0, 0, 0, x, y, 1, -v * x, -v * y, v]);
+    }
 
-    // Упрощаем: используем только 2 точки и вычисляем параметры
-    // Для упрощения используем подход с центром и масштабом
+    for (int col = 0; col < 8; col++) {
+      var pivot = col;
+      for (int row = col + 1; row < 8; row++) {
+        if (a[row][col].abs() > a[pivot][col].abs()) pivot = row;
+      }
+      if (a[pivot][col].abs() < 1e-12) return null;
+
+      final tmp = a[col];
+      a[col] = a[pivot];
+      a[pivot] = tmp;
+
+      for (int row = 0; row < 8; row++) {
+        if (row == col) continue;
+        final f = a[row][col] / a[col][col];
+        if (f == 0) continue;
+        for (int k = col; k < 9; k++) {
+          a[row][k] -= f * a[col][k];
+        }
+      }
+    }
 
-    // Вычисляем центр из всех точек изображения
-    final srcCenter = Offset(imageSize.width / 2, imageSize.height / 2);
+    final h = List<double>.generate(8, (i) => a[i][8] / a[i][i]);
 
-    // Вычисляем центр целевого многоугольника из всех точек
-    final dstCenter = Offset(
-      dstPoints.map((p) => p.dx).reduce((a, b) => a + b) / dstPoints.length,
-      dstPoints.map((p) => p.dy).reduce((a, b) => a + b) / dstPoints.length,
+    // Matrix4 хранится по столбцам
+    return Matrix4(
+      h[0], h[3], 0, h[6],
+      h[1], h[4], 0, h[7],
+      0, 0, 1, 0,
+      h[2], h[5], 0, 1,
     );
-
-    // Вычисляем векторы от центра для определения масштаба и поворота
-    final srcVec1 = src1 - src0;
-    final srcVec2 = src2 - src0;
-    final dstVec1 = dst1 - dst0;
-    final dstVec2 = dst2 - dst0;
-
-    // Вычисляем масштаб по первой стороне
-    final srcLen1 = srcVec1.distance;
-    final dstLen1 = dstVec1.distance;
-    final scale1 = dstLen1 / srcLen1;
-
-    // Вычисляем масштаб по второй стороне
-    final srcLen2 = srcVec2.distance;
-    final dstLen2 = dstVec2.distance;
-    final scale2 = dstLen2 / srcLen2;
-
-    // Используем средний масштаб
-    final avgScale = (scale1 + scale2) / 2;
-
-    // Вычисляем угол поворота по первой стороне
-    final angle = dstVec1.direction - srcVec1.direction;
-
-    // Создаем матрицу трансформации
-    // Порядок: перенос в центр источника, поворот, масштаб, перенос в центр назначения
-    final matrix = Matrix4.identity()
-      ..translate(dstCenter.dx, dstCenter.dy, 0)
-      ..scale(avgScale, avgScale, 1)
-      ..rotateZ(angle)
-      ..translate(-srcCenter.dx, -srcCenter.dy, 0);
-
-    return matrix;
   }
 }
@@ -0,0 +1,388 @@
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:math' as math;
+import 'dart:ui' show Offset, Rect;
+
+import 'package:ffi/ffi.dart';
+import 'package:vector_math/vector_math_64.dart' show Matrix4, Vector3;
+
+import 'homography_result.dart';
+import 'paper_detection_result.dart';
+
+// ============================================================================
+// Native structures
+// ============================================================================
+
+/// Native HgCornerFilterConfig structure
+final class _CornerFilterConfigNative extends Struct {
+  @Float()
+  external double minCutoff;
+
+  @Float()
+  external double beta;
+
+  @Float()
+  external double derivativeCutoff;
+
+  @Float()
+  external double frameRate;
+
+  @Int32()
+  external int maxMissedFrames;
+
+  @Float()
+  external double roiMargin;
+}
+
+/// Native HgCornerFilter session (opaque)
+final class _CornerFilterNative extends Opaque {}
+
+// ============================================================================
+// FFI function signatures
+// ============================================================================
+
+typedef _FilterCreateNative = Pointer<_CornerFilterNative> Function(Pointer<_CornerFilterConfigNative> config);
+
+typedef _FilterCreateDart = _FilterCreateNative;
+
+typedef _FilterResetNative = Void Function(Pointer<_CornerFilterNative> filter);
+
+typedef _FilterResetDart = void Function(Pointer<_CornerFilterNative> filter);
+
+typedef _FilterUpdateNative =
+    Int32 Function(
+      Pointer<_CornerFilterNative> filter,
+      Pointer<Float> corners,
+      Pointer<Double> homography,
+      Double timestamp,
+      Pointer<Float> outCorners,
+    );
+
+typedef _FilterUpdateDart =
+    int Function(
+      Pointer<_CornerFilterNative> filter,
+      Pointer<Float> corners,
+      Pointer<Double> homography,
+      double timestamp,
+      Pointer<Float> outCorners,
+    );
+
+typedef _FilterPredictNative =
+    Int32 Function(
+      Pointer<_CornerFilterNative> filter,
+      Double timestamp,
+      Pointer<Float> outCorners,
+      Pointer<Float> outRoi,
+    );
+
+typedef _FilterPredictDart =
+    int Function(
+      Pointer<_CornerFilterNative> filter,
+      double timestamp,
+      Pointer<Float> outCorners,
+      Pointer<Float> outRoi,
+    );
+
+// ============================================================================
+// Bindings
+// ============================================================================
+
+class _CornerFilterBindings {
+  static _CornerFilterBindings? _instance;
+  _FilterCreateDart? create;
+  _FilterResetDart? reset;
+  _FilterResetDart? destroy;
+  _FilterUpdateDart? update;
+  _FilterPredictDart? predict;
+  NativeFinalizer? finalizer;
+
+  _CornerFilterBindings._() {
+    try {
+      final lib = _loadLibrary();
+      create = lib.lookupFunction<_FilterCreateNative, _FilterCreateDart>('hg_corner_filter_create');
+      reset = lib.lookupFunction<_FilterResetNative, _FilterResetDart>('hg_corner_filter_reset');
+      update = lib.lookupFunction<_FilterUpdateNative, _FilterUpdateDart>('hg_corner_filter_update');
+      predict = lib.lookupFunction<_FilterPredictNative, _FilterPredictDart>('hg_corner_filter_predict');
+      final destroyPtr = lib.lookup<NativeFunction<_FilterResetNative>>('hg_corner_filter_destroy');
+      destroy = destroyPtr.asFunction<_FilterResetDart>();
+      finalizer = NativeFinalizer(destroyPtr.cast());
+      print('[CornerFilter] Corner filter functions found');
+    } catch (e) {
+      print('[CornerFilter] Corner filter functions not found: $e');
+    }
+  }
+
+  static DynamicLibrary _loadLibrary() {
+    if (Platform.isAndroid) {
+      return DynamicLibrary.open('libhomography.so');
+    } else if (Platform.isIOS) {
+      return DynamicLibrary.executable();
+    } else if (Platform.isMacOS) {
+      return DynamicLibrary.process();
+    } else if (Platform.isWindows) {
+      return DynamicLibrary.open('homography.dll');
+    } else if (Platform.isLinux) {
+      return DynamicLibrary.open('libhomography.so');
+    }
+    throw UnsupportedError('Unsupported platform: ${Platform.operatingSystem}');
+  }
+
+  static _CornerFilterBindings get instance {
+    _instance ??= _CornerFilterBindings._();
+    return _instance!;
+  }
+}
+
+// ============================================================================
+// Corner Filter
+// ============================================================================
+
+/// Native One-Euro filter for the corners of a tracked quad
+///
+/// Smooths paper or homography corners between frames (strong smoothing at
+/// rest, little lag while moving) and predicts where the quad will be in the
+/// next frame. The filter state and its buffers live natively, so filtering a
+/// frame does not allocate anything besides the returned result.
+/// Call [dispose] when done; the native session is also freed on garbage collection.
+class CornerFilter implements Finalizable {
+  static final _bufferFinalizer = NativeFinalizer(malloc.nativeFree);
+
+  final _CornerFilterBindings _bindings;
+  Pointer<_CornerFilterNative> _handle = nullptr;
+
+  // Reused between frames: 8 input corners, 8 output corners, 4 ROI values
+  Pointer<Float> _floats = nullptr;
+  Pointer<Double> _homography = nullptr;
+
+  /// Create a corner filter
+  ///
+  /// [minCutoff] - Cutoff frequency at rest (Hz); lower = less jitter, more lag
+  /// [beta] - Cutoff increase per pixel/second of corner speed; higher = less
+  ///   lag while moving
+  /// [derivativeCutoff] - Cutoff frequency of the velocity estimate (Hz)
+  /// [frameRate] - Frame rate assumed when no timestamps are passed
+  /// [maxMissedFrames] - Frames without a detection before the state is dropped
+  /// [roiMargin] - Margin around the predicted quad in [predictRoi], as a
+  ///   fraction of its larger side
+  CornerFilter({
+    double minCutoff = 1.0,
+    double beta = 0.01,
+    double derivativeCutoff = 1.0,
+    double frameRate = 30,
+    int maxMissedFrames = 3,
+    double roiMargin = 0.15,
+  }) : _bindings = _CornerFilterBindings.instance {
+    final create = _bindings.create;
+    if (create == null) {
+      print('[CornerFilter] Native function not available');
+      return;
+    }
+
+    final configPtr = malloc<_CornerFilterConfigNative>();
+    try {
+      configPtr.ref.minCutoff = minCutoff;
+      configPtr.ref.beta = beta;
+      configPtr.ref.derivativeCutoff = derivativeCutoff;
+      configPtr.ref.frameRate = frameRate;
+      configPtr.ref.maxMissedFrames = maxMissedFrames;
+      configPtr.ref.roiMargin = roiMargin;
+
+      _handle = create(configPtr);
+      if (_handle != nullptr) {
+        _bindings.finalizer?.attach(this, _handle.cast(), detach: this);
+        _floats = malloc<Float>(20);
+        _homography = malloc<Double>(9);
+        _bufferFinalizer.attach(this, _floats.cast(), detach: this);
+        _bufferFinalizer.attach(this, _homography.cast(), detach: this);
+      }
+    } finally {
+      malloc.free(configPtr);
+    }
+  }
+
+  /// Whether the native session exists
+  bool get isAvailable => _handle != nullptr;
+
+  /// Filter the corners of the next frame
+  ///
+  /// [corners] - Four corners in a consistent order, or null if nothing was
+  ///   detected in this frame
+  /// [timestamp] - Frame time (optional; frames are assumed to arrive at
+  ///   `frameRate` otherwise)
+  ///
+  /// Returns the filtered corners, or null for a missed frame
+  List<Offset>? filter(List<Offset>? corners, {Duration? timestamp}) {
+    return _update(corners, null, timestamp) ? _readCorners(_floats + 8) : null;
+  }
+
+  /// Smooth a paper detection result
+  ///
+  /// Corners, center, area, perimeter, aspect ratio and homography are
+  /// re-derived from the filtered corners; the camera pose is passed through.
+  /// An invalid result is returned as is and counts as a missed frame.
+  PaperDetectionResult smooth(PaperDetectionResult result, {Duration? timestamp}) {
+    if (!result.isValid || result.corners.length != 4) {
+      _update(null, null, timestamp);
+      return result;
+    }
+
+    if (!_update(result.corners, result.homography, timestamp)) {
+      return result;
+    }
+
+    final corners = _readCorners(_floats + 8);
+    final width = ((corners[1] - corners[0]).distance + (corners[2] - corners[3]).distance) / 2;
+    final height = ((corners[3] - corners[0]).distance + (corners[2] - corners[1]).distance) / 2;
+
+    return PaperDetectionResult(
+      corners: corners,
+      center: _centerOf(corners),
+      homography: _readHomography(),
+      rotationVector: result.rotationVector,
+      translationVector: result.translationVector,
+      area: _areaOf(corners),
+      perimeter: width * 2 + height * 2,
+      aspectRatio: math.max(width, height) > 0 ? math.min(width, height) / math.max(width, height) : 0,
+      isValid: true,
+    );
+  }
+
+  /// Smooth a homography result
+  ///
+  /// Corners, center, rotation, scale and matrix are re-derived from the
+  /// filtered corners. A null result counts as a missed frame.
+  HomographyMatrixResult? smoothHomography(HomographyMatrixResult? result, {Duration? timestamp}) {
+    if (result == null || result.corners.length != 4) {
+      _update(null, null, timestamp);
+      return result;
+    }
+
+    // Anchor size, recovered from where the homography maps the corners from
+    final inverse = Matrix4.copy(result.matrix)..invert();
+    final a0 = inverse.perspectiveTransform(Vector3(result.corners[0].dx, result.corners[0].dy, 0));
+    final a1 = inverse.perspectiveTransform(Vector3(result.corners[1].dx, result.corners[1].dy, 0));
+    final a3 = inverse.perspectiveTransform(Vector3(result.corners[3].dx, result.corners[3].dy, 0));
+    final anchorWidth = (a1 - a0).length;
+    final anchorHeight = (a3 - a0).length;
+
+    if (!_update(result.corners, result.matrix, timestamp)) {
+      return result;
+    }
+
+    final corners = _readCorners(_floats + 8);
+    final top = corners[1] - corners[0];
+    final left = corners[3] - corners[0];
+
+    return HomographyMatrixResult(
+      matrix: _readHomography(),
+      corners: corners,
+      center: _centerOf(corners),
+      rotation: math.atan2(top.dy, top.dx),
+      scale: anchorWidth > 0 && anchorHeight > 0
+          ? (top.distance / anchorWidth + left.distance / anchorHeight) / 2
+          : result.scale,
+      numInliers: result.numInliers,
+      rotationVector: result.rotationVector,
+      translationVector: result.translationVector,
+    );
+  }
+
+  /// Predicted corners at [timestamp] (or one frame after the last update)
+  ///
+  /// Returns null if nothing is being tracked
+  List<Offset>? predictCorners({Duration? timestamp}) {
+    final func = _bindings.predict;
+    if (func == null || _handle == nullptr) return null;
+
+    if (func(_handle, _seconds(timestamp), _floats + 8, nullptr) != 1) return null;
+    return _readCorners(_floats + 8);
+  }
+
+  /// Region to search in the next frame: the predicted quad's bounding box
+  /// expanded by `roiMargin` (not clipped to the image)
+  ///
+  /// Returns null if nothing is being tracked
+  Rect? predictRoi({Duration? timestamp}) {
+    final func = _bindings.predict;
+    if (func == null || _handle == nullptr) return null;
+
+    final roi = _floats + 16;
+    if (func(_handle, _seconds(timestamp), nullptr, roi) != 1) return null;
+    return Rect.fromLTWH(roi[0], roi[1], roi[2], roi[3]);
+  }
+
+  /// Drop the filter state; the next detection is passed through unchanged
+  void reset() {
+    if (_handle != nullptr) {
+      _bindings.reset?.call(_handle);
+    }
+  }
+
+  /// Free the native session
+  void dispose() {
+    if (_handle == nullptr) return;
+    _bindings.finalizer?.detach(this);
+    _bindings.destroy?.call(_handle);
+    _handle = nullptr;
+    _bufferFinalizer.detach(this);
+    malloc.free(_floats);
+    malloc.free(_homography);
+    _floats = nullptr;
+    _homography = nullptr;
+  }
+
+  bool _update(List<Offset>? corners, Matrix4? homography, Duration? timestamp) {
+    final func = _bindings.update;
+    if (func == null || _handle == nullptr) return false;
+
+    if (corners == null) {
+      return func(_handle, nullptr, nullptr, _seconds(timestamp), _floats + 8) == 1;
+    }
+
+    for (int i = 0; i < 4; i++) {
+      _floats[i * 2] = corners[i].dx;
+      _floats[i * 2 + 1] = corners[i].dy;
+    }
+
+    if (homography != null) {
+      // Matrix4 holds the 3x3 homography in column-major order, z row/column skipped
+      final m = homography.storage;
+      const indices = [0, 4, 12, 1, 5, 13, 3, 7, 15];
+      for (int i = 0; i < 9; i++) {
+        _homography[i] = m[indices[i]];
+      }
+    }
+
+    return func(_handle, _floats, homography != null ? _homography : nullptr, _seconds(timestamp), _floats + 8) == 1;
+  }
+
+  Matrix4 _readHomography() {
+    final h = _homography;
+    return Matrix4(h[0], h[3], 0, h[6], h[1], h[4], 0, h[7], 0, 0, 1, 0, h[2], h[5], 0, h[8]);
+  }
+
+  static List<Offset> _readCorners(Pointer<Float> data) {
+    return List.generate(4, (i) => Offset(data[i * 2], data[i * 2 + 1]));
+  }
+
+  static Offset _centerOf(List<Offset> corners) {
+    return Offset(
+      (corners[0].dx + corners[1].dx + corners[2].dx + corners[3].dx) / 4,
+      (corners[0].dy + corners[1].dy + corners[2].dy + corners[3].dy) / 4,
+    );
+  }
+
+  static double _areaOf(List<Offset> corners) {
+    double twiceArea = 0;
+    for (int i = 0; i < 4; i++) {
+      final a = corners[i];
+      final b = corners[(i + 1) % 4];
+      twiceArea += a.dx * b.dy - b.dx * a.dy;
+    }
+    return twiceArea.abs() / 2;
+  }
+
+  static double _seconds(Duration? timestamp) {
+    return timestamp == null ? 0 : timestamp.inMicroseconds / Duration.microsecondsPerSecond;
+  }
+}
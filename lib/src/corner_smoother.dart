@@ -6,6 +6,9 @@ import 'paper_detection_result.dart';
 ///
 /// Использует пороговую фильтрацию и экспоненциальное сглаживание
 /// для уменьшения дрожания координат при небольших смещениях
+///
+/// Работает без нативной библиотеки; если в ней есть hg_corner_filter_*
+/// (`CornerFilter.isAvailable`), лучше использовать `CornerFilter`
 class CornerSmoother {
   /// Порог изменения в пикселях (изменения меньше этого значения игнорируются)
   final double threshold;
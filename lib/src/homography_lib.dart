@@ -1,10 +1,11 @@
 import 'dart:ffi' hide Size;
 import 'dart:io';
 import 'dart:math' as math;
+import 'dart:typed_data';
 import 'dart:ui' show Offset, Size;
 
 import 'package:ffi/ffi.dart';
-import 'package:vector_math/vector_math_64.dart' show Matrix4;
+import 'package:vector_math/vector_math_64.dart' show Matrix4, Vector3;
 
 import 'homography_result.dart';
 
@@ -35,6 +36,48 @@ final class _HomographyResultNative extends Struct {
   external int status;
 }
 
+/// Native HgCameraIntrinsics structure
+final class _CameraIntrinsicsNative extends Struct {
+  @Float()
+  external double focalLength;
+
+  @Float()
+  external double cx;
+
+  @Float()
+  external double cy;
+
+  @Float()
+  external double anchorWidth;
+
+  @Float()
+  external double distK1;
+
+  @Float()
+  external double distK2;
+
+  @Float()
+  external double distP1;
+
+  @Float()
+  external double distP2;
+
+  @Float()
+  external double distK3;
+}
+
+/// Native HgPose structure (out-parameter of the *_pose functions)
+final class _PoseNative extends Struct {
+  @Int32()
+  external int hasPose;
+
+  @Array(3)
+  external Array<Double> rvec;
+
+  @Array(3)
+  external Array<Double> tvec;
+}
+
 /// FFI function signature for find_homography_from_points
 typedef _FindHomographyFromPointsNative = _HomographyResultNative Function(
   Pointer<Float> pts0X,
@@ -56,16 +99,75 @@ typedef _FindHomographyFromPointsDart = _HomographyResultNative Function(
   int anchorHeight,
 );
 
+/// FFI function signature for find_homography_from_points_pose
+typedef _FindHomographyFromPointsPoseNative = _HomographyResultNative Function(
+  Pointer<Float> pts0X,
+  Pointer<Float> pts0Y,
+  Pointer<Float> pts1X,
+  Pointer<Float> pts1Y,
+  Int32 numPoints,
+  Int32 anchorWidth,
+  Int32 anchorHeight,
+  Pointer<_CameraIntrinsicsNative> intrinsics,
+  Pointer<_PoseNative> outPose,
+);
+
+typedef _FindHomographyFromPointsPoseDart = _HomographyResultNative Function(
+  Pointer<Float> pts0X,
+  Pointer<Float> pts0Y,
+  Pointer<Float> pts1X,
+  Pointer<Float> pts1Y,
+  int numPoints,
+  int anchorWidth,
+  int anchorHeight,
+  Pointer<_CameraIntrinsicsNative> intrinsics,
+  Pointer<_PoseNative> outPose,
+);
+
 /// FFI function signature for version
 typedef _VersionNative = Pointer<Utf8> Function();
 typedef _VersionDart = Pointer<Utf8> Function();
 
+/// FFI function signature for hg_transform_points / hg_transform_points_inverse
+typedef _TransformPointsNative = Int32 Function(
+  Pointer<Double> homography,
+  Pointer<Float> inXy,
+  Pointer<Float> outXy,
+  Int32 n,
+  Int32 layout,
+);
+
+typedef _TransformPointsDart = int Function(
+  Pointer<Double> homography,
+  Pointer<Float> inXy,
+  Pointer<Float> outXy,
+  int n,
+  int layout,
+);
+
+/// FFI function signature for hg_perspective_matrix4
+typedef _PerspectiveMatrix4Native = Int32 Function(
+  Pointer<Float> srcCorners,
+  Pointer<Float> dstCorners,
+  Pointer<Double> outMatrix4,
+);
+
+typedef _PerspectiveMatrix4Dart = int Function(
+  Pointer<Float> srcCorners,
+  Pointer<Float> dstCorners,
+  Pointer<Double> outMatrix4,
+);
+
 /// Singleton class for homography library bindings
 class HomographyLib {
   static HomographyLib? _instance;
   DynamicLibrary? _lib;
   _FindHomographyFromPointsDart? _findHomographyFromPoints;
+  _FindHomographyFromPointsPoseDart? _findHomographyFromPointsPose;
   _VersionDart? _version;
+  _TransformPointsDart? _transformPoints;
+  _TransformPointsDart? _transformPointsInverse;
+  _PerspectiveMatrix4Dart? _perspectiveMatrix4;
   String? _loadError;
 
   HomographyLib._() {
@@ -91,12 +193,36 @@ class HomographyLib {
       _loadError = 'Function hg_find_homography_from_points not found: $e';
       print('[HomographyLib] $_loadError');
     }
+    try {
+      _findHomographyFromPointsPose =
+          lib.lookupFunction<_FindHomographyFromPointsPoseNative, _FindHomographyFromPointsPoseDart>(
+        'hg_find_homography_from_points_pose',
+      );
+      print('[HomographyLib] Function hg_find_homography_from_points_pose found');
+    } catch (e) {
+      print('[HomographyLib] Function hg_find_homography_from_points_pose not found: $e');
+    }
     try {
       _version = lib.lookupFunction<_VersionNative, _VersionDart>('hg_lib_version');
       print('[HomographyLib] Function hg_lib_version found, version: ${_version?.call().toDartString()}');
     } catch (e) {
       print('[HomographyLib] Function hg_lib_version not found: $e');
     }
+    try {
+      _transformPoints = lib.lookupFunction<_TransformPointsNative, _TransformPointsDart>('hg_transform_points');
+      _transformPointsInverse =
+          lib.lookupFunction<_TransformPointsNative, _TransformPointsDart>('hg_transform_points_inverse');
+      print('[HomographyLib] Functions hg_transform_points* found');
+    } catch (e) {
+      print('[HomographyLib] Functions hg_transform_points* not found: $e');
+    }
+    try {
+      _perspectiveMatrix4 =
+          lib.lookupFunction<_PerspectiveMatrix4Native, _PerspectiveMatrix4Dart>('hg_perspective_matrix4');
+      print('[HomographyLib] Function hg_perspective_matrix4 found');
+    } catch (e) {
+      print('[HomographyLib] Function hg_perspective_matrix4 not found: $e');
+    }
   }
 
   /// Get load error if any
@@ -129,14 +255,88 @@ class HomographyLib {
   /// Check if the native library is available
   bool get isAvailable => _findHomographyFromPoints != null;
 
-  /// Find homography from matched point pairs
-  _HomographyResultNative? _findHomographyFromPointsRaw({
+  /// Map packed points through a homography natively (NEON/AVX2)
+  ///
+  /// [homography] - 3x3 homography embedded in a Matrix4, as in
+  ///   [HomographyMatrixResult.matrix]
+  /// [points] - Point coordinates, 2 floats per point in [layout]
+  /// [inverse] - Map through the inverse homography instead
+  ///
+  /// Returns the mapped coordinates in the same layout, or null if the library
+  /// is unavailable, [points] has odd length, or the homography is singular.
+  Float32List? transformPoints(
+    Matrix4 homography,
+    Float32List points, {
+    PointLayout layout = PointLayout.interleaved,
+    bool inverse = false,
+  }) {
+    final func = inverse ? _transformPointsInverse : _transformPoints;
+    if (func == null || points.length.isOdd) return null;
+    if (points.isEmpty) return Float32List(0);
+
+    final hPtr = malloc<Double>(9);
+    final xyPtr = malloc<Float>(points.length);
+
+    try {
+      // Row-major 3x3 from the (x, y, w) rows/columns of the Matrix4 embedding
+      const rows = [0, 1, 3];
+      for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+          hPtr[r * 3 + c] = homography.entry(rows[r], rows[c]);
+        }
+      }
+      xyPtr.asTypedList(points.length).setAll(0, points);
+
+      final status = func(hPtr, xyPtr, xyPtr, points.length ~/ 2, layout.index);
+      if (status != 1) return null;
+
+      return Float32List.fromList(xyPtr.asTypedList(points.length));
+    } finally {
+      malloc.free(hPtr);
+      malloc.free(xyPtr);
+    }
+  }
+
+  /// Exact projective Matrix4 mapping quad [src] onto quad [dst]
+  ///
+  /// Both lists hold 4 corners in the same order. Returns null if the library
+  /// is unavailable or either quad is degenerate.
+  Matrix4? perspectiveMatrix(List<Offset> src, List<Offset> dst) {
+    final func = _perspectiveMatrix4;
+    if (func == null || src.length != 4 || dst.length != 4) return null;
+
+    final srcPtr = malloc<Float>(8);
+    final dstPtr = malloc<Float>(8);
+    final outPtr = malloc<Double>(16);
+
+    try {
+      for (int i = 0; i < 4; i++) {
+        srcPtr[i * 2] = src[i].dx;
+        srcPtr[i * 2 + 1] = src[i].dy;
+        dstPtr[i * 2] = dst[i].dx;
+        dstPtr[i * 2 + 1] = dst[i].dy;
+      }
+
+      if (func(srcPtr, dstPtr, outPtr) != 1) return null;
+
+      return Matrix4.fromList(outPtr.asTypedList(16));
+    } finally {
+      malloc.free(srcPtr);
+      malloc.free(dstPtr);
+      malloc.free(outPtr);
+    }
+  }
+
+  /// Find homography (and the pose, when [intrinsics] are given) from matched point pairs
+  ({_HomographyResultNative result, Vector3? rotationVector, Vector3? translationVector})? _findHomographyFromPointsRaw({
     required List<MatchedPoint> matchedPoints,
     required int anchorWidth,
     required int anchorHeight,
+    CameraIntrinsics? intrinsics,
   }) {
     final func = _findHomographyFromPoints;
     if (func == null) return null;
+    final poseFunc = intrinsics != null ? _findHomographyFromPointsPose : null;
 
     final numPoints = matchedPoints.length;
     if (numPoints < 4) return null;
@@ -145,6 +345,8 @@ class HomographyLib {
     final pts0Y = malloc<Float>(numPoints);
     final pts1X = malloc<Float>(numPoints);
     final pts1Y = malloc<Float>(numPoints);
+    Pointer<_CameraIntrinsicsNative>? intrinsicsPtr;
+    Pointer<_PoseNative>? posePtr;
 
     try {
       for (int i = 0; i < numPoints; i++) {
@@ -155,7 +357,30 @@ class HomographyLib {
         pts1Y[i] = p.y1;
       }
 
-      return func(
+      if (poseFunc != null && intrinsics != null) {
+        intrinsicsPtr = malloc<_CameraIntrinsicsNative>();
+        intrinsicsPtr.ref
+          ..focalLength = intrinsics.focalLength
+          ..cx = intrinsics.cx
+          ..cy = intrinsics.cy
+          ..anchorWidth = intrinsics.anchorWidth
+          ..distK1 = intrinsics.distK1
+          ..distK2 = intrinsics.distK2
+          ..distP1 = intrinsics.distP1
+          ..distP2 = intrinsics.distP2
+          ..distK3 = intrinsics.distK3;
+        posePtr = malloc<_PoseNative>();
+        final result = poseFunc(pts0X, pts0Y, pts1X, pts1Y, numPoints, anchorWidth, anchorHeight, intrinsicsPtr, posePtr);
+        final pose = posePtr.ref;
+        final hasPose = result.status == 1 && pose.hasPose == 1;
+        return (
+          result: result,
+          rotationVector: hasPose ? Vector3(pose.rvec[0], pose.rvec[1], pose.rvec[2]) : null,
+          translationVector: hasPose ? Vector3(pose.tvec[0], pose.tvec[1], pose.tvec[2]) : null,
+        );
+      }
+
+      final result = func(
         pts0X,
         pts0Y,
         pts1X,
@@ -164,11 +389,18 @@ class HomographyLib {
         anchorWidth,
         anchorHeight,
       );
+      return (result: result, rotationVector: null, translationVector: null);
     } finally {
       malloc.free(pts0X);
       malloc.free(pts0Y);
       malloc.free(pts1X);
       malloc.free(pts1Y);
+      if (intrinsicsPtr != null) {
+        malloc.free(intrinsicsPtr);
+      }
+      if (posePtr != null) {
+        malloc.free(posePtr);
+      }
     }
   }
 }
@@ -180,10 +412,13 @@ class HomographyLib {
 ///
 /// [matchedPoints] - List of matched point pairs (at least 4 required)
 /// [anchorSize] - Size of the anchor image in pixels
+/// [intrinsics] - Camera intrinsics; when given, the camera pose is solved
+///   natively from the RANSAC inliers (IPPE)
 HomographyMatrixResult? calculateHomographyFromMatchedPoints(
   List<MatchedPoint> matchedPoints,
-  Size anchorSize,
-) {
+  Size anchorSize, {
+  CameraIntrinsics? intrinsics,
+}) {
   if (matchedPoints.length < 4) return null;
 
   final lib = HomographyLib.instance;
@@ -197,13 +432,15 @@ HomographyMatrixResult? calculateHomographyFromMatchedPoints(
   
   print('[HomographyLib] Using native OpenCV homography');
 
-  final result = lib._findHomographyFromPointsRaw(
+  final raw = lib._findHomographyFromPointsRaw(
     matchedPoints: matchedPoints,
     anchorWidth: anchorSize.width.toInt(),
     anchorHeight: anchorSize.height.toInt(),
+    intrinsics: intrinsics,
   );
 
-  if (result == null || result.status != 1) return null;
+  if (raw == null || raw.result.status != 1) return null;
+  final result = raw.result;
 
   final matrix = _homographyResultToMatrix4(result);
   if (matrix == null) return null;
@@ -215,6 +452,8 @@ HomographyMatrixResult? calculateHomographyFromMatchedPoints(
     rotation: result.rotation,
     scale: result.scale,
     numInliers: result.numMatches,
+    rotationVector: raw.rotationVector,
+    translationVector: raw.translationVector,
   );
 }
 
@@ -1,6 +1,6 @@
 import 'dart:ui' show Offset;
 
-import 'package:vector_math/vector_math_64.dart' show Matrix4;
+import 'package:vector_math/vector_math_64.dart' show Matrix4, Vector3;
 
 /// Result of homography computation
 class HomographyMatrixResult {
@@ -22,6 +22,14 @@ class HomographyMatrixResult {
   /// Number of inliers (good points after RANSAC)
   final int numInliers;
 
+  /// Camera pose of the anchor plane: rotation vector (Rodrigues)
+  /// (null unless [CameraIntrinsics] were given)
+  final Vector3? rotationVector;
+
+  /// Camera pose of the anchor plane: translation vector, in the unit of
+  /// [CameraIntrinsics.anchorWidth]
+  final Vector3? translationVector;
+
   HomographyMatrixResult({
     required this.matrix,
     required this.corners,
@@ -29,14 +37,62 @@ class HomographyMatrixResult {
     required this.rotation,
     required this.scale,
     required this.numInliers,
+    this.rotationVector,
+    this.translationVector,
   });
 
+  /// Whether camera pose is available
+  bool get hasPose => rotationVector != null && translationVector != null;
+
   @override
   String toString() {
     return 'HomographyMatrixResult(inliers: $numInliers, rotation: $rotation, scale: $scale, center: $center)';
   }
 }
 
+/// Pinhole camera intrinsics for pose estimation of a planar anchor
+class CameraIntrinsics {
+  /// Focal length in scene pixels
+  final double focalLength;
+
+  /// Principal point in scene pixels
+  final double cx;
+  final double cy;
+
+  /// Physical width of the anchor (translation is returned in this unit;
+  /// 0 = anchor pixels)
+  final double anchorWidth;
+
+  /// Lens distortion (OpenCV k1, k2, p1, p2, k3; all 0 = ideal lens)
+  /// Only the inlier keypoints are undistorted, never the image.
+  final double distK1;
+  final double distK2;
+  final double distP1;
+  final double distP2;
+  final double distK3;
+
+  const CameraIntrinsics({
+    required this.focalLength,
+    required this.cx,
+    required this.cy,
+    this.anchorWidth = 0,
+    this.distK1 = 0,
+    this.distK2 = 0,
+    this.distP1 = 0,
+    this.distP2 = 0,
+    this.distK3 = 0,
+  });
+}
+
+/// Memory layout of a packed point array
+enum PointLayout {
+  /// x0, y0, x1, y1, ...
+  interleaved,
+
+  /// x0..xn-1 followed by y0..yn-1
+  soa,
+}
+
 /// A pair of matched points between two images
 class MatchedPoint {
   /// X coordinate on anchor image
@@ -86,6 +86,53 @@ class PaperDetectionResult {
   }
 }
 
+/// Edge extraction method used by paper detection
+enum EdgeMethod {
+  /// Gaussian blur, Canny and dilation as separate OpenCV passes
+  opencv,
+
+  /// Single fused SIMD pass writing one edge map (less memory traffic)
+  fused,
+
+  /// Fused pass split into strips processed on all cores
+  parallel,
+}
+
+/// Quad extraction method used by paper detection
+enum QuadMethod {
+  /// External contours approximated to quadrilaterals
+  contours,
+
+  /// Line segments merged into lines, quads from line intersections
+  /// (faster on cluttered scenes, tolerates partially occluded borders)
+  segments,
+
+  /// Same as [contours], but small blobs are rejected by bounding box before
+  /// being traced (faster on textured backgrounds)
+  traced,
+}
+
+/// Camera pose estimation method used by paper detection
+enum PoseMethod {
+  /// Iterative solvePnP (Levenberg-Marquardt)
+  iterative,
+
+  /// Closed-form planar solvePnP (IPPE), several times cheaper
+  ippe,
+
+  /// Decomposition of the paper homography with the intrinsics (cheapest)
+  homography,
+}
+
+/// Image format of an encoded rectified page
+enum RectifiedImageFormat {
+  /// Lossy JPEG (no alpha)
+  jpeg,
+
+  /// Lossless PNG (1 bit per pixel when binarized)
+  png,
+}
+
 /// Configuration for paper detection
 class PaperDetectionConfig {
   /// Canny edge detection lower threshold
@@ -124,6 +171,45 @@ class PaperDetectionConfig {
   /// Camera principal point Y
   final double cy;
 
+  /// Band height in rows for streaming detection of very large images (0 = disabled)
+  final int streamBandRows;
+
+  /// Downscale factor of the streamed edge map used for contour extraction (1, 2 or 4)
+  final int streamEdgeDownscale;
+
+  /// Longer side of the downscaled copy used for coarse-to-fine detection (0 = disabled, e.g. 480)
+  final int coarseMaxDimension;
+
+  /// Edge extraction method
+  final EdgeMethod edgeMethod;
+
+  /// Quad extraction method
+  final QuadMethod quadMethod;
+
+  /// Number of Canny threshold pairs tried concurrently (1 = single pair, at most 8)
+  final int cannyHypotheses;
+
+  /// Scale applied to both Canny thresholds per extra hypothesis
+  final double cannyHypothesisScale;
+
+  /// Pose estimation method (used when focalLength > 0)
+  final PoseMethod poseMethod;
+
+  /// Lens radial distortion k1 (OpenCV model, used when focalLength > 0)
+  final double distK1;
+
+  /// Lens radial distortion k2
+  final double distK2;
+
+  /// Lens tangential distortion p1
+  final double distP1;
+
+  /// Lens tangential distortion p2
+  final double distP2;
+
+  /// Lens radial distortion k3
+  final double distK3;
+
   const PaperDetectionConfig({
     this.cannyThreshold1 = 50,
     this.cannyThreshold2 = 150,
@@ -137,6 +223,19 @@ class PaperDetectionConfig {
     this.focalLength = 0, // Skip pose by default
     this.cx = 0,
     this.cy = 0,
+    this.streamBandRows = 0, // Whole-frame processing
+    this.streamEdgeDownscale = 2,
+    this.coarseMaxDimension = 0, // Full resolution contours
+    this.edgeMethod = EdgeMethod.opencv,
+    this.quadMethod = QuadMethod.contours,
+    this.cannyHypotheses = 1, // e.g. 3 for low-contrast paper
+    this.cannyHypothesisScale = 0.5,
+    this.poseMethod = PoseMethod.iterative,
+    this.distK1 = 0, // Ideal lens
+    this.distK2 = 0,
+    this.distP1 = 0,
+    this.distP2 = 0,
+    this.distK3 = 0,
   });
 
   // ============================================================================
@@ -291,20 +390,7 @@ class PaperDetectionConfig {
 
   /// Create config with camera intrinsics for pose estimation
   PaperDetectionConfig withCameraIntrinsics({required double focalLength, double? cx, double? cy}) {
-    return PaperDetectionConfig(
-      cannyThreshold1: cannyThreshold1,
-      cannyThreshold2: cannyThreshold2,
-      blurKernelSize: blurKernelSize,
-      minAreaRatio: minAreaRatio,
-      maxAreaRatio: maxAreaRatio,
-      expectedAspectRatio: expectedAspectRatio,
-      aspectRatioTolerance: aspectRatioTolerance,
-      paperWidthMm: paperWidthMm,
-      paperHeightMm: paperHeightMm,
-      focalLength: focalLength,
-      cx: cx ?? this.cx,
-      cy: cy ?? this.cy,
-    );
+    return copyWith(focalLength: focalLength, cx: cx, cy: cy);
   }
 
   /// Copy with modified parameters
@@ -321,6 +407,19 @@ class PaperDetectionConfig {
     double? focalLength,
     double? cx,
     double? cy,
+    int? streamBandRows,
+    int? streamEdgeDownscale,
+    int? coarseMaxDimension,
+    EdgeMethod? edgeMethod,
+    QuadMethod? quadMethod,
+    int? cannyHypotheses,
+    double? cannyHypothesisScale,
+    PoseMethod? poseMethod,
+    double? distK1,
+    double? distK2,
+    double? distP1,
+    double? distP2,
+    double? distK3,
   }) {
     return PaperDetectionConfig(
       cannyThreshold1: cannyThreshold1 ?? this.cannyThreshold1,
@@ -335,6 +434,19 @@ class PaperDetectionConfig {
       focalLength: focalLength ?? this.focalLength,
       cx: cx ?? this.cx,
       cy: cy ?? this.cy,
+      streamBandRows: streamBandRows ?? this.streamBandRows,
+      streamEdgeDownscale: streamEdgeDownscale ?? this.streamEdgeDownscale,
+      coarseMaxDimension: coarseMaxDimension ?? this.coarseMaxDimension,
+      edgeMethod: edgeMethod ?? this.edgeMethod,
+      quadMethod: quadMethod ?? this.quadMethod,
+      cannyHypotheses: cannyHypotheses ?? this.cannyHypotheses,
+      cannyHypothesisScale: cannyHypothesisScale ?? this.cannyHypothesisScale,
+      poseMethod: poseMethod ?? this.poseMethod,
+      distK1: distK1 ?? this.distK1,
+      distK2: distK2 ?? this.distK2,
+      distP1: distP1 ?? this.distP1,
+      distP2: distP2 ?? this.distP2,
+      distK3: distK3 ?? this.distK3,
     );
   }
 }
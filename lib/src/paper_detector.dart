@@ -82,8 +82,142 @@ final class _PaperDetectionConfigNative extends Struct {
 
   @Float()
   external double cy;
+
+  @Int32()
+  external int streamBandRows;
+
+  @Int32()
+  external int streamEdgeDownscale;
+
+  @Int32()
+  external int coarseMaxDimension;
+
+  @Int32()
+  external int edgeMethod;
+
+  @Int32()
+  external int quadMethod;
+
+  @Int32()
+  external int cannyHypotheses;
+
+  @Float()
+  external double cannyHypothesisScale;
+
+  @Int32()
+  external int poseMethod;
+
+  @Float()
+  external double distK1;
+
+  @Float()
+  external double distK2;
+
+  @Float()
+  external double distP1;
+
+  @Float()
+  external double distP2;
+
+  @Float()
+  external double distK3;
+}
+
+/// Native HgDecodeOptions structure
+final class _DecodeOptionsNative extends Struct {
+  @Int32()
+  external int maxDimension;
+
+  @Int32()
+  external int deferOrientation;
+}
+
+/// Native HgTrackerConfig structure
+final class _TrackerConfigNative extends Struct {
+  @Float()
+  external double roiMargin;
+
+  @Int32()
+  external int fullScanInterval;
+
+  @Int32()
+  external int snapTracking;
+
+  @Float()
+  external double snapSearchRadius;
+
+  @Float()
+  external double snapMinSupport;
+
+  @Float()
+  external double snapMaxResidual;
+
+  @Int32()
+  external int filterCorners;
+
+  @Float()
+  external double filterMinCutoff;
+
+  @Float()
+  external double filterBeta;
+
+  @Float()
+  external double filterFrameRate;
+
+  @Int32()
+  external int seedPose;
+}
+
+/// Native HgPaperTracker session (opaque)
+final class _PaperTrackerNative extends Opaque {}
+
+/// Native HgEncodeOptions structure
+final class _EncodeOptionsNative extends Struct {
+  @Int32()
+  external int format;
+
+  @Int32()
+  external int quality;
+
+  @Int32()
+  external int maxDimension;
+
+  @Int32()
+  external int grayscale;
+
+  @Int32()
+  external int binarize;
+}
+
+/// Native HgEncodedImage structure
+final class _EncodedImageNative extends Struct {
+  external Pointer<Uint8> data;
+
+  @Size()
+  external int size;
+
+  @Int32()
+  external int width;
+
+  @Int32()
+  external int height;
+
+  @Int32()
+  external int status;
 }
 
+/// Native HgImageBuffer (opaque)
+final class _ImageBufferNative extends Opaque {}
+
+/// Native HgRectifierConfig structure
+final class _RectifierConfigNative extends Struct {
+  @Float()
+  external double reuseTolerance;
+}
+
+/// Native HgRectifier session (opaque)
+final class _RectifierNative extends Opaque {}
+
 // ============================================================================
 // FFI function signatures
 // ============================================================================
@@ -120,6 +254,191 @@ typedef _DetectPaperEncodedDart =
       Pointer<_PaperDetectionConfigNative> config,
     );
 
+typedef _DetectPaperEncodedExNative =
+    _PaperDetectionResultNative Function(
+      Pointer<Uint8> imageBytes,
+      Size imageSize,
+      Pointer<_PaperDetectionConfigNative> config,
+      Pointer<_DecodeOptionsNative> options,
+    );
+
+typedef _DetectPaperEncodedExDart =
+    _PaperDetectionResultNative Function(
+      Pointer<Uint8> imageBytes,
+      int imageSize,
+      Pointer<_PaperDetectionConfigNative> config,
+      Pointer<_DecodeOptionsNative> options,
+    );
+
+typedef _DetectPaperFileNative =
+    _PaperDetectionResultNative Function(
+      Pointer<Utf8> imagePath,
+      Pointer<_PaperDetectionConfigNative> config,
+      Pointer<_DecodeOptionsNative> options,
+    );
+
+typedef _DetectPaperFileDart = _DetectPaperFileNative;
+
+typedef _DetectPapersNative =
+    Int32 Function(
+      Pointer<Uint8> imageData,
+      Int32 imageWidth,
+      Int32 imageHeight,
+      Int32 imageChannels,
+      Pointer<_PaperDetectionConfigNative> config,
+      Pointer<_PaperDetectionResultNative> results,
+      Int32 maxResults,
+    );
+
+typedef _DetectPapersDart =
+    int Function(
+      Pointer<Uint8> imageData,
+      int imageWidth,
+      int imageHeight,
+      int imageChannels,
+      Pointer<_PaperDetectionConfigNative> config,
+      Pointer<_PaperDetectionResultNative> results,
+      int maxResults,
+    );
+
+typedef _TrackerCreateNative =
+    Pointer<_PaperTrackerNative> Function(
+      Pointer<_PaperDetectionConfigNative> config,
+      Pointer<_TrackerConfigNative> trackerConfig,
+    );
+
+typedef _TrackerCreateDart = _TrackerCreateNative;
+
+typedef _TrackerResetNative = Void Function(Pointer<_PaperTrackerNative> tracker);
+
+typedef _TrackerResetDart = void Function(Pointer<_PaperTrackerNative> tracker);
+
+typedef _TrackerUpdateNative =
+    _PaperDetectionResultNative Function(
+      Pointer<_PaperTrackerNative> tracker,
+      Pointer<Uint8> imageData,
+      Int32 imageWidth,
+      Int32 imageHeight,
+      Int32 imageChannels,
+    );
+
+typedef _TrackerUpdateDart =
+    _PaperDetectionResultNative Function(
+      Pointer<_PaperTrackerNative> tracker,
+      Pointer<Uint8> imageData,
+      int imageWidth,
+      int imageHeight,
+      int imageChannels,
+    );
+
+typedef _TrackerUpdateAtNative =
+    _PaperDetectionResultNative Function(
+      Pointer<_PaperTrackerNative> tracker,
+      Pointer<Uint8> imageData,
+      Int32 imageWidth,
+      Int32 imageHeight,
+      Int32 imageChannels,
+      Double timestamp,
+    );
+
+typedef _TrackerUpdateAtDart =
+    _PaperDetectionResultNative Function(
+      Pointer<_PaperTrackerNative> tracker,
+      Pointer<Uint8> imageData,
+      int imageWidth,
+      int imageHeight,
+      int imageChannels,
+      double timestamp,
+    );
+
+typedef _RectifyPaperNative =
+    Int32 Function(
+      Pointer<Uint8> imageData,
+      Int32 imageWidth,
+      Int32 imageHeight,
+      Int32 imageChannels,
+      Pointer<Float> corners,
+      Int32 outWidth,
+      Int32 outHeight,
+      Pointer<Uint8> outData,
+    );
+
+typedef _RectifyPaperDart =
+    int Function(
+      Pointer<Uint8> imageData,
+      int imageWidth,
+      int imageHeight,
+      int imageChannels,
+      Pointer<Float> corners,
+      int outWidth,
+      int outHeight,
+      Pointer<Uint8> outData,
+    );
+
+typedef _RectifyPaperEncodedNative =
+    _EncodedImageNative Function(
+      Pointer<_ImageBufferNative> buffer,
+      Pointer<Uint8> imageData,
+      Int32 imageWidth,
+      Int32 imageHeight,
+      Int32 imageChannels,
+      Pointer<Float> corners,
+      Int32 outWidth,
+      Int32 outHeight,
+      Pointer<_EncodeOptionsNative> options,
+    );
+
+typedef _RectifyPaperEncodedDart =
+    _EncodedImageNative Function(
+      Pointer<_ImageBufferNative> buffer,
+      Pointer<Uint8> imageData,
+      int imageWidth,
+      int imageHeight,
+      int imageChannels,
+      Pointer<Float> corners,
+      int outWidth,
+      int outHeight,
+      Pointer<_EncodeOptionsNative> options,
+    );
+
+typedef _ImageBufferCreateNative = Pointer<_ImageBufferNative> Function();
+
+typedef _ImageBufferCreateDart = _ImageBufferCreateNative;
+
+typedef _RectifierCreateNative = Pointer<_RectifierNative> Function(Pointer<_RectifierConfigNative> config);
+
+typedef _RectifierCreateDart = _RectifierCreateNative;
+
+typedef _RectifierDestroyNative = Void Function(Pointer<_RectifierNative> rectifier);
+
+typedef _RectifierDestroyDart = void Function(Pointer<_RectifierNative> rectifier);
+
+typedef _RectifierRectifyNative =
+    Int32 Function(
+      Pointer<_RectifierNative> rectifier,
+      Pointer<Uint8> imageData,
+      Int32 imageWidth,
+      Int32 imageHeight,
+      Int32 imageChannels,
+      Pointer<Float> corners,
+      Int32 outWidth,
+      Int32 outHeight,
+      Pointer<Uint8> outData,
+    );
+
+typedef _RectifierRectifyDart =
+    int Function(
+      Pointer<_RectifierNative> rectifier,
+      Pointer<Uint8> imageData,
+      int imageWidth,
+      int imageHeight,
+      int imageChannels,
+      Pointer<Float> corners,
+      int outWidth,
+      int outHeight,
+      Pointer<Uint8> outData,
+    );
+
 // ============================================================================
 // Paper Detector
 // ============================================================================
@@ -133,6 +452,23 @@ class PaperDetector {
   DynamicLibrary? _lib;
   _DetectPaperDart? _detectPaper;
   _DetectPaperEncodedDart? _detectPaperEncoded;
+  _DetectPaperEncodedExDart? _detectPaperEncodedEx;
+  _DetectPaperFileDart? _detectPaperFile;
+  _DetectPapersDart? _detectPapers;
+  _TrackerCreateDart? _trackerCreate;
+  _TrackerResetDart? _trackerReset;
+  _TrackerUpdateDart? _trackerUpdate;
+  _TrackerUpdateAtDart? _trackerUpdateAt;
+  _RectifyPaperDart? _rectifyPaper;
+  _RectifyPaperEncodedDart? _rectifyPaperEncoded;
+  Pointer<_ImageBufferNative> _encodeBuffer = nullptr;
+  _RectifierCreateDart? _rectifierCreate;
+  _RectifierDestroyDart? _rectifierDestroy;
+  _RectifierDestroyDart? _rectifierReset;
+  _RectifierRectifyDart? _rectifierRectify;
+  NativeFinalizer? _rectifierFinalizer;
+  NativeFinalizer? _trackerFinalizer;
+  void Function(Pointer<_PaperTrackerNative>)? _trackerDestroy;
   String? _loadError;
 
   PaperDetector._() {
@@ -164,6 +500,79 @@ class PaperDetector {
     } catch (e) {
       print('[PaperDetector] Function hg_detect_paper_encoded not found: $e');
     }
+
+    try {
+      _detectPaperEncodedEx = lib.lookupFunction<_DetectPaperEncodedExNative, _DetectPaperEncodedExDart>(
+        'hg_detect_paper_encoded_ex',
+      );
+      print('[PaperDetector] Function hg_detect_paper_encoded_ex found');
+    } catch (e) {
+      print('[PaperDetector] Function hg_detect_paper_encoded_ex not found: $e');
+    }
+
+    try {
+      _detectPaperFile = lib.lookupFunction<_DetectPaperFileNative, _DetectPaperFileDart>('hg_detect_paper_file');
+      print('[PaperDetector] Function hg_detect_paper_file found');
+    } catch (e) {
+      print('[PaperDetector] Function hg_detect_paper_file not found: $e');
+    }
+
+    try {
+      _detectPapers = lib.lookupFunction<_DetectPapersNative, _DetectPapersDart>('hg_detect_papers');
+      print('[PaperDetector] Function hg_detect_papers found');
+    } catch (e) {
+      print('[PaperDetector] Function hg_detect_papers not found: $e');
+    }
+
+    try {
+      _trackerCreate = lib.lookupFunction<_TrackerCreateNative, _TrackerCreateDart>('hg_paper_tracker_create');
+      _trackerReset = lib.lookupFunction<_TrackerResetNative, _TrackerResetDart>('hg_paper_tracker_reset');
+      _trackerUpdate = lib.lookupFunction<_TrackerUpdateNative, _TrackerUpdateDart>('hg_paper_tracker_update');
+      final destroy = lib.lookup<NativeFunction<_TrackerResetNative>>('hg_paper_tracker_destroy');
+      _trackerDestroy = destroy.asFunction<_TrackerResetDart>();
+      _trackerFinalizer = NativeFinalizer(destroy.cast());
+      print('[PaperDetector] Paper tracker functions found');
+    } catch (e) {
+      print('[PaperDetector] Paper tracker functions not found: $e');
+    }
+
+    try {
+      _trackerUpdateAt = lib.lookupFunction<_TrackerUpdateAtNative, _TrackerUpdateAtDart>('hg_paper_tracker_update_at');
+      print('[PaperDetector] Function hg_paper_tracker_update_at found');
+    } catch (e) {
+      print('[PaperDetector] Function hg_paper_tracker_update_at not found: $e');
+    }
+
+    try {
+      _rectifyPaper = lib.lookupFunction<_RectifyPaperNative, _RectifyPaperDart>('hg_rectify_paper');
+      print('[PaperDetector] Function hg_rectify_paper found');
+    } catch (e) {
+      print('[PaperDetector] Function hg_rectify_paper not found: $e');
+    }
+
+    try {
+      _rectifyPaperEncoded = lib.lookupFunction<_RectifyPaperEncodedNative, _RectifyPaperEncodedDart>(
+        'hg_rectify_paper_encoded',
+      );
+      // Encoded pages are copied out after each call; one buffer serves all
+      // calls of this isolate and keeps its capacity for the next export
+      _encodeBuffer = lib.lookupFunction<_ImageBufferCreateNative, _ImageBufferCreateDart>('hg_image_buffer_create')();
+      print('[PaperDetector] Function hg_rectify_paper_encoded found');
+    } catch (e) {
+      print('[PaperDetector] Function hg_rectify_paper_encoded not found: $e');
+    }
+
+    try {
+      _rectifierCreate = lib.lookupFunction<_RectifierCreateNative, _RectifierCreateDart>('hg_rectifier_create');
+      _rectifierReset = lib.lookupFunction<_RectifierDestroyNative, _RectifierDestroyDart>('hg_rectifier_reset');
+      _rectifierRectify = lib.lookupFunction<_RectifierRectifyNative, _RectifierRectifyDart>('hg_rectifier_rectify');
+      final destroy = lib.lookup<NativeFunction<_RectifierDestroyNative>>('hg_rectifier_destroy');
+      _rectifierDestroy = destroy.asFunction<_RectifierDestroyDart>();
+      _rectifierFinalizer = NativeFinalizer(destroy.cast());
+      print('[PaperDetector] Rectifier functions found');
+    } catch (e) {
+      print('[PaperDetector] Rectifier functions not found: $e');
+    }
   }
 
   static DynamicLibrary _loadLibrary() {
@@ -241,14 +650,76 @@ class PaperDetector {
     }
   }
 
+  /// Detect several papers in raw image data
+  ///
+  /// [imageData] - Raw pixel data (RGB, RGBA, or grayscale)
+  /// [width] - Image width in pixels
+  /// [height] - Image height in pixels
+  /// [channels] - Number of channels (1, 3, or 4)
+  /// [maxPapers] - Maximum number of papers to return
+  /// [config] - Detection configuration (optional)
+  ///
+  /// Edges and contours are extracted once for all papers. Returns up to
+  /// [maxPapers] non-overlapping papers, best score first (empty if none).
+  List<PaperDetectionResult> detectPapers({
+    required Uint8List imageData,
+    required int width,
+    required int height,
+    required int channels,
+    int maxPapers = 4,
+    PaperDetectionConfig? config,
+  }) {
+    final func = _detectPapers;
+    if (func == null || maxPapers <= 0) {
+      print('[PaperDetector] Native function not available');
+      return const [];
+    }
+
+    final imagePtr = malloc<Uint8>(imageData.length);
+    final resultsPtr = malloc<_PaperDetectionResultNative>(maxPapers);
+    Pointer<_PaperDetectionConfigNative>? configPtr;
+
+    try {
+      imagePtr.asTypedList(imageData.length).setAll(0, imageData);
+
+      // Create config if provided
+      if (config != null) {
+        configPtr = malloc<_PaperDetectionConfigNative>();
+        _fillConfigNative(configPtr.ref, config);
+      }
+
+      final count = func(imagePtr, width, height, channels, configPtr ?? nullptr, resultsPtr, maxPapers);
+
+      return [for (int i = 0; i < count; i++) _convertResult(resultsPtr[i], config?.focalLength ?? 0)];
+    } finally {
+      malloc.free(imagePtr);
+      malloc.free(resultsPtr);
+      if (configPtr != null) {
+        malloc.free(configPtr);
+      }
+    }
+  }
+
   /// Detect paper in encoded image (JPEG/PNG)
   ///
   /// [imageBytes] - Encoded image bytes
   /// [config] - Detection configuration (optional)
+  /// [maxDecodeDimension] - Decode at most this many pixels per side (0 = full
+  ///   resolution). JPEGs are downscaled while decoding; results are still
+  ///   returned in original image pixels.
+  /// [deferExifOrientation] - Decode JPEG pixels as stored and apply the EXIF
+  ///   orientation to the results instead, avoiding a full-frame rotation.
+  ///   Results are in displayed orientation either way.
   ///
   /// Returns [PaperDetectionResult] with detection results
-  PaperDetectionResult detectPaperEncoded({required Uint8List imageBytes, PaperDetectionConfig? config}) {
+  PaperDetectionResult detectPaperEncoded({
+    required Uint8List imageBytes,
+    PaperDetectionConfig? config,
+    int maxDecodeDimension = 0,
+    bool deferExifOrientation = false,
+  }) {
     final func = _detectPaperEncoded;
+    final funcEx = _detectPaperEncodedEx;
     if (func == null) {
       print('[PaperDetector] Native function not available');
       return PaperDetectionResult.invalid();
@@ -256,6 +727,7 @@ class PaperDetector {
 
     final imagePtr = malloc<Uint8>(imageBytes.length);
     Pointer<_PaperDetectionConfigNative>? configPtr;
+    Pointer<_DecodeOptionsNative>? optionsPtr;
 
     try {
       // Copy image data
@@ -269,7 +741,15 @@ class PaperDetector {
         _fillConfigNative(configPtr.ref, config);
       }
 
-      final result = func(imagePtr, imageBytes.length, configPtr ?? nullptr);
+      final _PaperDetectionResultNative result;
+      if ((maxDecodeDimension > 0 || deferExifOrientation) && funcEx != null) {
+        optionsPtr = malloc<_DecodeOptionsNative>();
+        optionsPtr.ref.maxDimension = maxDecodeDimension;
+        optionsPtr.ref.deferOrientation = deferExifOrientation ? 1 : 0;
+        result = funcEx(imagePtr, imageBytes.length, configPtr ?? nullptr, optionsPtr);
+      } else {
+        result = func(imagePtr, imageBytes.length, configPtr ?? nullptr);
+      }
 
       return _convertResult(result, config?.focalLength ?? 0);
     } finally {
@@ -277,6 +757,187 @@ class PaperDetector {
       if (configPtr != null) {
         malloc.free(configPtr);
       }
+      if (optionsPtr != null) {
+        malloc.free(optionsPtr);
+      }
+    }
+  }
+
+  /// Detect paper in an encoded image file (JPEG/PNG)
+  ///
+  /// The file is memory-mapped and decoded natively, so its bytes are never
+  /// loaded into Dart memory. With a native library that predates
+  /// hg_detect_paper_file, the file is read in Dart and passed to
+  /// [detectPaperEncoded] instead.
+  ///
+  /// [path] - Path of the image file
+  /// [config] - Detection configuration (optional)
+  /// [maxDecodeDimension] - Decode at most this many pixels per side (0 = full resolution)
+  /// [deferExifOrientation] - Apply the JPEG EXIF orientation to the results
+  ///   instead of rotating the decoded pixels
+  ///
+  /// Returns [PaperDetectionResult] with detection results
+  PaperDetectionResult detectPaperFile({
+    required String path,
+    PaperDetectionConfig? config,
+    int maxDecodeDimension = 0,
+    bool deferExifOrientation = false,
+  }) {
+    final func = _detectPaperFile;
+    if (func == null) {
+      final file = File(path);
+      if (!file.existsSync()) return PaperDetectionResult.invalid();
+      return detectPaperEncoded(
+        imageBytes: file.readAsBytesSync(),
+        config: config,
+        maxDecodeDimension: maxDecodeDimension,
+        deferExifOrientation: deferExifOrientation,
+      );
+    }
+
+    final pathPtr = path.toNativeUtf8();
+    final optionsPtr = malloc<_DecodeOptionsNative>();
+    Pointer<_PaperDetectionConfigNative>? configPtr;
+
+    try {
+      optionsPtr.ref.maxDimension = maxDecodeDimension;
+      optionsPtr.ref.deferOrientation = deferExifOrientation ? 1 : 0;
+
+      if (config != null) {
+        configPtr = malloc<_PaperDetectionConfigNative>();
+        _fillConfigNative(configPtr.ref, config);
+      }
+
+      final result = func(pathPtr, configPtr ?? nullptr, optionsPtr);
+
+      return _convertResult(result, config?.focalLength ?? 0);
+    } finally {
+      malloc.free(pathPtr);
+      malloc.free(optionsPtr);
+      if (configPtr != null) {
+        malloc.free(configPtr);
+      }
+    }
+  }
+
+  /// Warp a detected paper to a flat, fronto-parallel image
+  ///
+  /// [imageData] - Raw pixel data of the frame the paper was detected in
+  /// [width] - Image width in pixels
+  /// [height] - Image height in pixels
+  /// [channels] - Number of channels (1, 3, or 4)
+  /// [corners] - Paper corners in frame pixels, clockwise from top-left
+  ///   (e.g. [PaperDetectionResult.corners])
+  /// [outWidth] - Width of the rectified image
+  /// [outHeight] - Height of the rectified image
+  ///
+  /// The warp runs natively (fixed-point bilinear, multi-threaded). Returns
+  /// the rectified pixels with the frame's channels, or null on failure.
+  Uint8List? rectifyPaper({
+    required Uint8List imageData,
+    required int width,
+    required int height,
+    required int channels,
+    required List<Offset> corners,
+    required int outWidth,
+    required int outHeight,
+  }) {
+    final func = _rectifyPaper;
+    if (func == null || corners.length != 4 || outWidth <= 0 || outHeight <= 0) {
+      print('[PaperDetector] Native function not available');
+      return null;
+    }
+
+    final outLength = outWidth * outHeight * channels;
+    final imagePtr = malloc<Uint8>(imageData.length);
+    final cornersPtr = malloc<Float>(8);
+    final outPtr = malloc<Uint8>(outLength);
+
+    try {
+      imagePtr.asTypedList(imageData.length).setAll(0, imageData);
+      for (int i = 0; i < 4; i++) {
+        cornersPtr[i * 2] = corners[i].dx;
+        cornersPtr[i * 2 + 1] = corners[i].dy;
+      }
+
+      final status = func(imagePtr, width, height, channels, cornersPtr, outWidth, outHeight, outPtr);
+      if (status != 1) return null;
+
+      return Uint8List.fromList(outPtr.asTypedList(outLength));
+    } finally {
+      malloc.free(imagePtr);
+      malloc.free(cornersPtr);
+      malloc.free(outPtr);
+    }
+  }
+
+  /// Warp a detected paper to a flat image and encode it in one native call
+  ///
+  /// Arguments as in [rectifyPaper], plus:
+  /// [format] - JPEG or PNG
+  /// [quality] - JPEG quality 1-100
+  /// [maxDimension] - Downscale so the longer side is at most this many
+  ///   pixels (0 = [outWidth] x [outHeight])
+  /// [grayscale] - Encode a single gray channel
+  /// [binarize] - Black and white output for text (implies [grayscale])
+  ///
+  /// Only the encoded bytes cross the FFI boundary. Returns the encoded
+  /// image, or null on failure.
+  Uint8List? rectifyPaperEncoded({
+    required Uint8List imageData,
+    required int width,
+    required int height,
+    required int channels,
+    required List<Offset> corners,
+    required int outWidth,
+    required int outHeight,
+    RectifiedImageFormat format = RectifiedImageFormat.jpeg,
+    int quality = 90,
+    int maxDimension = 0,
+    bool grayscale = false,
+    bool binarize = false,
+  }) {
+    final func = _rectifyPaperEncoded;
+    if (func == null || _encodeBuffer == nullptr || corners.length != 4) {
+      print('[PaperDetector] Native function not available');
+      return null;
+    }
+
+    final imagePtr = malloc<Uint8>(imageData.length);
+    final cornersPtr = malloc<Float>(8);
+    final optionsPtr = malloc<_EncodeOptionsNative>();
+
+    try {
+      imagePtr.asTypedList(imageData.length).setAll(0, imageData);
+      for (int i = 0; i < 4; i++) {
+        cornersPtr[i * 2] = corners[i].dx;
+        cornersPtr[i * 2 + 1] = corners[i].dy;
+      }
+      optionsPtr.ref
+        ..format = format.index
+        ..quality = quality
+        ..maxDimension = maxDimension
+        ..grayscale = grayscale ? 1 : 0
+        ..binarize = binarize ? 1 : 0;
+
+      final result = func(
+        _encodeBuffer,
+        imagePtr,
+        width,
+        height,
+        channels,
+        cornersPtr,
+        outWidth,
+        outHeight,
+        optionsPtr,
+      );
+      if (result.status != 1) return null;
+
+      return Uint8List.fromList(result.data.asTypedList(result.size));
+    } finally {
+      malloc.free(imagePtr);
+      malloc.free(cornersPtr);
+      malloc.free(optionsPtr);
     }
   }
 
@@ -293,6 +954,19 @@ class PaperDetector {
     native.focalLength = config.focalLength;
     native.cx = config.cx;
     native.cy = config.cy;
+    native.streamBandRows = config.streamBandRows;
+    native.streamEdgeDownscale = config.streamEdgeDownscale;
+    native.coarseMaxDimension = config.coarseMaxDimension;
+    native.edgeMethod = config.edgeMethod.index;
+    native.quadMethod = config.quadMethod.index;
+    native.cannyHypotheses = config.cannyHypotheses;
+    native.cannyHypothesisScale = config.cannyHypothesisScale;
+    native.poseMethod = config.poseMethod.index;
+    native.distK1 = config.distK1;
+    native.distK2 = config.distK2;
+    native.distP1 = config.distP1;
+    native.distP2 = config.distP2;
+    native.distK3 = config.distK3;
   }
 
   PaperDetectionResult _convertResult(_PaperDetectionResultNative native, double focalLength) {
@@ -332,6 +1006,251 @@ class PaperDetector {
   }
 }
 
+// ============================================================================
+// Paper Tracker
+// ============================================================================
+
+/// Paper tracking session for live camera frames
+///
+/// Keeps the quad found in the previous frame natively, so subsequent frames
+/// only search a region around it (with a periodic full-frame scan). Call
+/// [dispose] when done; the native session is also freed on garbage collection.
+class PaperTracker implements Finalizable {
+  final PaperDetector _detector;
+  final PaperDetectionConfig? _config;
+  final double _focalLength;
+  Pointer<_PaperTrackerNative> _handle = nullptr;
+
+  /// Create a tracking session
+  ///
+  /// [config] - Detection configuration (optional)
+  /// [roiMargin] - Margin around the previous quad's bounding box, as a
+  ///   fraction of its larger side
+  /// [fullScanInterval] - Search the whole frame every N frames
+  /// [snapTracking] - Snap the previous quad to the new frame's edges before
+  ///   running edge detection (sub-millisecond when the fit holds)
+  /// [snapSearchRadius] - How far (pixels) each side may move between frames
+  /// [snapMinSupport] - Minimum fraction of edge samples found on every side
+  /// [snapMaxResidual] - Maximum RMS line-fit residual in pixels
+  /// [filterCorners] - Return One-Euro filtered corners and search around the
+  ///   filter's prediction (replaces a separate [CornerFilter])
+  /// [filterMinCutoff] - Filter cutoff frequency at rest (Hz)
+  /// [filterBeta] - Filter cutoff increase per pixel/second of corner speed
+  /// [filterFrameRate] - Frame rate assumed for frames passed without a timestamp
+  /// [seedPose] - Start the iterative pose solver from the previous frame's
+  ///   pose (faster convergence while tracking)
+  PaperTracker({
+    PaperDetectionConfig? config,
+    double roiMargin = 0.15,
+    int fullScanInterval = 15,
+    bool snapTracking = false,
+    double snapSearchRadius = 12,
+    double snapMinSupport = 0.6,
+    double snapMaxResidual = 1.5,
+    bool filterCorners = false,
+    double filterMinCutoff = 1.0,
+    double filterBeta = 0.01,
+    double filterFrameRate = 30,
+    bool seedPose = true,
+  }) : _detector = PaperDetector.instance,
+      _config = config,
+      _focalLength = config?.focalLength ?? 0 {
+    final create = _detector._trackerCreate;
+    if (create == null) {
+      print('[PaperTracker] Native function not available');
+      return;
+    }
+
+    final trackerConfigPtr = malloc<_TrackerConfigNative>();
+    Pointer<_PaperDetectionConfigNative>? configPtr;
+    try {
+      trackerConfigPtr.ref.roiMargin = roiMargin;
+      trackerConfigPtr.ref.fullScanInterval = fullScanInterval;
+      trackerConfigPtr.ref.snapTracking = snapTracking ? 1 : 0;
+      trackerConfigPtr.ref.snapSearchRadius = snapSearchRadius;
+      trackerConfigPtr.ref.snapMinSupport = snapMinSupport;
+      trackerConfigPtr.ref.snapMaxResidual = snapMaxResidual;
+      trackerConfigPtr.ref.filterCorners = filterCorners ? 1 : 0;
+      trackerConfigPtr.ref.filterMinCutoff = filterMinCutoff;
+      trackerConfigPtr.ref.filterBeta = filterBeta;
+      trackerConfigPtr.ref.filterFrameRate = filterFrameRate;
+      trackerConfigPtr.ref.seedPose = seedPose ? 1 : 0;
+
+      if (config != null) {
+        configPtr = malloc<_PaperDetectionConfigNative>();
+        _detector._fillConfigNative(configPtr.ref, config);
+      }
+
+      _handle = create(configPtr ?? nullptr, trackerConfigPtr);
+      if (_handle != nullptr) {
+        _detector._trackerFinalizer?.attach(this, _handle.cast(), detach: this);
+      }
+    } finally {
+      malloc.free(trackerConfigPtr);
+      if (configPtr != null) {
+        malloc.free(configPtr);
+      }
+    }
+  }
+
+  /// Whether the native session exists
+  ///
+  /// Without it, [update] falls back to [PaperDetector.detectPaper] on every
+  /// frame (no region search or filtering).
+  bool get isAvailable => _handle != nullptr;
+
+  /// Detect paper in the next frame
+  ///
+  /// [imageData] - Raw pixel data (RGB, RGBA, or grayscale)
+  /// [width] - Image width in pixels
+  /// [height] - Image height in pixels
+  /// [channels] - Number of channels (1, 3, or 4)
+  /// [timestamp] - Frame capture time (optional; frames are assumed to arrive
+  ///   at `filterFrameRate` otherwise). Pass it when frames can be dropped, so
+  ///   the corner filter predicts and smooths over the real time between frames.
+  ///
+  /// Returns [PaperDetectionResult] in frame coordinates
+  PaperDetectionResult update({
+    required Uint8List imageData,
+    required int width,
+    required int height,
+    required int channels,
+    Duration? timestamp,
+  }) {
+    final func = _detector._trackerUpdate;
+    final funcAt = timestamp != null ? _detector._trackerUpdateAt : null;
+    if (func == null || _handle == nullptr) {
+      return _detector.detectPaper(
+        imageData: imageData,
+        width: width,
+        height: height,
+        channels: channels,
+        config: _config,
+      );
+    }
+
+    final imagePtr = malloc<Uint8>(imageData.length);
+    try {
+      imagePtr.asTypedList(imageData.length).setAll(0, imageData);
+      final result = funcAt != null && timestamp != null
+          ? funcAt(_handle, imagePtr, width, height, channels,
+              timestamp.inMicroseconds / Duration.microsecondsPerSecond)
+          : func(_handle, imagePtr, width, height, channels);
+      return _detector._convertResult(result, _focalLength);
+    } finally {
+      malloc.free(imagePtr);
+    }
+  }
+
+  /// Forget the tracked quad; the next frame is searched in full
+  void reset() {
+    if (_handle != nullptr) {
+      _detector._trackerReset?.call(_handle);
+    }
+  }
+
+  /// Free the native session
+  void dispose() {
+    if (_handle == nullptr) return;
+    _detector._trackerFinalizer?.detach(this);
+    _detector._trackerDestroy?.call(_handle);
+    _handle = nullptr;
+  }
+}
+
+/// Rectification session for live preview
+///
+/// Warps the tracked paper of consecutive frames like
+/// [PaperDetector.rectifyPaper], but keeps the native remap tables between
+/// frames and only rebuilds the parts of the page that moved. Call
+/// [dispose] when done (a finalizer frees the session otherwise).
+class PaperRectifier implements Finalizable {
+  final PaperDetector _detector;
+  Pointer<_RectifierNative> _handle = nullptr;
+
+  /// Create a rectification session
+  ///
+  /// [reuseTolerance] - Reuse the tables of a part of the page while the new
+  ///   corners sample within this many source pixels of the old ones
+  PaperRectifier({double reuseTolerance = 0.25}) : _detector = PaperDetector.instance {
+    final create = _detector._rectifierCreate;
+    if (create == null) {
+      print('[PaperRectifier] Native function not available');
+      return;
+    }
+
+    final configPtr = malloc<_RectifierConfigNative>();
+    try {
+      configPtr.ref.reuseTolerance = reuseTolerance;
+      _handle = create(configPtr);
+      if (_handle != nullptr) {
+        _detector._rectifierFinalizer?.attach(this, _handle.cast(), detach: this);
+      }
+    } finally {
+      malloc.free(configPtr);
+    }
+  }
+
+  /// Whether the native session exists
+  bool get isAvailable => _handle != nullptr;
+
+  /// Warp the paper of the next frame
+  ///
+  /// Arguments as in [PaperDetector.rectifyPaper]. Returns the rectified
+  /// pixels, or null on failure.
+  Uint8List? rectify({
+    required Uint8List imageData,
+    required int width,
+    required int height,
+    required int channels,
+    required List<Offset> corners,
+    required int outWidth,
+    required int outHeight,
+  }) {
+    final func = _detector._rectifierRectify;
+    if (func == null || _handle == nullptr || corners.length != 4 || outWidth <= 0 || outHeight <= 0) {
+      return null;
+    }
+
+    final outLength = outWidth * outHeight * channels;
+    final imagePtr = malloc<Uint8>(imageData.length);
+    final cornersPtr = malloc<Float>(8);
+    final outPtr = malloc<Uint8>(outLength);
+
+    try {
+      imagePtr.asTypedList(imageData.length).setAll(0, imageData);
+      for (int i = 0; i < 4; i++) {
+        cornersPtr[i * 2] = corners[i].dx;
+        cornersPtr[i * 2 + 1] = corners[i].dy;
+      }
+
+      final status = func(_handle, imagePtr, width, height, channels, cornersPtr, outWidth, outHeight, outPtr);
+      if (status != 1) return null;
+
+      return Uint8List.fromList(outPtr.asTypedList(outLength));
+    } finally {
+      malloc.free(imagePtr);
+      malloc.free(cornersPtr);
+      malloc.free(outPtr);
+    }
+  }
+
+  /// Drop the cached tables; the next frame rebuilds them in full
+  void reset() {
+    if (_handle != nullptr) {
+      _detector._rectifierReset?.call(_handle);
+    }
+  }
+
+  /// Free the native session
+  void dispose() {
+    if (_handle == nullptr) return;
+    _detector._rectifierFinalizer?.detach(this);
+    _detector._rectifierDestroy?.call(_handle);
+    _handle = nullptr;
+  }
+}
+
 /// Convenience function to detect paper in raw image data
 ///
 /// Uses [PaperDetector.instance] singleton
@@ -351,9 +1270,113 @@ PaperDetectionResult detectPaper({
   );
 }
 
+/// Convenience function to detect several papers in raw image data
+///
+/// Uses [PaperDetector.instance] singleton
+List<PaperDetectionResult> detectPapers({
+  required Uint8List imageData,
+  required int width,
+  required int height,
+  required int channels,
+  int maxPapers = 4,
+  PaperDetectionConfig? config,
+}) {
+  return PaperDetector.instance.detectPapers(
+    imageData: imageData,
+    width: width,
+    height: height,
+    channels: channels,
+    maxPapers: maxPapers,
+    config: config,
+  );
+}
+
 /// Convenience function to detect paper in encoded image
 ///
 /// Uses [PaperDetector.instance] singleton
-PaperDetectionResult detectPaperEncoded({required Uint8List imageBytes, PaperDetectionConfig? config}) {
-  return PaperDetector.instance.detectPaperEncoded(imageBytes: imageBytes, config: config);
+PaperDetectionResult detectPaperEncoded({
+  required Uint8List imageBytes,
+  PaperDetectionConfig? config,
+  int maxDecodeDimension = 0,
+  bool deferExifOrientation = false,
+}) {
+  return PaperDetector.instance.detectPaperEncoded(
+    imageBytes: imageBytes,
+    config: config,
+    maxDecodeDimension: maxDecodeDimension,
+    deferExifOrientation: deferExifOrientation,
+  );
+}
+
+/// Convenience function to detect paper in an encoded image file
+///
+/// Uses [PaperDetector.instance] singleton
+PaperDetectionResult detectPaperFile({
+  required String path,
+  PaperDetectionConfig? config,
+  int maxDecodeDimension = 0,
+  bool deferExifOrientation = false,
+}) {
+  return PaperDetector.instance.detectPaperFile(
+    path: path,
+    config: config,
+    maxDecodeDimension: maxDecodeDimension,
+    deferExifOrientation: deferExifOrientation,
+  );
+}
+
+/// Convenience function to warp a detected paper to a flat image
+///
+/// Uses [PaperDetector.instance] singleton
+Uint8List? rectifyPaper({
+  required Uint8List imageData,
+  required int width,
+  required int height,
+  required int channels,
+  required List<Offset> corners,
+  required int outWidth,
+  required int outHeight,
+}) {
+  return PaperDetector.instance.rectifyPaper(
+    imageData: imageData,
+    width: width,
+    height: height,
+    channels: channels,
+    corners: corners,
+    outWidth: outWidth,
+    outHeight: outHeight,
+  );
+}
+
+/// Convenience function to warp a detected paper and encode it
+///
+/// Uses [PaperDetector.instance] singleton
+Uint8List? rectifyPaperEncoded({
+  required Uint8List imageData,
+  required int width,
+  required int height,
+  required int channels,
+  required List<Offset> corners,
+  required int outWidth,
+  required int outHeight,
+  RectifiedImageFormat format = RectifiedImageFormat.jpeg,
+  int quality = 90,
+  int maxDimension = 0,
+  bool grayscale = false,
+  bool binarize = false,
+}) {
+  return PaperDetector.instance.rectifyPaperEncoded(
+    imageData: imageData,
+    width: width,
+    height: height,
+    channels: channels,
+    corners: corners,
+    outWidth: outWidth,
+    outHeight: outHeight,
+    format: format,
+    quality: quality,
+    maxDimension: maxDimension,
+    grayscale: grayscale,
+    binarize: binarize,
+  );
 }
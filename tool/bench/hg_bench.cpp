@@ -0,0 +1,393 @@
+/**
+ * Benchmark harness for the homography library (Linux)
+ *
+ * Build (against a Linux build of libhomography and OpenCV):
+ *   g++ -O2 -std=c++17 tool/bench/hg_bench.cpp \
+ *       -I ios/homography.xcframework/ios-arm64/Headers \
+ *       -L <dir with libhomography.so> -lhomography \
+ *       $(pkg-config --cflags --libs opencv4) -o hg_bench
+ *
+ * Usage:
+ *   hg_bench homography <anchor> <scene> [options]
+ *   hg_bench paper <image> [options]
+ *
+ * Options:
+ *   --iters N     Number of timed calls (default: 20)
+ *   --warmup N    Number of untimed warm-up calls (default: 3)
+ *   --encoded     Pass encoded file bytes instead of decoded grayscale pixels
+ *   --max-dim N   With --encoded, decode at most N pixels per side
+ *   --defer-orientation  With --encoded, apply EXIF orientation to results instead of pixels
+ *   --edges M     Paper edge extraction: opencv (default), fused or parallel
+ *   --quads M     Paper quad extraction: contours (default), segments or traced
+ *   --papers N    Detect up to N papers per image with hg_detect_papers
+ *   --hypotheses N  Try N Canny threshold pairs on shared gradients
+ *   --rectify WxH Detect once, then time hg_rectify_paper into a WxH image
+ *   --session     With --rectify, use an HgRectifier (corners jitter by 0.1 px per call)
+ *   --encode F    With --rectify, time hg_rectify_paper_encoded to jpg, png or bw (binarized png)
+ *   --points N    Find the homography once, then time mapping N points through it and back
+ *   --soa         With --points, store x and y in separate halves instead of interleaved
+ *   --perf        Read hardware counters (perf_event_open) around each stage
+ *   --allocs      Count allocations, allocated bytes and peak live bytes per call
+ *   --threads N   OpenCV thread count (0 = single-threaded, recommended with --perf)
+ *   --quiet       Print only the summary
+ */
+
+#include "homography_api.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+struct BenchOptions
+{
+    int iters = 20;
+    int warmup = 3;
+    bool encoded = false;
+    int max_dimension = 0;
+    bool defer_orientation = false;
+    int edge_method = HG_EDGE_OPENCV;
+    int quad_method = HG_QUAD_CONTOURS;
+    int max_papers = 0;
+    int canny_hypotheses = 1;
+    int rectify_width = 0;
+    int rectify_height = 0;
+    bool rectify_session = false;
+    std::string rectify_encode;
+    int points = 0;
+    bool points_soa = false;
+    bool perf = false;
+    bool allocs = false;
+    bool quiet = false;
+    int threads = -1;
+};
+
+static std::vector<uint8_t> read_file(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void print_usage()
+{
+    std::fprintf(stderr,
+                 "Usage:\n"
+                 "  hg_bench homography <anchor> <scene> [options]\n"
+                 "  hg_bench paper <image> [options]\n"
+                 "Options: --iters N --warmup N --encoded --max-dim N --defer-orientation --edges opencv|fused|parallel --quads contours|segments|traced --papers N --hypotheses N --rectify WxH --session --encode jpg|png|bw --points N --soa --perf --allocs --threads N --quiet\n");
+}
+
+static void print_call_stats(int iter, int status, const HgCallStats &stats)
+{
+    std::printf("call %3d  status %2d  total %8.3f ms", iter, status, stats.total_ms);
+    if (stats.counters_mask & HG_COUNTER_ALLOCATIONS)
+        std::printf("  allocs %llu  bytes %llu  peak %llu",
+                    static_cast<unsigned long long>(stats.alloc_count),
+                    static_cast<unsigned long long>(stats.alloc_bytes),
+                    static_cast<unsigned long long>(stats.peak_bytes));
+    if (stats.dropped_stages > 0)
+        std::printf("  dropped stages %d", stats.dropped_stages);
+    std::printf("\n");
+
+    for (int i = 0; i < stats.num_stages; i++)
+    {
+        const HgStageStats &stage = stats.stages[i];
+        std::printf("  %-12s %8.3f ms", stage.name, stage.wall_ms);
+
+        if (stats.counters_mask & HG_COUNTER_CYCLES)
+            std::printf("  cyc %12llu", static_cast<unsigned long long>(stage.cycles));
+        if (stats.counters_mask & HG_COUNTER_INSTRUCTIONS)
+            std::printf("  ins %12llu", static_cast<unsigned long long>(stage.instructions));
+        if ((stats.counters_mask & HG_COUNTER_CYCLES) && (stats.counters_mask & HG_COUNTER_INSTRUCTIONS))
+            std::printf("  ipc %5.2f", stage.cycles ? static_cast<double>(stage.instructions) / stage.cycles : 0.0);
+        if (stats.counters_mask & HG_COUNTER_L1D_MISSES)
+            std::printf("  l1d %10llu", static_cast<unsigned long long>(stage.l1d_misses));
+        if (stats.counters_mask & HG_COUNTER_LLC_MISSES)
+            std::printf("  llc %10llu", static_cast<unsigned long long>(stage.llc_misses));
+        if (stats.counters_mask & HG_COUNTER_BRANCH_MISSES)
+            std::printf("  br %10llu", static_cast<unsigned long long>(stage.branch_misses));
+
+        std::printf("\n");
+    }
+}
+
+static void print_summary(std::vector<double> totals, uint64_t max_peak_bytes)
+{
+    if (totals.empty())
+        return;
+
+    std::sort(totals.begin(), totals.end());
+    double sum = 0;
+    for (double t : totals)
+        sum += t;
+
+    std::printf("calls %zu  min %.3f ms  median %.3f ms  mean %.3f ms  max %.3f ms\n",
+                totals.size(), totals.front(), totals[totals.size() / 2],
+                sum / totals.size(), totals.back());
+    if (max_peak_bytes > 0)
+        std::printf("max peak live bytes %llu\n", static_cast<unsigned long long>(max_peak_bytes));
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        print_usage();
+        return 1;
+    }
+
+    const std::string mode = argv[1];
+    const int num_inputs = (mode == "homography") ? 2 : (mode == "paper") ? 1 : 0;
+    if (num_inputs == 0 || argc < 2 + num_inputs)
+    {
+        print_usage();
+        return 1;
+    }
+
+    BenchOptions opts;
+    for (int i = 2 + num_inputs; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--iters" && i + 1 < argc)
+            opts.iters = std::atoi(argv[++i]);
+        else if (arg == "--warmup" && i + 1 < argc)
+            opts.warmup = std::atoi(argv[++i]);
+        else if (arg == "--max-dim" && i + 1 < argc)
+            opts.max_dimension = std::atoi(argv[++i]);
+        else if (arg == "--edges" && i + 1 < argc)
+        {
+            const std::string method = argv[++i];
+            opts.edge_method = method == "parallel" ? HG_EDGE_PARALLEL : method == "fused" ? HG_EDGE_FUSED : HG_EDGE_OPENCV;
+        }
+        else if (arg == "--quads" && i + 1 < argc)
+        {
+            const std::string method = argv[++i];
+            opts.quad_method = method == "segments" ? HG_QUAD_SEGMENTS : method == "traced" ? HG_QUAD_TRACED : HG_QUAD_CONTOURS;
+        }
+        else if (arg == "--papers" && i + 1 < argc)
+            opts.max_papers = std::atoi(argv[++i]);
+        else if (arg == "--hypotheses" && i + 1 < argc)
+            opts.canny_hypotheses = std::atoi(argv[++i]);
+        else if (arg == "--rectify" && i + 1 < argc)
+        {
+            if (std::sscanf(argv[++i], "%dx%d", &opts.rectify_width, &opts.rectify_height) != 2)
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+            opts.threads = std::atoi(argv[++i]);
+        else if (arg == "--encode" && i + 1 < argc)
+            opts.rectify_encode = argv[++i];
+        else if (arg == "--session")
+            opts.rectify_session = true;
+        else if (arg == "--points" && i + 1 < argc)
+            opts.points = std::atoi(argv[++i]);
+        else if (arg == "--soa")
+            opts.points_soa = true;
+        else if (arg == "--encoded")
+            opts.encoded = true;
+        else if (arg == "--defer-orientation")
+            opts.defer_orientation = true;
+        else if (arg == "--perf")
+            opts.perf = true;
+        else if (arg == "--allocs")
+            opts.allocs = true;
+        else if (arg == "--quiet")
+            opts.quiet = true;
+        else
+        {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (opts.threads >= 0)
+        cv::setNumThreads(opts.threads);
+
+    if (opts.perf && !hg_set_perf_counters_enabled(1))
+        std::fprintf(stderr, "hardware counters are not supported on this platform\n");
+
+    if (opts.allocs && !hg_set_alloc_tracking_enabled(1))
+        std::fprintf(stderr, "library built without HG_ENABLE_ALLOC_TRACKING: counting OpenCV buffers only\n");
+
+    // Load inputs once; each call then measures only library work
+    std::vector<std::vector<uint8_t>> encoded(num_inputs);
+    std::vector<cv::Mat> gray(num_inputs);
+    for (int i = 0; i < num_inputs; i++)
+    {
+        const char *path = argv[2 + i];
+        if (opts.encoded)
+        {
+            encoded[i] = read_file(path);
+            if (encoded[i].empty())
+            {
+                std::fprintf(stderr, "failed to read %s\n", path);
+                return 1;
+            }
+        }
+        else
+        {
+            gray[i] = cv::imread(path, cv::IMREAD_GRAYSCALE);
+            if (gray[i].empty())
+            {
+                std::fprintf(stderr, "failed to decode %s\n", path);
+                return 1;
+            }
+        }
+    }
+
+    PaperDetectionConfig config = hg_default_paper_config();
+    config.edge_method = opts.edge_method;
+    config.quad_method = opts.quad_method;
+    config.canny_hypotheses = opts.canny_hypotheses;
+    HgDecodeOptions decode_options = hg_default_decode_options();
+    decode_options.max_dimension = opts.max_dimension;
+    decode_options.defer_orientation = opts.defer_orientation ? 1 : 0;
+
+    std::vector<PaperDetectionResult> papers(std::max(opts.max_papers, 0));
+    if (opts.max_papers > 0 && opts.encoded)
+    {
+        std::fprintf(stderr, "--papers takes decoded pixels and cannot be combined with --encoded\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> rectified;
+    PaperDetectionResult rectify_paper = {};
+    if (opts.rectify_width > 0 && opts.rectify_height > 0)
+    {
+        if (mode != "paper" || opts.encoded)
+        {
+            std::fprintf(stderr, "--rectify takes a decoded paper image and cannot be combined with --encoded\n");
+            return 1;
+        }
+
+        rectify_paper = hg_detect_paper(gray[0].data, gray[0].cols, gray[0].rows, 1, &config);
+        if (rectify_paper.status != 1)
+        {
+            std::fprintf(stderr, "no paper found to rectify\n");
+            return 1;
+        }
+        rectified.resize(static_cast<size_t>(opts.rectify_width) * opts.rectify_height);
+    }
+
+    std::vector<float> points;
+    HomographyResult points_homography = {};
+    if (opts.points > 0)
+    {
+        if (mode != "homography" || opts.encoded)
+        {
+            std::fprintf(stderr, "--points takes a decoded anchor/scene pair and cannot be combined with --encoded\n");
+            return 1;
+        }
+
+        points_homography = hg_find_homography_raw(gray[0].data, gray[0].cols, gray[0].rows, 1,
+                                                   gray[1].data, gray[1].cols, gray[1].rows, 1);
+        if (points_homography.status != 1)
+        {
+            std::fprintf(stderr, "no homography found to map points through\n");
+            return 1;
+        }
+
+        // Uniform grid over the anchor; the layout only changes how x and y are stored
+        points.resize(static_cast<size_t>(opts.points) * 2);
+        for (int i = 0; i < opts.points; i++)
+        {
+            float x = static_cast<float>((i * 7919) % gray[0].cols);
+            float y = static_cast<float>((i * 104729) % gray[0].rows);
+            points[opts.points_soa ? i : i * 2] = x;
+            points[opts.points_soa ? opts.points + i : i * 2 + 1] = y;
+        }
+    }
+    const int points_layout = opts.points_soa ? HG_POINTS_SOA : HG_POINTS_INTERLEAVED;
+    int points_calls = 0;
+
+    HgRectifier *rectifier = opts.rectify_session ? hg_rectifier_create(nullptr) : nullptr;
+    int rectify_calls = 0;
+
+    HgImageBuffer *encode_buffer = opts.rectify_encode.empty() ? nullptr : hg_image_buffer_create();
+    HgEncodeOptions encode_options = hg_default_encode_options();
+    encode_options.format = opts.rectify_encode == "jpg" ? HG_ENCODE_JPEG : HG_ENCODE_PNG;
+    encode_options.binarize = opts.rectify_encode == "bw" ? 1 : 0;
+
+    auto run_once = [&]() -> int
+    {
+        if (!points.empty())
+        {
+            // Alternate directions so the points stay inside the anchor
+            if (points_calls++ % 2 == 0)
+                return hg_transform_points(points_homography.homography, points.data(), points.data(),
+                                           opts.points, points_layout);
+            return hg_transform_points_inverse(points_homography.homography, points.data(), points.data(),
+                                               opts.points, points_layout);
+        }
+        if (!rectified.empty() && encode_buffer != nullptr)
+            return hg_rectify_paper_encoded(encode_buffer, gray[0].data, gray[0].cols, gray[0].rows, 1,
+                                            rectify_paper.corners, opts.rectify_width, opts.rectify_height,
+                                            &encode_options)
+                .status;
+        if (!rectified.empty() && rectifier != nullptr)
+        {
+            // Live-preview jitter, below the default reuse tolerance
+            float corners[8];
+            float jitter = (rectify_calls++ % 2) ? 0.1f : -0.1f;
+            for (int i = 0; i < 8; i++)
+                corners[i] = rectify_paper.corners[i] + jitter;
+            return hg_rectifier_rectify(rectifier, gray[0].data, gray[0].cols, gray[0].rows, 1, corners,
+                                        opts.rectify_width, opts.rectify_height, rectified.data());
+        }
+        if (!rectified.empty())
+            return hg_rectify_paper(gray[0].data, gray[0].cols, gray[0].rows, 1, rectify_paper.corners,
+                                    opts.rectify_width, opts.rectify_height, rectified.data());
+
+        if (mode == "homography")
+        {
+            HomographyResult result = opts.encoded
+                                          ? hg_find_homography_ex(encoded[0].data(), encoded[0].size(),
+                                                                  encoded[1].data(), encoded[1].size(), &decode_options)
+                                          : hg_find_homography_raw(gray[0].data, gray[0].cols, gray[0].rows, 1,
+                                                                   gray[1].data, gray[1].cols, gray[1].rows, 1);
+            return result.status;
+        }
+
+        if (opts.max_papers > 0)
+            return hg_detect_papers(gray[0].data, gray[0].cols, gray[0].rows, 1, &config, papers.data(), opts.max_papers);
+
+        PaperDetectionResult result = opts.encoded
+                                          ? hg_detect_paper_encoded_ex(encoded[0].data(), encoded[0].size(), &config, &decode_options)
+                                          : hg_detect_paper(gray[0].data, gray[0].cols, gray[0].rows, 1, &config);
+        return result.status;
+    };
+
+    for (int i = 0; i < opts.warmup; i++)
+        run_once();
+
+    std::vector<double> totals;
+    uint64_t max_peak_bytes = 0;
+    for (int i = 0; i < opts.iters; i++)
+    {
+        int status = run_once();
+
+        HgCallStats stats;
+        if (hg_get_last_call_stats(&stats) != 1)
+            continue;
+
+        totals.push_back(stats.total_ms);
+        max_peak_bytes = std::max(max_peak_bytes, stats.peak_bytes);
+        if (!opts.quiet)
+            print_call_stats(i, status, stats);
+    }
+
+    print_summary(totals, max_peak_bytes);
+    hg_rectifier_destroy(rectifier);
+    hg_image_buffer_destroy(encode_buffer);
+    return 0;
+}
@@ -0,0 +1,318 @@
+/**
+ * Replays a capture log written by hg_capture_start (Linux)
+ *
+ * Build (against a Linux build of libhomography):
+ *   g++ -O2 -std=c++17 tool/bench/hg_replay.cpp \
+ *       -I ios/homography.xcframework/ios-arm64/Headers \
+ *       -L <dir with libhomography.so> -lhomography -o hg_replay
+ *
+ * Usage:
+ *   hg_replay <capture.log> [options]
+ *
+ * Options:
+ *   --repeat N    Replay each record N times (default: 1)
+ *   --perf        Read hardware counters around each stage
+ *   --stages      Print per-stage timings of every replayed call
+ */
+
+#include "homography_api.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+struct ReplayOptions
+{
+    int repeat = 1;
+    bool perf = false;
+    bool stages = false;
+};
+
+/**
+ * Sequential reader over a record's fields and blobs
+ */
+struct RecordReader
+{
+    const uint8_t *fields;
+    size_t fields_size;
+    size_t fields_pos = 0;
+    const uint8_t *blobs;
+    size_t blobs_size;
+    size_t blobs_pos = 0;
+    bool ok = true;
+
+    template <typename T>
+    T field()
+    {
+        T value = {};
+        if (fields_pos + sizeof(T) > fields_size)
+        {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, fields + fields_pos, sizeof(T));
+        fields_pos += sizeof(T);
+        return value;
+    }
+
+    const uint8_t *blob(size_t size)
+    {
+        if (blobs_pos + size > blobs_size)
+        {
+            ok = false;
+            return nullptr;
+        }
+        const uint8_t *data = blobs + blobs_pos;
+        blobs_pos += size;
+        return data;
+    }
+};
+
+static const char *call_type_name(uint32_t type)
+{
+    switch (type)
+    {
+    case HG_CALL_FIND_HOMOGRAPHY:
+        return "find_homography";
+    case HG_CALL_FIND_HOMOGRAPHY_RAW:
+        return "find_homography_raw";
+    case HG_CALL_FIND_HOMOGRAPHY_FROM_POINTS:
+        return "from_points";
+    case HG_CALL_DETECT_PAPER:
+        return "detect_paper";
+    case HG_CALL_DETECT_PAPER_ENCODED:
+        return "detect_paper_encoded";
+    case HG_CALL_DETECT_PAPERS:
+        return "detect_papers";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * Re-execute one record; returns the call status or INT32_MIN if the record is malformed
+ */
+static int replay_record(uint32_t type, RecordReader &in)
+{
+    HgPose pose;
+    switch (type)
+    {
+    case HG_CALL_FIND_HOMOGRAPHY:
+    {
+        int32_t has_options = in.field<int32_t>();
+        HgDecodeOptions options = in.field<HgDecodeOptions>();
+        int32_t has_intrinsics = in.field<int32_t>();
+        HgCameraIntrinsics intrinsics = in.field<HgCameraIntrinsics>();
+        uint64_t anchor_size = in.field<uint64_t>();
+        uint64_t scene_size = in.field<uint64_t>();
+        const uint8_t *anchor = in.blob(anchor_size);
+        const uint8_t *scene = in.blob(scene_size);
+        if (!in.ok)
+            break;
+        return hg_find_homography_pose(anchor, anchor_size, scene, scene_size,
+                                       has_options ? &options : nullptr,
+                                       has_intrinsics ? &intrinsics : nullptr, &pose)
+            .status;
+    }
+    case HG_CALL_FIND_HOMOGRAPHY_RAW:
+    {
+        int32_t has_intrinsics = in.field<int32_t>();
+        HgCameraIntrinsics intrinsics = in.field<HgCameraIntrinsics>();
+        int32_t aw = in.field<int32_t>(), ah = in.field<int32_t>(), ac = in.field<int32_t>();
+        int32_t sw = in.field<int32_t>(), sh = in.field<int32_t>(), sc = in.field<int32_t>();
+        const uint8_t *anchor = in.blob(static_cast<size_t>(aw) * ah * ac);
+        const uint8_t *scene = in.blob(static_cast<size_t>(sw) * sh * sc);
+        if (!in.ok)
+            break;
+        return hg_find_homography_raw_pose(anchor, aw, ah, ac, scene, sw, sh, sc,
+                                           has_intrinsics ? &intrinsics : nullptr, &pose)
+            .status;
+    }
+    case HG_CALL_FIND_HOMOGRAPHY_FROM_POINTS:
+    {
+        int32_t has_intrinsics = in.field<int32_t>();
+        HgCameraIntrinsics intrinsics = in.field<HgCameraIntrinsics>();
+        int32_t n = in.field<int32_t>(), aw = in.field<int32_t>(), ah = in.field<int32_t>();
+        size_t coords_size = static_cast<size_t>(n) * sizeof(float);
+        const float *x0 = reinterpret_cast<const float *>(in.blob(coords_size));
+        const float *y0 = reinterpret_cast<const float *>(in.blob(coords_size));
+        const float *x1 = reinterpret_cast<const float *>(in.blob(coords_size));
+        const float *y1 = reinterpret_cast<const float *>(in.blob(coords_size));
+        if (!in.ok)
+            break;
+        return hg_find_homography_from_points_pose(x0, y0, x1, y1, n, aw, ah,
+                                                   has_intrinsics ? &intrinsics : nullptr, &pose)
+            .status;
+    }
+    case HG_CALL_DETECT_PAPER:
+    case HG_CALL_DETECT_PAPER_ENCODED:
+    {
+        int32_t has_config = in.field<int32_t>();
+        PaperDetectionConfig config = in.field<PaperDetectionConfig>();
+        const PaperDetectionConfig *config_ptr = has_config ? &config : nullptr;
+
+        if (type == HG_CALL_DETECT_PAPER_ENCODED)
+        {
+            int32_t has_options = in.field<int32_t>();
+            HgDecodeOptions options = in.field<HgDecodeOptions>();
+            uint64_t size = in.field<uint64_t>();
+            const uint8_t *bytes = in.blob(size);
+            if (!in.ok)
+                break;
+            return hg_detect_paper_encoded_ex(bytes, size, config_ptr, has_options ? &options : nullptr).status;
+        }
+
+        int32_t w = in.field<int32_t>(), h = in.field<int32_t>(), c = in.field<int32_t>();
+        const uint8_t *pixels = in.blob(static_cast<size_t>(w) * h * c);
+        if (!in.ok)
+            break;
+        return hg_detect_paper(pixels, w, h, c, config_ptr).status;
+    }
+    case HG_CALL_DETECT_PAPERS:
+    {
+        int32_t has_config = in.field<int32_t>();
+        PaperDetectionConfig config = in.field<PaperDetectionConfig>();
+        int32_t w = in.field<int32_t>(), h = in.field<int32_t>(), c = in.field<int32_t>();
+        int32_t max_results = in.field<int32_t>();
+        const uint8_t *pixels = in.blob(static_cast<size_t>(w) * h * c);
+        if (!in.ok || max_results <= 0)
+            break;
+        std::vector<PaperDetectionResult> results(max_results);
+        return hg_detect_papers(pixels, w, h, c, has_config ? &config : nullptr, results.data(), max_results);
+    }
+    default:
+        break;
+    }
+    return INT32_MIN;
+}
+
+static void print_stages(const HgCallStats &stats)
+{
+    for (int i = 0; i < stats.num_stages; i++)
+    {
+        const HgStageStats &stage = stats.stages[i];
+        std::printf("    %-12s %8.3f ms", stage.name, stage.wall_ms);
+        if (stats.counters_mask & HG_COUNTER_CYCLES)
+            std::printf("  cyc %12llu", static_cast<unsigned long long>(stage.cycles));
+        if (stats.counters_mask & HG_COUNTER_INSTRUCTIONS)
+            std::printf("  ins %12llu", static_cast<unsigned long long>(stage.instructions));
+        if (stats.counters_mask & HG_COUNTER_LLC_MISSES)
+            std::printf("  llc %10llu", static_cast<unsigned long long>(stage.llc_misses));
+        std::printf("\n");
+    }
+    if (stats.dropped_stages > 0)
+        std::printf("    (%d more stages not recorded)\n", stats.dropped_stages);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: hg_replay <capture.log> [--repeat N] [--perf] [--stages]\n");
+        return 1;
+    }
+
+    ReplayOptions opts;
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc)
+            opts.repeat = std::atoi(argv[++i]);
+        else if (arg == "--perf")
+            opts.perf = true;
+        else if (arg == "--stages")
+            opts.stages = true;
+        else
+        {
+            std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return 1;
+        }
+    }
+
+    if (opts.perf)
+        hg_set_perf_counters_enabled(1);
+
+    std::ifstream file(argv[1], std::ios::binary);
+    std::vector<uint8_t> log((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    uint32_t version = 0;
+    const size_t header_size = 8 + sizeof(version);
+    if (log.size() < header_size || std::memcmp(log.data(), HG_CAPTURE_MAGIC, 8) != 0)
+    {
+        std::fprintf(stderr, "%s is not a capture log\n", argv[1]);
+        return 1;
+    }
+    std::memcpy(&version, log.data() + 8, sizeof(version));
+    if (version != HG_CAPTURE_VERSION)
+    {
+        std::fprintf(stderr, "unsupported capture version %u\n", version);
+        return 1;
+    }
+
+    const size_t fixed_size = sizeof(uint32_t) + sizeof(HgCallStats) + sizeof(uint32_t);
+    size_t pos = header_size;
+    int index = 0;
+    double captured_sum = 0, replayed_sum = 0;
+
+    while (pos + sizeof(uint32_t) <= log.size())
+    {
+        uint32_t record_size;
+        std::memcpy(&record_size, log.data() + pos, sizeof(record_size));
+        pos += sizeof(record_size);
+        if (record_size < fixed_size || pos + record_size > log.size())
+        {
+            std::fprintf(stderr, "truncated record %d\n", index);
+            break;
+        }
+
+        const uint8_t *rec = log.data() + pos;
+        uint32_t call_type;
+        HgCallStats captured;
+        uint32_t fields_size;
+        std::memcpy(&call_type, rec, sizeof(call_type));
+        std::memcpy(&captured, rec + 4, sizeof(captured));
+        std::memcpy(&fields_size, rec + 4 + sizeof(captured), sizeof(fields_size));
+        pos += record_size;
+
+        if (fixed_size + fields_size > record_size)
+        {
+            std::fprintf(stderr, "malformed record %d\n", index);
+            break;
+        }
+
+        for (int r = 0; r < opts.repeat; r++)
+        {
+            RecordReader in;
+            in.fields = rec + fixed_size;
+            in.fields_size = fields_size;
+            in.blobs = in.fields + fields_size;
+            in.blobs_size = record_size - fixed_size - fields_size;
+
+            int status = replay_record(call_type, in);
+            if (status == INT32_MIN)
+            {
+                std::fprintf(stderr, "record %d: cannot replay %s\n", index, call_type_name(call_type));
+                break;
+            }
+
+            HgCallStats replayed = {};
+            hg_get_last_call_stats(&replayed);
+            captured_sum += captured.total_ms;
+            replayed_sum += replayed.total_ms;
+
+            std::printf("record %4d  %-22s status %2d  captured %8.3f ms  replayed %8.3f ms\n",
+                        index, call_type_name(call_type), status, captured.total_ms, replayed.total_ms);
+            if (opts.stages)
+                print_stages(replayed);
+        }
+        index++;
+    }
+
+    std::printf("records %d  captured total %.3f ms  replayed total %.3f ms\n", index, captured_sum, replayed_sum);
+    return 0;
+}